@@ -0,0 +1,54 @@
+#include <ClimateUART.h>
+
+climate_uart::transport::UartTransportArduino uartArduino(Serial);
+
+climate_uart::protocols::Mitsubishi my_climate(uartArduino);
+//climate_uart::protocols::DaikinS21 my_climate(uartArduino);
+//climate_uart::protocols::Fujitsu my_climate(uartArduino);
+//climate_uart::protocols::HitachiHLink my_climate(uartArduino);
+//climate_uart::protocols::LgAircon my_climate(uartArduino);
+//climate_uart::protocols::Sharp my_climate(uartArduino);
+//climate_uart::protocols::Toshiba my_climate(uartArduino);
+
+void onStateChanged(const climate_uart::ClimateSettings &settings, void *context) {
+  // Called only when power, mode, setpoint, fan or vane differs from the last observed state
+  (void)settings;
+  (void)context;
+}
+
+void onRoomTemperatureChanged(float temperature, void *context) {
+  // Called only when the room temperature moved by at least the registered threshold
+  (void)temperature;
+  (void)context;
+}
+
+void setup() {
+
+  /*Important note:
+      Do NOT add `Serial.begin(9600)` and do NOT use `Serial.print(...)`.
+      Most climate units require Even or Odd parity, so `climate_uart` must use a hardware serial interface.
+      As a result, this hardware serial cannot be used for debugging or other purposes.
+      Use a software serial for debug output, or use a serial implementation that supports parity.
+  */
+
+  my_climate.onStateChanged(onStateChanged);
+  my_climate.onRoomTemperatureChanged(onRoomTemperatureChanged, 0.5f);
+  my_climate.init();
+}
+
+void loop() {
+  /*
+    Any call that observes a frame from the unit fires the listeners on change,
+    so the application no longer has to diff successive states itself.
+  */
+  my_climate.service();
+  if (!my_climate.isReady()) {
+    return;
+  }
+
+  climate_uart::ClimateSettings settings;
+  float temperature;
+
+  my_climate.getState(settings);
+  my_climate.getRoomTemperature(temperature);
+}
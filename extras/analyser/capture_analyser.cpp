@@ -0,0 +1,287 @@
+// Offline analysis of captures (UartTransportCapture) and debug logs (CLIMATE_LOG_BUFFER hex
+// dumps), one unit per file:
+//
+//   capture_analyser [--protocol=<name>] [--jobs=<n>] [--json] <file>...
+//
+// Each file is memory-mapped, its received bytes scanned for frames with the drivers' own
+// checksums, and the unit reported: frames per second, checksum failures, bytes outside any
+// frame, line occupancy and the latency from the end of each request to the first frame after
+// it. Files are spread over --jobs worker threads (default: one per core); a single capture is
+// scanned by one thread, since its records carry no sync point to split them on.
+// Without --protocol the start of each file is scanned for every protocol and the one that
+// frames the most bytes there scans the whole file. Logs carry no timing and no direction,
+// so they get frame and error counts only.
+
+#include "capture_input.h"
+#include "frame_scan.h"
+
+#include "climate_uart/metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace climate_uart;
+using namespace climate_uart::analyser;
+
+namespace {
+
+// Received bytes the protocol detection looks at: minutes of traffic on any of these buses
+constexpr size_t kDetectBytes = 64 * 1024;
+
+struct Args {
+	const ProtocolScanner *protocol{nullptr};
+	uint32_t jobs{0};
+	bool json{false};
+	std::vector<const char *> paths;
+};
+
+struct UnitReport {
+	const char *path{nullptr};
+	std::string error;
+	const ProtocolScanner *protocol{nullptr};
+	InputFormat format{InputFormat::Capture};
+	bool truncated{false};
+	double seconds{0.0};
+	uint64_t rxBytes{0};
+	double rxBusy{0.0};
+	ScanResult scan;
+	uint32_t requests{0};
+	uint32_t replies{0};
+	std::vector<uint64_t> latenciesUs;
+	LatencyHistogram histogram{};
+};
+
+uint64_t framedBytes(const ScanResult &result) {
+	uint64_t bytes = 0;
+	for (const FrameSpan &frame : result.frames) {
+		bytes += frame.size;
+	}
+	return bytes;
+}
+
+// Nearest-rank percentile of a sorted sample, in milliseconds, as in the latency benchmarks
+double percentileMs(const std::vector<uint64_t> &sorted, uint32_t percent) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	size_t rank = (sorted.size() * percent + 99) / 100;
+	return static_cast<double>(sorted[rank ? rank - 1 : 0]) / 1000.0;
+}
+
+// A request is a write of more than one byte (a lone byte is an ack). Replies are matched to
+// requests in order, as the drivers do for pipelined requests: each frame that starts once the
+// oldest open request has left the wire answers it. On single-wire buses our echo starts
+// before then, so it is never taken for a reply. A request already on the wire when the
+// driver writes again was given up on (timeout, corrupt reply) and stays unanswered.
+void measureLatency(const Session &session, UnitReport &report) {
+	const std::vector<FrameSpan> &frames = report.scan.frames;
+	std::vector<uint64_t> timeUs;
+	frameTimesUs(session, frames, timeUs);
+	std::vector<uint64_t> open;
+	size_t oldest = 0;
+	size_t frame = 0;
+	uint64_t lineFreeUs = 0;
+
+	auto receive = [&](uint64_t frameUs) {
+		if (oldest == open.size() || frameUs < open[oldest]) {
+			return;
+		}
+		uint64_t latencyUs = frameUs - open[oldest++];
+		report.replies++;
+		report.latenciesUs.push_back(latencyUs);
+		uint32_t latencyMs = static_cast<uint32_t>(latencyUs / 1000);
+		report.histogram.counts[LatencyHistogram::bucket(latencyMs)]++;
+		report.histogram.samples++;
+		report.histogram.totalMs += latencyMs;
+		report.histogram.maxMs = std::max(report.histogram.maxMs, latencyMs);
+	};
+
+	for (const TxWrite &write : session.writes) {
+		if (write.size < 2) {
+			continue;
+		}
+		while (frame < frames.size() && timeUs[frame] < write.timeUs) {
+			receive(timeUs[frame++]);
+		}
+		while (oldest < open.size() && open[oldest] <= write.timeUs) {
+			oldest++;
+		}
+		// Back-to-back writes queue behind each other on the line
+		lineFreeUs = std::max(lineFreeUs, write.timeUs) + session.line.wireTimeUs(write.size);
+		open.push_back(lineFreeUs);
+		report.requests++;
+	}
+	while (frame < frames.size()) {
+		receive(timeUs[frame++]);
+	}
+	std::sort(report.latenciesUs.begin(), report.latenciesUs.end());
+}
+
+void analyse(const char *path, const ProtocolScanner *protocol, UnitReport &report) {
+	report.path = path;
+	Session session;
+	if (!loadSession(path, session, report.error)) {
+		return;
+	}
+	report.format = session.format;
+	report.truncated = session.truncated;
+	report.rxBytes = session.rx.bytes.size();
+	report.seconds = static_cast<double>(session.durationUs) / 1e6;
+	if (session.durationUs > 0) {
+		report.rxBusy = static_cast<double>(session.line.wireTimeUs(session.line.bytesReceived)) / session.durationUs;
+	}
+
+	// Captures hold the raw wire bytes, logs what the drivers decoded
+	bool lineCoded = session.format == InputFormat::Capture;
+	if (protocol) {
+		report.protocol = protocol;
+		report.scan = scan(*protocol, session.rx, lineCoded);
+	} else {
+		// Every scanner tries the start of the stream; only the one framing the most of it
+		// scans the whole stream.
+		uint64_t best = 0;
+		for (size_t i = 0; i < scannerCount(); i++) {
+			uint64_t bytes = framedBytes(scan(scanners()[i], session.rx, lineCoded, kDetectBytes));
+			if (!report.protocol || bytes > best) {
+				report.protocol = &scanners()[i];
+				best = bytes;
+			}
+		}
+		report.scan = scan(*report.protocol, session.rx, lineCoded);
+	}
+
+	if (session.format == InputFormat::Capture) {
+		measureLatency(session, report);
+	}
+}
+
+void printTable(const std::vector<UnitReport> &reports) {
+	printf("%-28s %-10s %8s %8s %8s %7s %8s %7s %9s %8s %8s %8s %8s\n", "unit", "protocol", "seconds", "frames",
+		   "frames/s", "crc err", "unframed", "rx busy", "replies", "p50 ms", "p95 ms", "p99 ms", "max ms");
+	for (const UnitReport &r : reports) {
+		if (!r.error.empty()) {
+			printf("%-28s %s\n", r.path, r.error.c_str());
+			continue;
+		}
+		size_t frames = r.scan.frames.size();
+		printf("%-28s %-10s ", r.path, r.protocol->name);
+		if (r.format == InputFormat::HexLog) {
+			printf("%8s %8zu %8s %7u %8llu %7s %9s\n", "log", frames, "-", r.scan.corrupt,
+				   static_cast<unsigned long long>(r.scan.unframedBytes), "-", "-");
+			continue;
+		}
+		char replies[24];
+		snprintf(replies, sizeof(replies), "%u/%u", r.replies, r.requests);
+		printf("%8.1f %8zu %8.2f %7u %8llu %6.1f%% %9s %8.1f %8.1f %8.1f %8.1f%s\n", r.seconds, frames,
+			   r.seconds > 0.0 ? frames / r.seconds : 0.0, r.scan.corrupt,
+			   static_cast<unsigned long long>(r.scan.unframedBytes), r.rxBusy * 100.0, replies,
+			   percentileMs(r.latenciesUs, 50), percentileMs(r.latenciesUs, 95), percentileMs(r.latenciesUs, 99),
+			   percentileMs(r.latenciesUs, 100), r.truncated ? "  (truncated)" : "");
+	}
+}
+
+void printJson(const std::vector<UnitReport> &reports) {
+	printf("{\"suite\": \"capture_analyser\", \"scan\": \"%s\", \"results\": [\n", findStartImplementation());
+	for (size_t i = 0; i < reports.size(); i++) {
+		const UnitReport &r = reports[i];
+		const char *separator = (i + 1 < reports.size()) ? "," : "";
+		if (!r.error.empty()) {
+			printf("  {\"name\": \"%s\", \"error\": \"%s\"}%s\n", r.path, r.error.c_str(), separator);
+			continue;
+		}
+		size_t frames = r.scan.frames.size();
+		printf("  {\"name\": \"%s\", \"protocol\": \"%s\", \"format\": \"%s\", \"truncated\": %s, \"seconds\": %.3f, "
+			   "\"rx_bytes\": %llu, \"frames\": %zu, \"frames_per_sec\": %.3f, \"controls\": %u, \"crc_errors\": %u, "
+			   "\"unframed_bytes\": %llu, \"rx_busy\": %.4f, \"requests\": %u, \"replies\": %u, \"p50_ms\": %.3f, "
+			   "\"p95_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, \"latency_buckets_ms\": [",
+			   r.path, r.protocol->name, (r.format == InputFormat::Capture) ? "capture" : "log",
+			   r.truncated ? "true" : "false", r.seconds, static_cast<unsigned long long>(r.rxBytes), frames,
+			   r.seconds > 0.0 ? frames / r.seconds : 0.0, r.scan.controls, r.scan.corrupt,
+			   static_cast<unsigned long long>(r.scan.unframedBytes), r.rxBusy, r.requests, r.replies,
+			   percentileMs(r.latenciesUs, 50), percentileMs(r.latenciesUs, 95), percentileMs(r.latenciesUs, 99),
+			   percentileMs(r.latenciesUs, 100));
+		for (uint8_t b = 0; b < LatencyHistogram::kBuckets; b++) {
+			printf("%s%u", b ? ", " : "", r.histogram.counts[b]);
+		}
+		printf("]}%s\n", separator);
+	}
+	printf("]}\n");
+}
+
+int usage() {
+	fprintf(stderr, "usage: capture_analyser [--protocol=<name>] [--jobs=<n>] [--json] <file>...\nprotocols:");
+	for (size_t i = 0; i < scannerCount(); i++) {
+		fprintf(stderr, " %s", scanners()[i].name);
+	}
+	fprintf(stderr, "\n");
+	return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	Args args;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--protocol=", 11) == 0) {
+			args.protocol = findScanner(argv[i] + 11);
+			if (!args.protocol) {
+				return usage();
+			}
+		} else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+			args.jobs = static_cast<uint32_t>(strtoul(argv[i] + 7, nullptr, 10));
+		} else if (strcmp(argv[i], "--json") == 0) {
+			args.json = true;
+		} else if (argv[i][0] == '-') {
+			return usage();
+		} else {
+			args.paths.push_back(argv[i]);
+		}
+	}
+	if (args.paths.empty()) {
+		return usage();
+	}
+
+	uint32_t jobs = args.jobs ? args.jobs : std::thread::hardware_concurrency();
+	jobs = std::max<uint32_t>(1, std::min<uint32_t>(jobs, static_cast<uint32_t>(args.paths.size())));
+
+	// Workers take the next file until none is left; reports keep the command line order
+	std::vector<UnitReport> reports(args.paths.size());
+	std::atomic<size_t> next{0};
+	auto wallStart = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (uint32_t w = 0; w < jobs; w++) {
+		workers.emplace_back([&] {
+			size_t index;
+			while ((index = next.fetch_add(1)) < args.paths.size()) {
+				analyse(args.paths[index], args.protocol, reports[index]);
+			}
+		});
+	}
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+	bool failed = false;
+	uint64_t rxBytes = 0;
+	for (const UnitReport &r : reports) {
+		failed |= !r.error.empty();
+		rxBytes += r.rxBytes;
+	}
+
+	if (args.json) {
+		printJson(reports);
+	} else {
+		printTable(reports);
+		printf("%zu files, %llu bytes received, scanned in %.1f ms on %u threads (%s)\n", reports.size(),
+			   static_cast<unsigned long long>(rxBytes), wallMs, jobs, findStartImplementation());
+	}
+	return failed ? 1 : 0;
+}
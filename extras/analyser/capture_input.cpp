@@ -0,0 +1,224 @@
+#include "capture_input.h"
+
+#include "climate_uart/transport/uart_transport_capture.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace climate_uart {
+namespace analyser {
+
+namespace {
+
+// A gap of this many character times between received chunks is a silence on the line
+constexpr uint32_t kBreakChars = 2;
+
+void addBreak(ByteStream &stream) {
+	size_t offset = stream.bytes.size();
+	if (stream.breaks.empty() || stream.breaks.back() != offset) {
+		stream.breaks.push_back(offset);
+	}
+}
+
+void loadCapture(const uint8_t *data, size_t size, Session &session) {
+	session.format = InputFormat::Capture;
+	uint64_t timeUs = 0;
+	uint64_t lastRxUs = 0;
+	size_t offset = transport::kCaptureHeaderSize;
+	transport::CaptureRecordView record;
+	while (transport::readCaptureRecord(data, size, offset, record)) {
+		timeUs += record.deltaUs;
+		switch (record.kind) {
+			case transport::CaptureRecord::Open:
+				session.line.baudrate = record.baudrate;
+				session.line.bitsPerChar = static_cast<uint8_t>(
+					transport::bitsPerChar(static_cast<transport::UartParity>(record.parity), record.stopBits));
+				addBreak(session.rx);
+				break;
+			case transport::CaptureRecord::Close:
+				addBreak(session.rx);
+				break;
+			case transport::CaptureRecord::Tx:
+				session.writes.push_back(TxWrite{timeUs, record.size});
+				session.line.bytesSent += record.size;
+				break;
+			case transport::CaptureRecord::Rx: {
+				uint64_t silenceUs = session.line.wireTimeUs(kBreakChars);
+				if (!session.rx.bytes.empty() && silenceUs > 0 && timeUs - lastRxUs >= silenceUs) {
+					addBreak(session.rx);
+				}
+				lastRxUs = timeUs;
+				session.rx.bytes.insert(session.rx.bytes.end(), record.data, record.data + record.size);
+				session.line.bytesReceived += record.size;
+				break;
+			}
+		}
+	}
+	// The walk stops short of the end on a record cut by a power loss
+	session.truncated = offset < size;
+	session.durationUs = timeUs;
+}
+
+int hexDigit(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+// Two-digit hex tokens separated by spaces, up to the end of the line or `stop`
+size_t parseHexBytes(const char *text, const char *end, char stop, std::vector<uint8_t> &out) {
+	size_t count = 0;
+	const char *p = text;
+	while (p < end && *p != stop) {
+		if (*p == ' ' || *p == '\t') {
+			p++;
+			continue;
+		}
+		if (end - p < 2 || hexDigit(p[0]) < 0 || hexDigit(p[1]) < 0 || (end - p > 2 && p[2] != ' ' && p[2] != '\r')) {
+			break;
+		}
+		out.push_back(static_cast<uint8_t>((hexDigit(p[0]) << 4) | hexDigit(p[1])));
+		count++;
+		p += 2;
+	}
+	return count;
+}
+
+const char *findIn(const char *begin, const char *end, const char *needle) {
+	size_t needleSize = strlen(needle);
+	for (const char *p = begin; p + needleSize <= end; p++) {
+		if (memcmp(p, needle, needleSize) == 0) {
+			return p;
+		}
+	}
+	return nullptr;
+}
+
+// "[climate-uart][B] FC 42 01 30 ..." (host, Arduino), one buffer per line, or
+// "D (1234) climate-uart: 0x3ffb4f10   fc 42 01 30 ...  |.B.0|" (ESP-IDF), sixteen bytes per
+// line with the address running on within one buffer.
+bool loadHexLog(const uint8_t *data, size_t size, Session &session) {
+	session.format = InputFormat::HexLog;
+	const char *text = reinterpret_cast<const char *>(data);
+	const char *end = text + size;
+	unsigned long nextAddress = 0;
+	bool found = false;
+	while (text < end) {
+		const char *lineEnd = static_cast<const char *>(memchr(text, '\n', static_cast<size_t>(end - text)));
+		if (!lineEnd) {
+			lineEnd = end;
+		}
+
+		const char *marker = findIn(text, lineEnd, "[B]");
+		if (marker) {
+			addBreak(session.rx);
+			found |= parseHexBytes(marker + 3, lineEnd, '\0', session.rx.bytes) > 0;
+		} else if ((marker = findIn(text, lineEnd, "climate-uart: 0x")) != nullptr) {
+			char *bytes;
+			unsigned long address = strtoul(marker + 16, &bytes, 16);
+			if (address != nextAddress) {
+				addBreak(session.rx);
+			}
+			size_t count = parseHexBytes(bytes, lineEnd, '|', session.rx.bytes);
+			nextAddress = address + count;
+			found |= count > 0;
+		}
+		text = lineEnd + 1;
+	}
+	session.line.bytesReceived = static_cast<uint32_t>(session.rx.bytes.size());
+	return found;
+}
+
+}  // namespace
+
+MappedFile::~MappedFile() {
+	if (mapped_) {
+		munmap(const_cast<uint8_t *>(data_), size_);
+	}
+}
+
+bool MappedFile::open(const char *path) {
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	size_ = static_cast<size_t>(info.st_size);
+	if (size_ > 0) {
+		void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED) {
+			::close(fd);
+			return false;
+		}
+		// One pass from start to end
+		madvise(map, size_, MADV_SEQUENTIAL);
+		data_ = static_cast<const uint8_t *>(map);
+		mapped_ = true;
+	}
+	::close(fd);
+	return true;
+}
+
+bool loadSession(const char *path, Session &session, std::string &error) {
+	MappedFile &file = session.file;
+	if (!file.open(path)) {
+		error = "cannot read";
+		return false;
+	}
+
+	if (transport::isCapture(file.data(), file.size())) {
+		loadCapture(file.data(), file.size(), session);
+		return true;
+	}
+	if (!loadHexLog(file.data(), file.size(), session)) {
+		error = "neither a capture nor a log with hex dumps";
+		return false;
+	}
+	return true;
+}
+
+void frameTimesUs(const Session &session, const std::vector<FrameSpan> &frames, std::vector<uint64_t> &timesUs) {
+	timesUs.clear();
+	if (session.format != InputFormat::Capture) {
+		return;
+	}
+	timesUs.reserve(frames.size());
+
+	// Received bytes up to the end of the current rx record, to place each frame start in it
+	uint64_t rxEnd = 0;
+	uint64_t timeUs = 0;
+	size_t offset = transport::kCaptureHeaderSize;
+	size_t frame = 0;
+	transport::CaptureRecordView record;
+	while (frame < frames.size() &&
+		   transport::readCaptureRecord(session.file.data(), session.file.size(), offset, record)) {
+		timeUs += record.deltaUs;
+		if (record.kind != transport::CaptureRecord::Rx) {
+			continue;
+		}
+		rxEnd += record.size;
+		while (frame < frames.size() && frames[frame].offset < rxEnd) {
+			timesUs.push_back(timeUs);
+			frame++;
+		}
+	}
+}
+
+}  // namespace analyser
+}  // namespace climate_uart
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "frame_scan.h"
+
+#include "climate_uart/transport/uart_transport.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace climate_uart {
+namespace analyser {
+
+// A read-only view of a whole file, memory-mapped so a large capture is paged in as it is
+// scanned rather than copied.
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const char *path);
+	const uint8_t *data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	const uint8_t *data_{nullptr};
+	size_t size_{0};
+	bool mapped_{false};
+};
+
+// One write() of the driver: when it went out and how many bytes
+struct TxWrite {
+	uint64_t timeUs;
+	uint32_t size;
+};
+
+enum class InputFormat : uint8_t {
+	Capture,  // UartTransportCapture records
+	HexLog,   // CLIMATE_LOG_BUFFER lines from a debug log
+};
+
+// Everything received and sent in one file, taken apart from the record stream. The file
+// stays mapped with it, so receive times are read from the records when they are needed
+// instead of being kept for every byte.
+struct Session {
+	MappedFile file;
+	InputFormat format{InputFormat::Capture};
+	ByteStream rx;
+	std::vector<TxWrite> writes;
+	// Line settings of the last open(); baudrate stays 0 in logs
+	transport::WireStats line{};
+	uint64_t durationUs{0};
+	// Capture ended inside a record (power loss while writing)
+	bool truncated{false};
+};
+
+// Loads a capture, or failing the capture magic, a debug log: the host and Arduino "[B]" lines
+// and ESP-IDF hex dumps. A log has no direction and no timing, so all its bytes land in `rx`
+// and each logged buffer starts a new break. Returns false with `error` set when the file
+// cannot be read or holds neither.
+bool loadSession(const char *path, Session &session, std::string &error);
+
+// Capture time of the first byte of each of `frames` (in offset order), from one more walk
+// over the mapped records. Empty for logs.
+void frameTimesUs(const Session &session, const std::vector<FrameSpan> &frames, std::vector<uint64_t> &timesUs);
+
+}  // namespace analyser
+}  // namespace climate_uart
@@ -0,0 +1,300 @@
+#include "frame_scan.h"
+
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink_codec.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace climate_uart {
+namespace analyser {
+
+using namespace climate_uart::protocols;
+
+bool StartSet::matches(uint8_t byte) const {
+	for (uint8_t i = 0; i < count; i++) {
+		if ((byte & patterns[i].mask) == patterns[i].value) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t findStart(const StartSet &set, const uint8_t *data, size_t from, size_t size) {
+	size_t i = from;
+#if defined(__SSE2__)
+	__m128i masks[kMaxStartPatterns];
+	__m128i values[kMaxStartPatterns];
+	for (uint8_t p = 0; p < set.count; p++) {
+		masks[p] = _mm_set1_epi8(static_cast<char>(set.patterns[p].mask));
+		values[p] = _mm_set1_epi8(static_cast<char>(set.patterns[p].value));
+	}
+	for (; i + 16 <= size; i += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+		__m128i hits = _mm_setzero_si128();
+		for (uint8_t p = 0; p < set.count; p++) {
+			hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(chunk, masks[p]), values[p]));
+		}
+		int bits = _mm_movemask_epi8(hits);
+		if (bits) {
+			return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(bits)));
+		}
+	}
+#elif defined(__ARM_NEON)
+	uint8x16_t masks[kMaxStartPatterns];
+	uint8x16_t values[kMaxStartPatterns];
+	for (uint8_t p = 0; p < set.count; p++) {
+		masks[p] = vdupq_n_u8(set.patterns[p].mask);
+		values[p] = vdupq_n_u8(set.patterns[p].value);
+	}
+	for (; i + 16 <= size; i += 16) {
+		uint8x16_t chunk = vld1q_u8(data + i);
+		uint8x16_t hits = vdupq_n_u8(0);
+		for (uint8_t p = 0; p < set.count; p++) {
+			hits = vorrq_u8(hits, vceqq_u8(vandq_u8(chunk, masks[p]), values[p]));
+		}
+		// No movemask on NEON: narrow each byte to a nibble, four bits per lane
+		uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+		if (bits) {
+			return i + static_cast<size_t>(__builtin_ctzll(bits) / 4);
+		}
+	}
+#endif
+	for (; i < size; i++) {
+		if (set.matches(data[i])) {
+			return i;
+		}
+	}
+	return size;
+}
+
+const char *findStartImplementation() {
+#if defined(__SSE2__)
+	return "sse2";
+#elif defined(__ARM_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+namespace {
+
+constexpr uint8_t kAck = 0x06;
+constexpr uint8_t kDaikinNak = 0x15;
+constexpr uint8_t kDaikinEtx = 0x03;
+constexpr uint8_t kDaikinMinPayload = 2;
+constexpr uint8_t kMitsubishiMaxData = 16;
+constexpr uint8_t kSharpMaxFrame = 18;
+constexpr uint8_t kLgFrameSize = 13;
+constexpr uint8_t kFujitsuFrameSize = 8;
+// "OK P=<64 hex digits> C=XXXX": the longest H-Link response line
+constexpr size_t kHitachiMaxLine = 5 + hlink::kMaxResponseData * 2 + 7;
+
+Match none() {
+	return Match{MatchKind::None, 0};
+}
+
+Match checked(bool valid, uint32_t size) {
+	return Match{valid ? MatchKind::Frame : MatchKind::Corrupt, size};
+}
+
+// STX 0xFC, command, two header bytes, data size, data, checksum
+Match matchMitsubishi(const uint8_t *data, size_t size, bool) {
+	if (size < 5 || data[4] > kMitsubishiMaxData) {
+		return none();
+	}
+	uint8_t dataSize = data[4];
+	if (size < dataSize + 6u) {
+		return none();
+	}
+	return checked(Mitsubishi::crc(data, static_cast<uint8_t>(dataSize + 5)) == data[dataSize + 5], dataSize + 6u);
+}
+
+// STX, payload, checksum, ETX; the payload runs to the first ETX as in the driver. It has to
+// hold at least the two-letter command, or "02 00 03" inside a Toshiba header would pass.
+Match matchDaikin(const uint8_t *data, size_t size, bool) {
+	if (data[0] == kAck || data[0] == kDaikinNak) {
+		return Match{MatchKind::Control, 1};
+	}
+	size_t limit = 1 + DaikinS21::kMaxPayloadSize + 2;
+	const uint8_t *etx = static_cast<const uint8_t *>(memchr(data + 1, kDaikinEtx, ((size < limit) ? size : limit) - 1));
+	if (!etx || etx - data < kDaikinMinPayload + 2) {
+		return none();
+	}
+	uint16_t payloadSize = static_cast<uint16_t>(etx - data - 2);
+	return checked(DaikinS21::checksum(data + 1, payloadSize) == data[1 + payloadSize],
+				   static_cast<uint32_t>(etx - data + 1));
+}
+
+// STX 0x02, two header bytes, type, two unknown bytes, data size, data, checksum
+Match matchToshiba(const uint8_t *data, size_t size, bool) {
+	if (size < 7 || size < data[6] + 8u) {
+		return none();
+	}
+	uint8_t dataSize = data[6];
+	return checked(Toshiba::crc(data, static_cast<uint8_t>(dataSize + 7)) == data[dataSize + 7], dataSize + 8u);
+}
+
+// 0xDC, length, type, body, checksum; the unit also acks our commands
+Match matchSharp(const uint8_t *data, size_t size, bool) {
+	if (data[0] == kAck) {
+		return Match{MatchKind::Control, 1};
+	}
+	if (size < 2 || data[1] + 3u > kSharpMaxFrame || size < data[1] + 3u) {
+		return none();
+	}
+	uint8_t frameSize = static_cast<uint8_t>(data[1] + 3);
+	return checked(Sharp::crc(data, frameSize - 1u) == data[frameSize - 1], frameSize);
+}
+
+// "OK ..." or "NG ..." up to '\r'
+Match matchHitachi(const uint8_t *data, size_t size, bool) {
+	size_t limit = (size < kHitachiMaxLine + 1) ? size : kHitachiMaxLine + 1;
+	const uint8_t *cr = static_cast<const uint8_t *>(memchr(data, '\r', limit));
+	if (!cr) {
+		return none();
+	}
+	char line[kHitachiMaxLine + 1];
+	size_t lineSize = static_cast<size_t>(cr - data);
+	memcpy(line, data, lineSize);
+	line[lineSize] = '\0';
+
+	hlink::Response response;
+	Result ret = hlink::parseResponse(line, response);
+	if (ret == kInvalidCrc) {
+		return Match{MatchKind::Corrupt, static_cast<uint32_t>(lineSize + 1)};
+	}
+	return (ret == kSuccess) ? Match{MatchKind::Frame, static_cast<uint32_t>(lineSize + 1)} : none();
+}
+
+Match matchLg(const uint8_t *data, size_t size, bool) {
+	if (size < kLgFrameSize) {
+		return none();
+	}
+	// A status type with a bad checksum is as likely a misaligned window as a corrupt frame
+	return LgAircon::isFrame(data) ? Match{MatchKind::Frame, kLgFrameSize} : none();
+}
+
+// Unit 1, controllers 32 and 33; 0 only ever as a destination
+bool isFujitsuAddress(uint8_t address) {
+	return address == 1 || address == 32 || address == 33;
+}
+
+// No checksum: a frame is eight bytes between silences whose addresses are bus addresses
+bool isFujitsuFrame(const uint8_t *data, bool lineCoded) {
+	uint8_t plain[kFujitsuFrameSize];
+	for (uint8_t i = 0; i < kFujitsuFrameSize; i++) {
+		plain[i] = lineCoded ? static_cast<uint8_t>(data[i] ^ 0xFF) : data[i];
+	}
+	Fujitsu::Frame frame = Fujitsu::decodeFrame(plain);
+	return isFujitsuAddress(frame.source) && (frame.dest == 0 || isFujitsuAddress(frame.dest)) &&
+		   frame.source != frame.dest;
+}
+
+constexpr ProtocolScanner kScanners[] = {
+	{"mitsubishi", {{{0xFF, 0xFC}}, 1}, matchMitsubishi, false},
+	{"daikin", {{{0xFF, 0x02}, {0xFF, kAck}, {0xFF, kDaikinNak}}, 3}, matchDaikin, false},
+	{"toshiba", {{{0xFF, 0x02}}, 1}, matchToshiba, false},
+	{"sharp", {{{0xFF, 0xDC}, {0xFF, kAck}}, 2}, matchSharp, false},
+	{"hitachi", {{{0xFF, 'O'}, {0xFF, 'N'}}, 2}, matchHitachi, false},
+	{"lg", {{{0xF8, 0xA8}, {0xF8, 0xC8}}, 2}, matchLg, false},
+	{"fujitsu", {{}, 0}, nullptr, true},
+};
+
+ScanResult scanGapFramed(const ByteStream &stream, bool lineCoded, size_t size) {
+	ScanResult result;
+	const uint8_t *data = stream.bytes.data();
+	size_t nextBreak = 0;
+	size_t pos = 0;
+	while (pos < size) {
+		// Realign on every silence, slide a byte at a time in between
+		while (nextBreak < stream.breaks.size() && stream.breaks[nextBreak] <= pos) {
+			nextBreak++;
+		}
+		size_t segmentEnd = (nextBreak < stream.breaks.size() && stream.breaks[nextBreak] < size)
+								? stream.breaks[nextBreak]
+								: size;
+		if (segmentEnd - pos >= kFujitsuFrameSize && isFujitsuFrame(data + pos, lineCoded)) {
+			result.frames.push_back(FrameSpan{pos, kFujitsuFrameSize});
+			pos += kFujitsuFrameSize;
+		} else {
+			result.unframedBytes++;
+			pos++;
+		}
+	}
+	return result;
+}
+
+}  // namespace
+
+const ProtocolScanner *scanners() {
+	return kScanners;
+}
+
+size_t scannerCount() {
+	return sizeof(kScanners) / sizeof(kScanners[0]);
+}
+
+const ProtocolScanner *findScanner(const char *name) {
+	for (const ProtocolScanner &scanner : kScanners) {
+		if (strcmp(scanner.name, name) == 0) {
+			return &scanner;
+		}
+	}
+	return nullptr;
+}
+
+ScanResult scan(const ProtocolScanner &scanner, const ByteStream &stream, bool lineCoded, size_t limit) {
+	size_t size = (stream.bytes.size() < limit) ? stream.bytes.size() : limit;
+	if (scanner.gapFramed) {
+		return scanGapFramed(stream, lineCoded, size);
+	}
+
+	ScanResult result;
+	const uint8_t *data = stream.bytes.data();
+	size_t covered = 0;
+	size_t corruptEnd = 0;
+	size_t pos = 0;
+	while ((pos = findStart(scanner.starts, data, pos, size)) < size) {
+		Match match = scanner.match(data + pos, size - pos, lineCoded);
+		switch (match.kind) {
+			case MatchKind::Frame:
+			case MatchKind::Control:
+				result.unframedBytes += pos - covered;
+				if (match.kind == MatchKind::Frame) {
+					result.frames.push_back(FrameSpan{pos, match.size});
+				} else {
+					result.controls++;
+				}
+				pos += match.size;
+				covered = pos;
+				break;
+			case MatchKind::Corrupt:
+				if (pos >= corruptEnd) {
+					result.corrupt++;
+					corruptEnd = pos + match.size;
+				}
+				pos++;
+				break;
+			default:
+				pos++;
+				break;
+		}
+	}
+	result.unframedBytes += size - covered;
+	return result;
+}
+
+}  // namespace analyser
+}  // namespace climate_uart
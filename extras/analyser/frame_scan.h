@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace climate_uart {
+namespace analyser {
+
+// A class of frame start bytes: `byte & mask == value`. Exact bytes use mask 0xFF; LG status
+// types (0xA8..0xAF) are one pattern with mask 0xF8.
+struct StartPattern {
+	uint8_t mask;
+	uint8_t value;
+};
+
+constexpr uint8_t kMaxStartPatterns = 4;
+
+struct StartSet {
+	StartPattern patterns[kMaxStartPatterns];
+	uint8_t count;
+
+	bool matches(uint8_t byte) const;
+};
+
+// Offset of the first byte at or after `from` matching `set`, or `size` if there is none.
+// Compares 16 bytes at a time with SSE2 or NEON when the compiler targets them; the scalar
+// loop handles the tail and every other target.
+size_t findStart(const StartSet &set, const uint8_t *data, size_t from, size_t size);
+
+// Which implementation findStart() was built with ("sse2", "neon" or "scalar")
+const char *findStartImplementation();
+
+enum class MatchKind : uint8_t {
+	None,     // not a frame here, or cut short by the end of the stream
+	Frame,    // a frame whose checksum (or, for Fujitsu, addressing) holds
+	Control,  // a lone ACK/NAK byte
+	Corrupt,  // the header announces a frame but its checksum does not match
+};
+
+struct Match {
+	MatchKind kind;
+	uint32_t size;
+};
+
+// Received bytes of one session, in order. `breaks` are the offsets where the input was split
+// (each log line, each silence longer than two character times) and only matter to
+// gap-framed buses.
+struct ByteStream {
+	std::vector<uint8_t> bytes;
+	std::vector<size_t> breaks;
+};
+
+struct FrameSpan {
+	size_t offset;
+	uint32_t size;
+};
+
+struct ScanResult {
+	std::vector<FrameSpan> frames;
+	uint32_t controls{0};
+	uint32_t corrupt{0};
+	// Bytes outside any frame or control byte, corrupt frames included
+	uint64_t unframedBytes{0};
+};
+
+// How one protocol recognises its frames in a received stream. Checksums come from the
+// drivers themselves, so a frame passes when its driver would take it (Daikin frames must
+// also hold their two-letter command).
+struct ProtocolScanner {
+	const char *name;
+	StartSet starts;
+	// Match at data[0]; `lineCoded` is set for raw wire bytes (captures), clear for bytes the
+	// drivers logged after decoding. Null for gap-framed protocols.
+	Match (*match)(const uint8_t *data, size_t size, bool lineCoded);
+	// Fujitsu: no start byte and no checksum, frames are the runs between silences
+	bool gapFramed;
+};
+
+// The scanners for every protocol, in the order of the command line names
+const ProtocolScanner *scanners();
+size_t scannerCount();
+const ProtocolScanner *findScanner(const char *name);
+
+// Walks the first `limit` bytes of `stream` for frames. A corrupt frame counts once, however
+// many start bytes its bytes contain; the scan resumes one byte after its start, so a real
+// frame inside it is still found.
+ScanResult scan(const ProtocolScanner &scanner, const ByteStream &stream, bool lineCoded, size_t limit = SIZE_MAX);
+
+}  // namespace analyser
+}  // namespace climate_uart
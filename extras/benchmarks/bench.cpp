@@ -0,0 +1,224 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+}  // namespace
+
+// Every benchmark binary links this file: counting here covers the library, the std
+// containers in the harness and anything else that goes through operator new.
+void *operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+namespace climate_uart {
+namespace bench {
+
+uint64_t allocationCount() {
+	return allocations.load(std::memory_order_relaxed);
+}
+
+void Options::parse(const char *suite, int argc, char **argv) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		if (strcmp(arg, "--json") == 0) {
+			json = true;
+		} else if (strncmp(arg, "--filter=", 9) == 0) {
+			filter = arg + 9;
+		} else if (strncmp(arg, "--min-time-ms=", 14) == 0) {
+			minTimeMs = static_cast<uint32_t>(strtoul(arg + 14, nullptr, 10));
+		} else if (strncmp(arg, "--baseline=", 11) == 0) {
+			baselinePath = arg + 11;
+		} else if (strncmp(arg, "--samples=", 10) == 0) {
+			samples = static_cast<uint32_t>(strtoul(arg + 10, nullptr, 10));
+			if (samples == 0) {
+				samples = 1;
+			}
+		} else {
+			fprintf(stderr, "%s: unknown option %s\n", suite, arg);
+		}
+	}
+}
+
+bool Options::selected(const char *name) const {
+	return !filter || strstr(name, filter) != nullptr;
+}
+
+Reporter::Reporter(const char *suite, int argc, char **argv) : suite_(suite) {
+	options_.parse(suite, argc, argv);
+
+	if (options_.baselinePath) {
+		FILE *file = fopen(options_.baselinePath, "rb");
+		if (!file) {
+			fprintf(stderr, "%s: cannot read baseline %s\n", suite_, options_.baselinePath);
+		} else {
+			char chunk[4096];
+			size_t size;
+			while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+				baseline_.insert(baseline_.end(), chunk, chunk + size);
+			}
+			fclose(file);
+		}
+		baseline_.push_back('\0');
+	}
+
+	results_.reserve(64);
+}
+
+void Reporter::add(const Measurement &measurement) {
+	results_.push_back(measurement);
+	if (!options_.json) {
+		// Progress as it goes; the summary comes from finish()
+		fprintf(stderr, ".");
+	}
+}
+
+bool Reporter::baselineNsPerOp(const char *name, double &nsPerOp) const {
+	// --json writes one result per line: find ours and read its ns_per_op
+	char key[160];
+	snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+	const char *line = baseline_.empty() ? nullptr : strstr(baseline_.data(), key);
+	if (!line) {
+		return false;
+	}
+	const char *field = strstr(line, "\"ns_per_op\": ");
+	const char *end = strchr(line, '\n');
+	if (!field || (end && field > end)) {
+		return false;
+	}
+	nsPerOp = strtod(field + 13, nullptr);
+	return nsPerOp > 0.0;
+}
+
+int Reporter::finish() {
+	if (options_.json) {
+		printf("{\"suite\": \"%s\", \"results\": [\n", suite_);
+		for (size_t i = 0; i < results_.size(); i++) {
+			const Measurement &m = results_[i];
+			double bytesPerSec = (m.bytesPerOp > 0.0) ? m.bytesPerOp * 1e9 / m.nsPerOp : 0.0;
+			printf("  {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"bytes_per_op\": %.0f, "
+				   "\"bytes_per_sec\": %.0f, \"allocs_per_op\": %.4f}%s\n",
+				   m.name, static_cast<unsigned long long>(m.iterations), m.nsPerOp, m.bytesPerOp, bytesPerSec,
+				   m.allocsPerOp, (i + 1 < results_.size()) ? "," : "");
+		}
+		printf("]}\n");
+		return 0;
+	}
+
+	fprintf(stderr, "\n");
+	printf("%-44s %12s %12s %10s", "benchmark", "ns/op", "MB/s", "allocs/op");
+	printf(options_.baselinePath ? " %10s\n" : "\n", "vs base");
+	for (const Measurement &m : results_) {
+		printf("%-44s %12.1f ", m.name, m.nsPerOp);
+		if (m.bytesPerOp > 0.0) {
+			printf("%12.1f", m.bytesPerOp * 1e3 / m.nsPerOp);
+		} else {
+			printf("%12s", "-");
+		}
+		printf(" %10.2f", m.allocsPerOp);
+
+		double baseNs = 0.0;
+		if (options_.baselinePath && baselineNsPerOp(m.name, baseNs)) {
+			printf(" %+9.1f%%", (m.nsPerOp - baseNs) * 100.0 / baseNs);
+		}
+		printf("\n");
+	}
+	return 0;
+}
+
+namespace {
+
+// Nearest-rank percentile of a sorted sample, in milliseconds.
+double percentileMs(const std::vector<uint64_t> &sorted, uint32_t percent) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	size_t rank = (sorted.size() * percent + 99) / 100;
+	return static_cast<double>(sorted[rank ? rank - 1 : 0]) / 1000.0;
+}
+
+}  // namespace
+
+LatencyReporter::LatencyReporter(const char *suite, int argc, char **argv) : suite_(suite) {
+	options_.parse(suite, argc, argv);
+	results_.reserve(32);
+}
+
+void LatencyReporter::add(const char *name, std::vector<uint64_t> latenciesUs, uint32_t failures,
+						  uint64_t exchanges, uint64_t bytes) {
+	std::sort(latenciesUs.begin(), latenciesUs.end());
+	uint32_t runs = static_cast<uint32_t>(latenciesUs.size()) + failures;
+
+	LatencyResult result;
+	result.name = name;
+	result.samples = static_cast<uint32_t>(latenciesUs.size());
+	result.failures = failures;
+	result.p50Ms = percentileMs(latenciesUs, 50);
+	result.p95Ms = percentileMs(latenciesUs, 95);
+	result.p99Ms = percentileMs(latenciesUs, 99);
+	result.maxMs = percentileMs(latenciesUs, 100);
+	result.exchangesPerOp = runs ? static_cast<double>(exchanges) / runs : 0.0;
+	result.bytesPerOp = runs ? static_cast<double>(bytes) / runs : 0.0;
+	results_.push_back(result);
+
+	if (!options_.json) {
+		fprintf(stderr, ".");
+	}
+}
+
+int LatencyReporter::finish() {
+	if (options_.json) {
+		printf("{\"suite\": \"%s\", \"results\": [\n", suite_);
+		for (size_t i = 0; i < results_.size(); i++) {
+			const LatencyResult &r = results_[i];
+			printf("  {\"name\": \"%s\", \"samples\": %u, \"failures\": %u, \"p50_ms\": %.3f, \"p95_ms\": %.3f, "
+				   "\"p99_ms\": %.3f, \"max_ms\": %.3f, \"exchanges_per_op\": %.2f, \"bytes_per_op\": %.1f}%s\n",
+				   r.name.c_str(), r.samples, r.failures, r.p50Ms, r.p95Ms, r.p99Ms, r.maxMs, r.exchangesPerOp,
+				   r.bytesPerOp, (i + 1 < results_.size()) ? "," : "");
+		}
+		printf("]}\n");
+		return 0;
+	}
+
+	fprintf(stderr, "\n");
+	printf("%-32s %9s %9s %9s %9s %9s %9s %6s\n", "operation", "p50 ms", "p95 ms", "p99 ms", "max ms", "exchanges",
+		   "bytes", "fails");
+	for (const LatencyResult &r : results_) {
+		printf("%-32s %9.1f %9.1f %9.1f %9.1f %9.2f %9.1f %6u\n", r.name.c_str(), r.p50Ms, r.p95Ms, r.p99Ms, r.maxMs,
+			   r.exchangesPerOp, r.bytesPerOp, r.failures);
+	}
+	return 0;
+}
+
+}  // namespace bench
+}  // namespace climate_uart
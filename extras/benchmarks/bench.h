@@ -0,0 +1,142 @@
+#pragma once
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace climate_uart {
+namespace bench {
+
+// Keeps the optimiser from discarding a benchmarked result.
+template <typename T>
+inline void doNotOptimize(const T &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// operator new calls made by the process so far (counted in bench.cpp).
+uint64_t allocationCount();
+
+struct Measurement {
+	const char *name;
+	uint64_t iterations;
+	double nsPerOp;
+	double bytesPerOp;
+	double allocsPerOp;
+};
+
+// Command line shared by the benchmark binaries:
+//   --json             one JSON document on stdout instead of the table
+//   --filter=<text>    only run benchmarks whose name contains <text>
+//   --min-time-ms=<n>  timed run length per benchmark (default 200)
+//   --baseline=<file>  compare against an earlier --json output, by benchmark name
+//   --samples=<n>      runs per operation in latency benchmarks (default 200)
+struct Options {
+	bool json{false};
+	const char *filter{nullptr};
+	const char *baselinePath{nullptr};
+	uint32_t minTimeMs{200};
+	uint32_t samples{200};
+
+	void parse(const char *suite, int argc, char **argv);
+	bool selected(const char *name) const;
+};
+
+// Runs and reports one CPU-time benchmark binary.
+class Reporter {
+public:
+	Reporter(const char *suite, int argc, char **argv);
+
+	// Warms fn() up, then times it over enough iterations to fill the minimum run time.
+	// bytesPerOp is the frame size the operation consumes or produces (0 if not meaningful).
+	template <typename Fn>
+	void run(const char *name, size_t bytesPerOp, Fn fn);
+
+	// Prints the results; returns the process exit code.
+	int finish();
+
+private:
+	void add(const Measurement &measurement);
+	bool baselineNsPerOp(const char *name, double &nsPerOp) const;
+
+	const char *suite_;
+	Options options_;
+	std::vector<char> baseline_;
+	std::vector<Measurement> results_;
+};
+
+// Distribution of one operation over many independent runs, in simulated time.
+struct LatencyResult {
+	std::string name;
+	uint32_t samples;
+	uint32_t failures;
+	double p50Ms;
+	double p95Ms;
+	double p99Ms;
+	double maxMs;
+	double exchangesPerOp;
+	double bytesPerOp;
+};
+
+// Collects and reports latency benchmarks (--json, --filter= and --samples= apply).
+class LatencyReporter {
+public:
+	LatencyReporter(const char *suite, int argc, char **argv);
+
+	uint32_t samples() const { return options_.samples; }
+	bool selected(const char *name) const { return options_.selected(name); }
+
+	// latenciesUs holds one entry per successful run; exchanges and bytes are totals over
+	// every run, failures included.
+	void add(const char *name, std::vector<uint64_t> latenciesUs, uint32_t failures, uint64_t exchanges,
+			 uint64_t bytes);
+
+	// Prints the results; returns the process exit code.
+	int finish();
+
+private:
+	const char *suite_;
+	Options options_;
+	std::vector<LatencyResult> results_;
+};
+
+template <typename Fn>
+void Reporter::run(const char *name, size_t bytesPerOp, Fn fn) {
+	if (!options_.selected(name)) {
+		return;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	const auto minTime = std::chrono::milliseconds(options_.minTimeMs) / 10;
+
+	// Warm-up (caches, branch predictors, lazy init), also sizing the timed run
+	uint64_t iterations = 1;
+	for (;;) {
+		auto start = Clock::now();
+		for (uint64_t i = 0; i < iterations; i++) {
+			fn();
+		}
+		if (Clock::now() - start >= minTime) {
+			break;
+		}
+		iterations *= 2;
+	}
+	iterations *= 10;
+
+	uint64_t allocations = allocationCount();
+	auto start = Clock::now();
+	for (uint64_t i = 0; i < iterations; i++) {
+		fn();
+	}
+	auto elapsed = Clock::now() - start;
+	allocations = allocationCount() - allocations;
+
+	double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	add({name, iterations, ns / iterations, static_cast<double>(bytesPerOp),
+		 static_cast<double>(allocations) / iterations});
+}
+
+}  // namespace bench
+}  // namespace climate_uart
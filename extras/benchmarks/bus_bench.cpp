@@ -0,0 +1,153 @@
+// Bus occupancy per protocol: each run polls getState() at a fixed period for a stretch of
+// simulated time and reports what the driver's transport saw (UartTransport::wireStats()),
+// as the share of each line that was busy, the receive line's idle time, and the wire time
+// lost to bytes the driver threw away (MetricCounter::ResyncBytes and CorruptBytes).
+// The noisy runs add bit flips and spurious bytes on the way to the driver.
+// On the single-wire buses (LG, Fujitsu) the receive line carries both directions.
+
+#include "bench.h"
+#include "simulation.h"
+
+#include "daikin_s21_emulator.h"
+#include "fujitsu_emulator.h"
+#include "hitachi_hlink_emulator.h"
+#include "lg_aircon_emulator.h"
+#include "mitsubishi_emulator.h"
+#include "sharp_emulator.h"
+#include "toshiba_emulator.h"
+
+#include "climate_uart/platform_host.h"
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace climate_uart;
+using namespace climate_uart::emulators;
+using namespace climate_uart::protocols;
+
+namespace {
+
+constexpr uint64_t kStartLimitUs = 30000000;
+constexpr uint64_t kWindowUs = 120000000;
+
+struct Scenario {
+	const char *name;
+	uint32_t pollMs;
+	bool noisy;
+};
+
+const Scenario kScenarios[] = {
+	{"poll 1s", 1000, false},
+	{"poll 10s", 10000, false},
+	{"poll 1s noisy", 1000, true},
+};
+
+struct BusResult {
+	std::string name;
+	uint32_t baudrate;
+	double txBusy;
+	double rxBusy;
+	double rxIdleS;
+	double lostMs;
+	double bytesPerS;
+};
+
+template <typename Driver, typename Emulator, typename Setup>
+void measure(const bench::Options &options, std::vector<BusResult> &results, const char *protocol, Setup setup) {
+	for (const Scenario &scenario : kScenarios) {
+		std::string name = std::string(protocol) + "/" + scenario.name;
+		if (!options.selected(name.c_str())) {
+			continue;
+		}
+
+		bench::Simulation<Driver, Emulator> sim(1);
+		if (sim.start(kStartLimitUs, setup) != kSuccess) {
+			fprintf(stderr, "%s: driver never became ready\n", name.c_str());
+			continue;
+		}
+		if (scenario.noisy) {
+			FaultProfile noise;
+			noise.bitFlipPpm = 1000;
+			noise.insertPpm = 1000;
+			sim.faults().setProfile(Direction::ToHost, noise);
+		}
+
+		MetricsSnapshot before;
+		sim.driver().metrics().snapshot(before);
+		sim.faults().resetWireStats();
+
+		uint64_t end = sim.nowUs() + kWindowUs;
+		while (sim.nowUs() < end) {
+			uint64_t next = sim.nowUs() + scenario.pollMs * 1000ull;
+			ClimateSettings settings;
+			sim.driver().getState(settings);
+			if (sim.nowUs() < next) {
+				sim.idle(next - sim.nowUs());
+			}
+		}
+
+		MetricsSnapshot after;
+		sim.driver().metrics().snapshot(after);
+		transport::WireStats wire = sim.faults().wireStats();
+		uint32_t discarded = (after.counter(MetricCounter::ResyncBytes) - before.counter(MetricCounter::ResyncBytes)) +
+							 (after.counter(MetricCounter::CorruptBytes) - before.counter(MetricCounter::CorruptBytes));
+
+		results.push_back({name, wire.baudrate, wire.txUtilisation() * 100.0, wire.rxUtilisation() * 100.0,
+						   wire.rxIdleUs() / 1e6, wire.wireTimeUs(discarded) / 1e3,
+						   (wire.bytesSent + wire.bytesReceived) / (wire.windowUs / 1e6)});
+		fprintf(stderr, ".");
+	}
+}
+
+template <typename Driver, typename Emulator>
+void measure(const bench::Options &options, std::vector<BusResult> &results, const char *protocol) {
+	measure<Driver, Emulator>(options, results, protocol, [](Emulator &) {});
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	host::set_log_enabled(false);
+	bench::Options options;
+	options.parse("bus", argc, argv);
+
+	std::vector<BusResult> results;
+	measure<Mitsubishi, MitsubishiEmulator>(options, results, "mitsubishi");
+	measure<DaikinS21, DaikinS21Emulator>(options, results, "daikin");
+	measure<Toshiba, ToshibaEmulator>(options, results, "toshiba");
+	measure<Sharp, SharpEmulator>(options, results, "sharp");
+	measure<HitachiHLink, HitachiHLinkEmulator>(options, results, "hitachi");
+	measure<LgAircon, LgAirconEmulator>(options, results, "lg",
+										[](LgAirconEmulator &unit) { unit.setBroadcastIntervalMs(5000); });
+	measure<Fujitsu, FujitsuEmulator>(options, results, "fujitsu");
+
+	if (options.json) {
+		printf("{\"suite\": \"bus\", \"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++) {
+			const BusResult &r = results[i];
+			printf("  {\"name\": \"%s\", \"baudrate\": %u, \"tx_busy_pct\": %.2f, \"rx_busy_pct\": %.2f, "
+				   "\"rx_idle_s\": %.2f, \"lost_ms\": %.1f, \"bytes_per_s\": %.2f}%s\n",
+				   r.name.c_str(), r.baudrate, r.txBusy, r.rxBusy, r.rxIdleS, r.lostMs, r.bytesPerS,
+				   (i + 1 < results.size()) ? "," : "");
+		}
+		printf("]}\n");
+		return 0;
+	}
+
+	fprintf(stderr, "\n");
+	printf("%-28s %7s %9s %9s %9s %9s %9s\n", "run", "baud", "tx busy%", "rx busy%", "rx idle s", "lost ms",
+		   "bytes/s");
+	for (const BusResult &r : results) {
+		printf("%-28s %7u %9.2f %9.2f %9.1f %9.1f %9.1f\n", r.name.c_str(), r.baudrate, r.txBusy, r.rxBusy, r.rxIdleS,
+			   r.lostMs, r.bytesPerS);
+	}
+	return 0;
+}
@@ -0,0 +1,217 @@
+// Pure encode/decode paths of every protocol: checksums, frame codecs and value mappers.
+// No I/O is involved; each operation runs on a frame already in memory.
+
+#include "bench.h"
+
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink.h"
+#include "climate_uart/protocols/hitachi_hlink_codec.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+
+#include <string.h>
+
+using namespace climate_uart;
+using namespace climate_uart::protocols;
+
+namespace {
+
+constexpr uint8_t kModeCount = static_cast<uint8_t>(HeatpumpMode::Count);
+constexpr uint8_t kFanCount = static_cast<uint8_t>(HeatpumpFanSpeed::Count);
+constexpr uint8_t kVaneCount = static_cast<uint8_t>(HeatpumpVaneMode::Count);
+
+// Cycles through every settings value so mappers cannot be folded to a constant.
+struct SettingsCycle {
+	uint32_t index{0};
+
+	ClimateSettings next() {
+		ClimateSettings settings;
+		uint32_t i = index++;
+		settings.action = (i & 1) ? HeatpumpAction::On : HeatpumpAction::Off;
+		settings.mode = static_cast<HeatpumpMode>(1 + i % (kModeCount - 1));
+		settings.fanSpeed = static_cast<HeatpumpFanSpeed>(1 + i % (kFanCount - 1));
+		settings.vaneMode = static_cast<HeatpumpVaneMode>(i % kVaneCount);
+		settings.temperature = 18 + static_cast<int>(i % 12);
+		return settings;
+	}
+};
+
+void mitsubishi(bench::Reporter &reporter) {
+	// STX, cmd, header, size, 16 data bytes: a get-settings request
+	uint8_t packet[21] = {0xFC, 0x42, 0x01, 0x30, 0x10, 0x02};
+	reporter.run("mitsubishi/crc", sizeof(packet), [&] {
+		packet[6]++;
+		bench::doNotOptimize(Mitsubishi::crc(packet, sizeof(packet)));
+	});
+}
+
+void toshiba(bench::Reporter &reporter) {
+	// Status reply: header, 7 bytes of preamble, six (function, value) pairs
+	uint8_t packet[] = {0x02, 0x00, 0x03, 0x90, 0x00, 0x00, 0x13, 0x01, 0x30, 0x01, 0x00, 0x00, 0x81, 0x00,
+						0x88, 0x00, 0x80, 0x30, 0xB0, 0x42, 0xB3, 0x16, 0xA0, 0x41, 0xA3, 0x31, 0xBB, 0x15};
+	reporter.run("toshiba/crc", sizeof(packet), [&] {
+		packet[27]++;
+		bench::doNotOptimize(Toshiba::crc(packet, sizeof(packet)));
+	});
+
+	SettingsCycle cycle;
+	reporter.run("toshiba/map round-trip", 0, [&] {
+		ClimateSettings settings = cycle.next();
+		bench::doNotOptimize(Toshiba::byteToMode(Toshiba::modeToByte(settings.mode)));
+		bench::doNotOptimize(Toshiba::byteToFan(Toshiba::fanToByte(settings.fanSpeed)));
+		bench::doNotOptimize(Toshiba::byteToVane(Toshiba::vaneToByte(settings.vaneMode)));
+	});
+}
+
+void daikin(bench::Reporter &reporter) {
+	uint8_t payload[] = {'G', '1', '1', '3', 72, 'A'};
+	reporter.run("daikin/checksum", sizeof(payload), [&] {
+		payload[4]++;
+		bench::doNotOptimize(DaikinS21::checksum(payload, sizeof(payload)));
+	});
+
+	SettingsCycle cycle;
+	reporter.run("daikin/map round-trip", 0, [&] {
+		ClimateSettings settings = cycle.next();
+		bench::doNotOptimize(DaikinS21::byteToMode(DaikinS21::modeToByte(settings.mode, settings.action)));
+		bench::doNotOptimize(DaikinS21::byteToFan(DaikinS21::fanToByte(settings.fanSpeed)));
+	});
+}
+
+void sharp(bench::Reporter &reporter) {
+	SettingsCycle cycle;
+	uint8_t command[Sharp::kCommandFrameSize];
+	reporter.run("sharp/encodeCommand", sizeof(command), [&] {
+		Sharp::encodeCommand(cycle.next(), command);
+		bench::doNotOptimize(command);
+	});
+
+	Sharp::encodeCommand(cycle.next(), command);
+	reporter.run("sharp/cmdCrc", sizeof(command), [&] {
+		command[4]++;
+		bench::doNotOptimize(Sharp::cmdCrc(command));
+	});
+
+	// Status frame: the longest frame the unit sends
+	uint8_t status[18] = {0xDC, 0x0F, 0xFD};
+	reporter.run("sharp/crc", sizeof(status), [&] {
+		status[7]++;
+		bench::doNotOptimize(Sharp::crc(status, sizeof(status) - 1));
+	});
+
+	reporter.run("sharp/map round-trip", 0, [&] {
+		ClimateSettings settings = cycle.next();
+		bench::doNotOptimize(Sharp::byteToMode(Sharp::modeToByte(settings.mode)));
+		bench::doNotOptimize(Sharp::byteToFan(Sharp::fanToByte(settings.fanSpeed)));
+		bench::doNotOptimize(Sharp::byteToVane(Sharp::vaneToByte(settings.vaneMode)));
+	});
+}
+
+void lg(bench::Reporter &reporter) {
+	uint8_t status[13] = {0xC8, 0x8E, 0x80, 0x00, 0x00, 0x00, 0x07, 0x1A};
+	status[12] = LgAircon::crc(status, 12);
+	reporter.run("lg/crc", 12, [&] {
+		status[3]++;
+		bench::doNotOptimize(LgAircon::crc(status, 12));
+	});
+	status[3] = 0;
+
+	reporter.run("lg/isFrame", sizeof(status), [&] {
+		bench::doNotOptimize(status);
+		bench::doNotOptimize(LgAircon::isFrame(status));
+	});
+
+	ClimateSettings settings;
+	reporter.run("lg/decodeStatus", sizeof(status), [&] {
+		status[1] = static_cast<uint8_t>(status[1] + 0x20);
+		LgAircon::decodeStatus(status, settings);
+		bench::doNotOptimize(settings);
+	});
+}
+
+void hitachi(bench::Reporter &reporter) {
+	const uint8_t data[] = {0x80, 0x40};
+	char frame[hlink::kMaxFrameSize];
+	uint16_t address = 0;
+	const size_t frameSize = hlink::encodeFrame("ST", 0x0001, data, sizeof(data), frame, sizeof(frame));
+	reporter.run("hitachi/encodeFrame", frameSize, [&] {
+		bench::doNotOptimize(hlink::encodeFrame("ST", address++, data, sizeof(data), frame, sizeof(frame)));
+	});
+
+	const char line[] = "OK P=8040 C=FF3F";
+	hlink::Response response;
+	reporter.run("hitachi/parseResponse", sizeof(line) - 1, [&] {
+		bench::doNotOptimize(line);
+		bench::doNotOptimize(hlink::parseResponse(line, response));
+	});
+
+	uint8_t bytes[2] = {0x12, 0x34};
+	reporter.run("hitachi/checksum", sizeof(bytes) + 2, [&] {
+		bytes[1]++;
+		bench::doNotOptimize(hlink::checksum(0x0001, bytes, sizeof(bytes)));
+	});
+
+	SettingsCycle cycle;
+	reporter.run("hitachi/map round-trip", 0, [&] {
+		ClimateSettings settings = cycle.next();
+		bench::doNotOptimize(HitachiHLink::wordToMode(HitachiHLink::modeToWord(settings.mode)));
+		bench::doNotOptimize(HitachiHLink::byteToFan(HitachiHLink::fanToByte(settings.fanSpeed)));
+		bench::doNotOptimize(HitachiHLink::byteToVane(HitachiHLink::vaneToByte(settings.vaneMode)));
+	});
+}
+
+void fujitsu(bench::Reporter &reporter) {
+	Fujitsu::Frame frame;
+	frame.source = 1;
+	frame.dest = 32;
+	frame.onOff = 1;
+	frame.mode = 3;
+	frame.fanMode = 2;
+	frame.temperature = 22;
+	frame.controllerPresent = 1;
+	frame.controllerTemp = 21;
+
+	uint8_t buf[8];
+	reporter.run("fujitsu/encodeFrame", sizeof(buf), [&] {
+		frame.temperature = static_cast<uint8_t>(16 + (frame.temperature + 1) % 16);
+		Fujitsu::encodeFrame(frame, buf);
+		bench::doNotOptimize(buf);
+	});
+
+	Fujitsu::encodeFrame(frame, buf);
+	reporter.run("fujitsu/decodeFrame", sizeof(buf), [&] {
+		buf[4]++;
+		bench::doNotOptimize(Fujitsu::decodeFrame(buf));
+	});
+
+	reporter.run("fujitsu/frameToSettings", 0, [&] {
+		frame.mode = static_cast<uint8_t>(1 + frame.mode % 5);
+		bench::doNotOptimize(Fujitsu::frameToSettings(frame));
+	});
+
+	SettingsCycle cycle;
+	reporter.run("fujitsu/map round-trip", 0, [&] {
+		ClimateSettings settings = cycle.next();
+		bench::doNotOptimize(Fujitsu::byteToMode(Fujitsu::modeToByte(settings.mode)));
+		bench::doNotOptimize(Fujitsu::byteToFan(Fujitsu::fanToByte(settings.fanSpeed)));
+	});
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	bench::Reporter reporter("codec", argc, argv);
+
+	mitsubishi(reporter);
+	toshiba(reporter);
+	daikin(reporter);
+	sharp(reporter);
+	lg(reporter);
+	hitachi(reporter);
+	fujitsu(reporter);
+
+	return reporter.finish();
+}
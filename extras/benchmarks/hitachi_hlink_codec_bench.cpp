@@ -0,0 +1,182 @@
+// H-Link codec: hand-written encoder/parser against the previous snprintf/strtok/strtoul path.
+
+#include "bench.h"
+
+#include "climate_uart/protocols/hitachi_hlink_codec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace climate_uart;
+using namespace climate_uart::protocols;
+
+namespace {
+
+// Previous implementation, kept verbatim as the reference point.
+namespace legacy {
+
+uint16_t crc(uint16_t address, const uint8_t *data, uint8_t dataLen) {
+	uint16_t sum = 0xFFFF;
+	sum -= (address >> 8) & 0xFF;
+	sum -= address & 0xFF;
+	for (uint8_t i = 0; i < dataLen; i++)
+		sum -= data[i];
+
+	return sum;
+}
+
+size_t encodeFrame(const char *type, uint16_t address, const uint8_t *data, uint8_t dataLen, char *message,
+				   size_t messageSize) {
+	char dataStr[8 * 2 + 1] = {0};
+	for (uint8_t i = 0; i < dataLen && i < 8; i++) {
+		snprintf(&dataStr[i * 2], 3, "%02X", data[i]);
+	}
+
+	uint16_t cs = crc(address, data, dataLen);
+	if (dataLen > 0) {
+		snprintf(message, messageSize, "%s P=%04X,%s C=%04X\r", type, address, dataStr, cs);
+	} else {
+		snprintf(message, messageSize, "%s P=%04X C=%04X\r", type, address, cs);
+	}
+	return strlen(message);
+}
+
+Result parseResponse(const char *line, hlink::Response &response) {
+	response.dataLen = 0;
+	if (strcmp(line, "OK") == 0) {
+		response.status = hlink::Status::Ok;
+		return kSuccess;
+	}
+	if (strcmp(line, "NG") == 0) {
+		response.status = hlink::Status::Ng;
+		return kSuccess;
+	}
+
+	char temp[64];
+	strncpy(temp, line, sizeof(temp));
+	temp[sizeof(temp) - 1] = '\0';
+
+	char *token1 = strtok(temp, " ");
+	char *token2 = strtok(nullptr, " ");
+	char *token3 = strtok(nullptr, " ");
+	if (!token1 || !token2 || !token3) {
+		return kInvalidData;
+	}
+
+	if (strstr(token1, "OK")) {
+		response.status = hlink::Status::Ok;
+	} else if (strstr(token1, "NG")) {
+		response.status = hlink::Status::Ng;
+	} else {
+		response.status = hlink::Status::Invalid;
+		return kInvalidData;
+	}
+
+	if (strncmp(token2, "P=", 2) != 0 || strncmp(token3, "C=", 2) != 0) {
+		return kInvalidData;
+	}
+
+	const char *pStr = token2 + 2;
+	const char *cStr = token3 + 2;
+	int pLen = static_cast<int>(strlen(pStr));
+	if ((pLen % 2) != 0) {
+		return kInvalidData;
+	}
+
+	response.dataLen = static_cast<uint8_t>(pLen / 2);
+	if (response.dataLen > sizeof(response.data)) {
+		return kInvalidData;
+	}
+
+	for (uint8_t i = 0; i < response.dataLen; i++) {
+		char byteStr[3] = {pStr[i * 2], pStr[i * 2 + 1], '\0'};
+		response.data[i] = static_cast<uint8_t>(strtoul(byteStr, nullptr, 16));
+	}
+
+	uint16_t receivedChecksum = static_cast<uint16_t>(strtoul(cStr, nullptr, 16));
+	if (crc(0, response.data, response.dataLen) != receivedChecksum) {
+		return kInvalidCrc;
+	}
+
+	return kSuccess;
+}
+
+}  // namespace legacy
+
+const char *const kResponses[] = {
+	"OK P=0010 C=FFEF",
+	"OK P=01 C=FFFE",
+	"OK P=001A C=FFE5",
+	"\x7FOK P=8040 C=FF3F",
+	"NG",
+	"OK P=0019 C=0000",
+};
+constexpr size_t kResponseCount = sizeof(kResponses) / sizeof(kResponses[0]);
+
+bool sameOutcome() {
+	for (size_t i = 0; i < kResponseCount; i++) {
+		hlink::Response a;
+		hlink::Response b;
+		Result ra = legacy::parseResponse(kResponses[i], a);
+		Result rb = hlink::parseResponse(kResponses[i], b);
+		if (ra != rb || a.status != b.status || a.dataLen != b.dataLen || memcmp(a.data, b.data, a.dataLen) != 0) {
+			printf("parse mismatch on \"%s\": legacy=%d new=%d\n", kResponses[i], ra, rb);
+			return false;
+		}
+	}
+
+	const uint8_t data[] = {0x80, 0x40};
+	char a[hlink::kMaxFrameSize];
+	char b[hlink::kMaxFrameSize];
+	legacy::encodeFrame("ST", 0x0001, data, sizeof(data), a, sizeof(a));
+	hlink::encodeFrame("ST", 0x0001, data, sizeof(data), b, sizeof(b));
+	if (strcmp(a, b) != 0) {
+		printf("encode mismatch: legacy=\"%s\" new=\"%s\"\n", a, b);
+		return false;
+	}
+	legacy::encodeFrame("MT", 0x0100, nullptr, 0, a, sizeof(a));
+	hlink::encodeFrame("MT", 0x0100, nullptr, 0, b, sizeof(b));
+	if (strcmp(a, b) != 0) {
+		printf("encode mismatch: legacy=\"%s\" new=\"%s\"\n", a, b);
+		return false;
+	}
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (!sameOutcome()) {
+		return 1;
+	}
+
+	bench::Reporter reporter("hitachi_hlink_codec", argc, argv);
+
+	const uint8_t data[] = {0x80, 0x40};
+	char frame[hlink::kMaxFrameSize];
+	const size_t frameSize = hlink::encodeFrame("ST", 0x0001, data, sizeof(data), frame, sizeof(frame));
+	reporter.run("hlink/encode (snprintf)", frameSize, [&] {
+		bench::doNotOptimize(legacy::encodeFrame("ST", 0x0001, data, sizeof(data), frame, sizeof(frame)));
+	});
+	reporter.run("hlink/encode", frameSize, [&] {
+		bench::doNotOptimize(hlink::encodeFrame("ST", 0x0001, data, sizeof(data), frame, sizeof(frame)));
+	});
+
+	size_t responseBytes = 0;
+	for (const char *line : kResponses) {
+		responseBytes += strlen(line);
+	}
+	const size_t averageResponseSize = responseBytes / kResponseCount;
+
+	size_t index = 0;
+	hlink::Response response;
+	reporter.run("hlink/parse (strtok/strtoul)", averageResponseSize, [&] {
+		bench::doNotOptimize(legacy::parseResponse(kResponses[index++ % kResponseCount], response));
+	});
+	index = 0;
+	reporter.run("hlink/parse", averageResponseSize, [&] {
+		bench::doNotOptimize(hlink::parseResponse(kResponses[index++ % kResponseCount], response));
+	});
+
+	return reporter.finish();
+}
@@ -0,0 +1,168 @@
+// End-to-end latency of the ClimateInterface operations at each protocol's real line rate.
+// Every run pairs a fresh driver with its emulator (see simulation.h): bytes take their wire
+// time, replies a jittered turnaround, and the numbers are simulated bus time rather than
+// host CPU time.
+
+#include "bench.h"
+#include "simulation.h"
+
+#include "daikin_s21_emulator.h"
+#include "fujitsu_emulator.h"
+#include "hitachi_hlink_emulator.h"
+#include "lg_aircon_emulator.h"
+#include "mitsubishi_emulator.h"
+#include "sharp_emulator.h"
+#include "toshiba_emulator.h"
+
+#include "climate_uart/platform_host.h"
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+
+#include <stdio.h>
+
+using namespace climate_uart;
+using namespace climate_uart::emulators;
+using namespace climate_uart::protocols;
+
+namespace {
+
+// Upper bound on one operation, so a stuck exchange shows up as a failure instead of a hang
+constexpr uint64_t kOperationLimitUs = 30000000;
+
+enum Operation : uint8_t {
+	kInit,
+	kGetState,
+	kSetState,
+	kGetRoomTemperature,
+	kOperationCount,
+};
+
+const char *const kOperationNames[kOperationCount] = {"init", "getState", "setState", "getRoomTemperature"};
+
+struct OperationStats {
+	std::vector<uint64_t> latenciesUs;
+	uint32_t failures{0};
+	uint64_t exchanges{0};
+	uint64_t bytes{0};
+};
+
+// Brackets one operation: simulated time, frames the unit took and bytes on the wire.
+template <typename Sim>
+class Sample {
+public:
+	explicit Sample(Sim &sim)
+		: sim_(&sim), startUs_(sim.nowUs()), frames_(sim.framesReceived()), bytes_(sim.lineBytes()) {}
+
+	uint64_t startUs() const { return startUs_; }
+
+	void end(OperationStats &stats, Result ret) {
+		if (ret == kSuccess) {
+			stats.latenciesUs.push_back(sim_->nowUs() - startUs_);
+		} else {
+			stats.failures++;
+		}
+		stats.exchanges += sim_->framesReceived() - frames_;
+		stats.bytes += sim_->lineBytes() - bytes_;
+	}
+
+private:
+	Sim *sim_;
+	uint64_t startUs_;
+	uint32_t frames_;
+	uint64_t bytes_;
+};
+
+template <typename Driver, typename Emulator, typename Setup>
+void runSession(uint32_t seed, OperationStats *stats, Setup setup) {
+	using Sim = bench::Simulation<Driver, Emulator>;
+	Sim sim(seed);
+
+	// init: open, then service until the driver reports ready (handshakes happen there)
+	Sample<Sim> sample(sim);
+	Result ret = sim.start(kOperationLimitUs, setup);
+	sample.end(stats[kInit], ret);
+	if (ret != kSuccess) {
+		return;
+	}
+
+	// Start each request at a random point of any periodic bus traffic
+	sim.idle(sim.random() % 1000000);
+
+	ClimateSettings settings;
+	sample = Sample<Sim>(sim);
+	sample.end(stats[kGetState], sim.driver().getState(settings));
+
+	// setState counts until the unit has taken the change: on the polled buses the call
+	// only queues it for the next turn.
+	ClimateSettings wanted;
+	wanted.action = HeatpumpAction::On;
+	wanted.mode = HeatpumpMode::Heat;
+	wanted.temperature = 25;
+	wanted.fanSpeed = HeatpumpFanSpeed::High;
+	wanted.vaneMode = HeatpumpVaneMode::Auto;
+	sample = Sample<Sim>(sim);
+	ret = sim.driver().setState(wanted);
+	if (ret == kSuccess && !sim.runUntil(sample.startUs() + kOperationLimitUs,
+										 [&] { return bench::sameSettings(sim.unit().settings(), wanted); })) {
+		ret = kTimeout;
+	}
+	sample.end(stats[kSetState], ret);
+
+	float temperature = 0.0f;
+	sample = Sample<Sim>(sim);
+	sample.end(stats[kGetRoomTemperature], sim.driver().getRoomTemperature(temperature));
+}
+
+template <typename Driver, typename Emulator, typename Setup>
+void measure(bench::LatencyReporter &reporter, const char *protocol, Setup setup) {
+	char names[kOperationCount][64];
+	bool any = false;
+	for (uint8_t op = 0; op < kOperationCount; op++) {
+		snprintf(names[op], sizeof(names[op]), "%s/%s", protocol, kOperationNames[op]);
+		any = any || reporter.selected(names[op]);
+	}
+	if (!any) {
+		return;
+	}
+
+	OperationStats stats[kOperationCount];
+	for (uint32_t i = 0; i < reporter.samples(); i++) {
+		runSession<Driver, Emulator>((i + 1) * 2654435761u, stats, setup);
+	}
+
+	for (uint8_t op = 0; op < kOperationCount; op++) {
+		if (reporter.selected(names[op])) {
+			reporter.add(names[op], stats[op].latenciesUs, stats[op].failures, stats[op].exchanges,
+						 stats[op].bytes);
+		}
+	}
+}
+
+template <typename Driver, typename Emulator>
+void measure(bench::LatencyReporter &reporter, const char *protocol) {
+	measure<Driver, Emulator>(reporter, protocol, [](Emulator &) {});
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	host::set_log_enabled(false);
+	bench::LatencyReporter reporter("latency", argc, argv);
+
+	measure<Mitsubishi, MitsubishiEmulator>(reporter, "mitsubishi");
+	measure<DaikinS21, DaikinS21Emulator>(reporter, "daikin");
+	measure<Toshiba, ToshibaEmulator>(reporter, "toshiba");
+	measure<Sharp, SharpEmulator>(reporter, "sharp");
+	measure<HitachiHLink, HitachiHLinkEmulator>(reporter, "hitachi");
+	measure<LgAircon, LgAirconEmulator>(reporter, "lg");
+	// A full master/controller turn is two 8-byte frames, ~350 ms at 500 baud
+	measure<Fujitsu, FujitsuEmulator>(reporter, "fujitsu",
+									  [](FujitsuEmulator &unit) { unit.setCycleIntervalMs(600); });
+
+	return reporter.finish();
+}
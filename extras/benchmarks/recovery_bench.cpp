@@ -0,0 +1,157 @@
+// Time to get a correct getState() back after a single line fault, per protocol and fault
+// class. Each run changes the unit's settings behind the driver's back, injects one fault
+// into the next frame in one direction, then polls getState() until it returns the unit's
+// new settings. Bit flips exercise the checksum paths (Mitsubishi::readPacket,
+// DaikinS21::readFrame, LgAircon::readMsg, ...), stalls the timeout and reconnect logic.
+
+#include "bench.h"
+#include "simulation.h"
+
+#include "daikin_s21_emulator.h"
+#include "fujitsu_emulator.h"
+#include "hitachi_hlink_emulator.h"
+#include "lg_aircon_emulator.h"
+#include "mitsubishi_emulator.h"
+#include "sharp_emulator.h"
+#include "toshiba_emulator.h"
+
+#include "climate_uart/platform_host.h"
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+
+#include <stdio.h>
+
+using namespace climate_uart;
+using namespace climate_uart::emulators;
+using namespace climate_uart::protocols;
+
+namespace {
+
+// The application's poll period while the state is still wrong
+constexpr uint64_t kPollIntervalUs = 10000;
+// A run that has not recovered by then counts as a failure
+constexpr uint64_t kRecoveryLimitUs = 60000000;
+
+// Fault::Count stands for the fault-free baseline
+const char *const kFaultNames[] = {"bit-flip", "drop", "insert", "stall", "truncate", "nak", "none"};
+
+struct Nak {
+	const uint8_t *bytes;
+	size_t size;
+};
+
+template <typename Driver, typename Emulator, typename Setup>
+void measure(bench::LatencyReporter &reporter, const char *protocol, Nak nak, Setup setup) {
+	for (uint8_t f = 0; f <= static_cast<uint8_t>(Fault::Count); f++) {
+		Fault fault = static_cast<Fault>(f);
+		for (uint8_t d = 0; d < 2; d++) {
+			Direction direction = static_cast<Direction>(d);
+			if (fault == Fault::Count && direction == Direction::ToHost) {
+				continue;
+			}
+			if (fault == Fault::Nak && (direction == Direction::ToDevice || nak.size == 0)) {
+				continue;
+			}
+
+			char name[64];
+			if (fault == Fault::Count) {
+				snprintf(name, sizeof(name), "%s/%s", protocol, kFaultNames[f]);
+			} else {
+				snprintf(name, sizeof(name), "%s/%s %s", protocol, kFaultNames[f],
+						 (direction == Direction::ToDevice) ? "tx" : "rx");
+			}
+			if (!reporter.selected(name)) {
+				continue;
+			}
+
+			std::vector<uint64_t> latencies;
+			uint32_t failures = 0;
+			uint64_t exchanges = 0;
+			uint64_t bytes = 0;
+			for (uint32_t i = 0; i < reporter.samples(); i++) {
+				bench::Simulation<Driver, Emulator> sim((i + 1) * 2654435761u);
+				if (nak.size) {
+					sim.faults().setNakFrame(nak.bytes, nak.size);
+				}
+				if (sim.start(kRecoveryLimitUs, setup) != kSuccess) {
+					failures++;
+					continue;
+				}
+				sim.idle(sim.random() % 1000000);
+
+				// Someone used the remote: only a fresh, intact read shows the change
+				ClimateSettings &unit = sim.unit().settings();
+				unit.action = HeatpumpAction::On;
+				unit.mode = HeatpumpMode::Dry;
+				unit.temperature = 19;
+				unit.fanSpeed = HeatpumpFanSpeed::Low;
+				if (fault != Fault::Count) {
+					sim.faults().inject(direction, fault);
+				}
+
+				uint64_t start = sim.nowUs();
+				uint32_t frames = sim.framesReceived();
+				uint64_t lineBytes = sim.lineBytes();
+				bool recovered = false;
+				while (sim.nowUs() - start < kRecoveryLimitUs) {
+					ClimateSettings settings;
+					if (sim.driver().getState(settings) == kSuccess && bench::sameSettings(settings, unit)) {
+						recovered = true;
+						break;
+					}
+					sim.idle(kPollIntervalUs);
+				}
+
+				// A driver that never wrote (or read) a frame in that direction never met the fault
+				if (fault != Fault::Count && sim.faults().injected(fault) == 0) {
+					continue;
+				}
+
+				if (recovered) {
+					latencies.push_back(sim.nowUs() - start);
+				} else {
+					failures++;
+				}
+				exchanges += sim.framesReceived() - frames;
+				bytes += sim.lineBytes() - lineBytes;
+			}
+
+			if (!latencies.empty() || failures > 0) {
+				reporter.add(name, latencies, failures, exchanges, bytes);
+			}
+		}
+	}
+}
+
+template <typename Driver, typename Emulator>
+void measure(bench::LatencyReporter &reporter, const char *protocol, Nak nak = {nullptr, 0}) {
+	measure<Driver, Emulator>(reporter, protocol, nak, [](Emulator &) {});
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	host::set_log_enabled(false);
+	bench::LatencyReporter reporter("recovery", argc, argv);
+
+	static const uint8_t kDaikinNak[] = {0x15};
+	static const uint8_t kHitachiNak[] = {'N', 'G', '\r'};
+
+	measure<Mitsubishi, MitsubishiEmulator>(reporter, "mitsubishi");
+	measure<DaikinS21, DaikinS21Emulator>(reporter, "daikin", {kDaikinNak, sizeof(kDaikinNak)});
+	measure<Toshiba, ToshibaEmulator>(reporter, "toshiba");
+	measure<Sharp, SharpEmulator>(reporter, "sharp");
+	measure<HitachiHLink, HitachiHLinkEmulator>(reporter, "hitachi", {kHitachiNak, sizeof(kHitachiNak)});
+	// Both only learn about changes made at the unit from its periodic status frames
+	measure<LgAircon, LgAirconEmulator>(reporter, "lg", {nullptr, 0},
+										[](LgAirconEmulator &unit) { unit.setBroadcastIntervalMs(5000); });
+	measure<Fujitsu, FujitsuEmulator>(reporter, "fujitsu", {nullptr, 0},
+									  [](FujitsuEmulator &unit) { unit.setCycleIntervalMs(600); });
+
+	return reporter.finish();
+}
@@ -0,0 +1,230 @@
+// Records a driver session to a capture file, or replays a capture (recorded here or by a
+// UartTransportCapture in the field) into a driver under a virtual clock.
+//
+//   replay_capture record <protocol> <file> [--seconds=60] [--poll-ms=1000] [--noise]
+//   replay_capture replay <protocol> <file> [--poll-ms=1000] [--speed=1]
+//
+// Both run the same application loop: getState() every --poll-ms, service() in between, so a
+// replay of a recorded session drives the same calls at the same times. Recording runs the
+// driver against its emulator (--noise adds bit flips and spurious bytes on the way to the
+// driver). A replay prints what the driver wrote against what was recorded, and the wall
+// time it took; it exits with 1 when the driver diverged from the recording.
+// --speed=<n> replays n times faster, polling n times as often; the drivers' own timeouts
+// do not scale, so only --speed=1 is exact.
+
+#include "simulation.h"
+
+#include "daikin_s21_emulator.h"
+#include "fujitsu_emulator.h"
+#include "hitachi_hlink_emulator.h"
+#include "lg_aircon_emulator.h"
+#include "mitsubishi_emulator.h"
+#include "sharp_emulator.h"
+#include "toshiba_emulator.h"
+
+#include "climate_uart/platform_host.h"
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+#include "climate_uart/transport/uart_transport_replay.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace climate_uart;
+using namespace climate_uart::emulators;
+using namespace climate_uart::protocols;
+
+namespace {
+
+// Matches the MemoryUartLink idle step, so both modes move time the same way
+constexpr uint32_t kIdleStepUs = 100;
+
+struct Args {
+	bool record{false};
+	const char *protocol{nullptr};
+	const char *path{nullptr};
+	uint32_t seconds{60};
+	uint32_t pollMs{1000};
+	uint8_t speed{1};
+	bool noise{false};
+};
+
+void writeFile(const uint8_t *data, size_t size, void *context) {
+	fwrite(data, 1, size, static_cast<FILE *>(context));
+}
+
+void advanceClock(uint32_t dueInUs, void *context) {
+	static_cast<VirtualClock *>(context)->advanceUs((dueInUs < kIdleStepUs) ? dueInUs : kIdleStepUs);
+}
+
+// The application loop; `serviceUnit` runs the emulator when there is one.
+template <typename Driver, typename Fn, typename Done>
+void runSession(Driver &driver, VirtualClock &clock, uint32_t pollMs, Fn serviceUnit, Done done) {
+	uint64_t nextPollUs = clock.nowUs();
+	while (!done()) {
+		uint64_t before = clock.nowUs();
+		if (before >= nextPollUs) {
+			ClimateSettings settings;
+			driver.getState(settings);
+			nextPollUs += pollMs * 1000ull;
+		}
+		driver.service();
+		serviceUnit();
+		if (clock.nowUs() == before) {
+			clock.advanceUs(kIdleStepUs);
+		}
+	}
+}
+
+template <typename Driver, typename Emulator, typename Setup>
+int record(const Args &args, Setup setup) {
+	FILE *file = fopen(args.path, "wb");
+	if (!file) {
+		fprintf(stderr, "replay_capture: cannot write %s\n", args.path);
+		return 1;
+	}
+
+	bench::Simulation<Driver, Emulator> sim(1);
+	sim.capture().setSink(writeFile, file);
+	if (args.noise) {
+		FaultProfile noise;
+		noise.bitFlipPpm = 1000;
+		noise.insertPpm = 1000;
+		sim.faults().setProfile(Direction::ToHost, noise);
+	}
+
+	uint64_t endUs = sim.nowUs() + args.seconds * 1000000ull;
+	sim.driver().init();
+	sim.attach(setup);
+	runSession(sim.driver(), sim.clock(), args.pollMs, [&] { sim.unit().service(); },
+			   [&] { return sim.nowUs() >= endUs; });
+
+	fclose(file);
+	printf("%s: %u capture bytes, %u bytes sent, %u received over %u s\n", args.path,
+		   sim.capture().bytesCaptured(), sim.capture().wireStats().bytesSent, sim.capture().wireStats().bytesReceived,
+		   args.seconds);
+	return 0;
+}
+
+template <typename Driver>
+int replay(const Args &args) {
+	FILE *file = fopen(args.path, "rb");
+	if (!file) {
+		fprintf(stderr, "replay_capture: cannot read %s\n", args.path);
+		return 1;
+	}
+	std::vector<uint8_t> capture;
+	uint8_t chunk[4096];
+	size_t size;
+	while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		capture.insert(capture.end(), chunk, chunk + size);
+	}
+	fclose(file);
+
+	VirtualClock clock;
+	transport::UartTransportReplay uart(capture.data(), capture.size());
+	uart.setSpeed(args.speed);
+	uart.setIdleHook(advanceClock, &clock);
+	Driver driver(uart);
+
+	auto wallStart = std::chrono::steady_clock::now();
+	uint64_t startUs = clock.nowUs();
+	uint64_t durationUs = uart.durationUs() / (args.speed ? args.speed : 1);
+	// A driver stuck waiting for a reply that never comes stops the replay
+	uint64_t limitUs = startUs + 2 * durationUs + 10000000;
+	if (driver.init() != kSuccess) {
+		fprintf(stderr, "%s: not a capture\n", args.path);
+		return 1;
+	}
+	uint32_t pollMs = (args.speed > 1) ? args.pollMs / args.speed : args.pollMs;
+	runSession(driver, clock, pollMs ? pollMs : 1, [] {}, [&] {
+		return (uart.finished() && clock.nowUs() - startUs >= durationUs) || clock.nowUs() >= limitUs;
+	});
+	double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+	transport::WireStats wire = uart.wireStats();
+	MetricsSnapshot metrics;
+	driver.metrics().snapshot(metrics);
+	printf("%s: %s, %.1f s of traffic replayed in %.1f ms\n", args.path, uart.finished() ? "complete" : "stalled",
+		   (clock.nowUs() - startUs) / 1e6, wallMs);
+	printf("  received %u bytes, %u frames ok, %u crc errors, %u resync bytes\n", wire.bytesReceived,
+		   metrics.counter(MetricCounter::FramesReceived), metrics.counter(MetricCounter::CrcErrors),
+		   metrics.counter(MetricCounter::ResyncBytes));
+	printf("  sent %u bytes: %u compared, %u mismatched; %u settings mismatches\n", wire.bytesSent, uart.txCompared(),
+		   uart.txMismatches(), uart.settingsMismatches());
+
+	return (uart.finished() && uart.txMismatches() == 0 && uart.settingsMismatches() == 0) ? 0 : 1;
+}
+
+template <typename Driver, typename Emulator>
+int run(const Args &args) {
+	return args.record ? record<Driver, Emulator>(args, [](Emulator &) {}) : replay<Driver>(args);
+}
+
+int usage() {
+	fprintf(stderr,
+			"usage: replay_capture record <protocol> <file> [--seconds=<n>] [--poll-ms=<n>] [--noise]\n"
+			"       replay_capture replay <protocol> <file> [--poll-ms=<n>] [--speed=<n>]\n"
+			"protocols: mitsubishi daikin toshiba sharp hitachi lg fujitsu\n");
+	return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 4 || (strcmp(argv[1], "record") != 0 && strcmp(argv[1], "replay") != 0)) {
+		return usage();
+	}
+
+	Args args;
+	args.record = strcmp(argv[1], "record") == 0;
+	args.protocol = argv[2];
+	args.path = argv[3];
+	for (int i = 4; i < argc; i++) {
+		if (strncmp(argv[i], "--seconds=", 10) == 0) {
+			args.seconds = static_cast<uint32_t>(strtoul(argv[i] + 10, nullptr, 10));
+		} else if (strncmp(argv[i], "--poll-ms=", 10) == 0) {
+			args.pollMs = static_cast<uint32_t>(strtoul(argv[i] + 10, nullptr, 10));
+		} else if (strncmp(argv[i], "--speed=", 8) == 0) {
+			args.speed = static_cast<uint8_t>(strtoul(argv[i] + 8, nullptr, 10));
+		} else if (strcmp(argv[i], "--noise") == 0) {
+			args.noise = true;
+		} else {
+			return usage();
+		}
+	}
+	if (args.pollMs == 0) {
+		args.pollMs = 1;
+	}
+
+	host::set_log_enabled(false);
+	const char *protocol = args.protocol;
+	if (strcmp(protocol, "mitsubishi") == 0) {
+		return run<Mitsubishi, MitsubishiEmulator>(args);
+	} else if (strcmp(protocol, "daikin") == 0) {
+		return run<DaikinS21, DaikinS21Emulator>(args);
+	} else if (strcmp(protocol, "toshiba") == 0) {
+		return run<Toshiba, ToshibaEmulator>(args);
+	} else if (strcmp(protocol, "sharp") == 0) {
+		return run<Sharp, SharpEmulator>(args);
+	} else if (strcmp(protocol, "hitachi") == 0) {
+		return run<HitachiHLink, HitachiHLinkEmulator>(args);
+	} else if (strcmp(protocol, "lg") == 0) {
+		if (args.record) {
+			return record<LgAircon, LgAirconEmulator>(args,
+													  [](LgAirconEmulator &unit) { unit.setBroadcastIntervalMs(5000); });
+		}
+		return replay<LgAircon>(args);
+	} else if (strcmp(protocol, "fujitsu") == 0) {
+		return run<Fujitsu, FujitsuEmulator>(args);
+	}
+	return usage();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "fault_injection_uart.h"
+#include "memory_uart.h"
+#include "virtual_clock.h"
+
+#include "climate_uart/climate_types.h"
+#include "climate_uart/result.h"
+#include "climate_uart/transport/uart_transport_capture.h"
+
+#include <memory>
+#include <stdint.h>
+
+namespace climate_uart {
+namespace bench {
+
+// Unit turnaround used by the simulated-time benchmarks: a fixed processing delay plus a
+// uniform jitter per reply.
+constexpr uint32_t kReplyLatencyUs = 10000;
+constexpr uint32_t kReplyJitterUs = 20000;
+
+inline uint32_t nextRandom(uint32_t &state) {
+	// xorshift32
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+inline bool sameSettings(const ClimateSettings &a, const ClimateSettings &b) {
+	return a.action == b.action && a.mode == b.mode && a.temperature == b.temperature && a.fanSpeed == b.fanSpeed;
+}
+
+// A driver and its emulated unit on a paced link under a virtual clock, with a fault
+// injector between the driver and the line (idle unless told otherwise), and a capture
+// of what the driver sees (off unless given a sink).
+template <typename Driver, typename Emulator>
+class Simulation {
+public:
+	explicit Simulation(uint32_t seed)
+		: faults_(link_.host(), seed), capture_(faults_), driver_(capture_), random_(seed ? seed : 1) {
+		link_.setPaced(true);
+		link_.setClock(&clock_);
+	}
+
+	// init(), then the unit powers up and the driver is serviced until it reports ready.
+	template <typename Setup>
+	Result start(uint64_t limitUs, Setup setup) {
+		Result ret = driver_.init();
+		if (ret != kSuccess) {
+			return ret;
+		}
+
+		attach(setup);
+		return runUntil(clock_.nowUs() + limitUs, [&] { return driver_.isReady(); }) ? kSuccess : kTimeout;
+	}
+
+	// Powers the unit up. It opens its end with the line settings the driver's init() chose,
+	// so this comes after init().
+	template <typename Setup>
+	Emulator &attach(Setup setup) {
+		emulator_.reset(new Emulator(link_));
+		emulator_->setReplyLatencyUs(kReplyLatencyUs);
+		emulator_->setReplyJitterUs(kReplyJitterUs, random());
+		setup(*emulator_);
+		return *emulator_;
+	}
+
+	// Runs the application loop until done() or the deadline: driver and unit both get
+	// serviced, and time moves on even when neither touches the line.
+	template <typename Done>
+	bool runUntil(uint64_t deadlineUs, Done done) {
+		while (!done()) {
+			if (clock_.nowUs() >= deadlineUs) {
+				return false;
+			}
+			uint64_t before = clock_.nowUs();
+			driver_.service();
+			if (emulator_) {
+				emulator_->service();
+			}
+			if (clock_.nowUs() == before) {
+				clock_.advanceUs(100);
+			}
+		}
+		return true;
+	}
+
+	void idle(uint64_t durationUs) {
+		runUntil(clock_.nowUs() + durationUs, [] { return false; });
+	}
+
+	uint64_t nowUs() const { return clock_.nowUs(); }
+	uint32_t random() { return nextRandom(random_); }
+
+	Driver &driver() { return driver_; }
+	emulators::MemoryUartLink &link() { return link_; }
+	Emulator &unit() { return *emulator_; }
+	emulators::FaultInjectionUart &faults() { return faults_; }
+	transport::UartTransportCapture &capture() { return capture_; }
+	emulators::VirtualClock &clock() { return clock_; }
+
+	// Frames the unit has taken from the line, and bytes that crossed it either way
+	uint32_t framesReceived() const { return emulator_ ? emulator_->framesReceived() : 0; }
+	uint64_t lineBytes() { return link_.device().bytesRead() + link_.device().bytesWritten(); }
+
+private:
+	emulators::VirtualClock clock_;
+	emulators::MemoryUartLink link_;
+	emulators::FaultInjectionUart faults_;
+	transport::UartTransportCapture capture_;
+	Driver driver_;
+	std::unique_ptr<Emulator> emulator_;
+	uint32_t random_;
+};
+
+}  // namespace bench
+}  // namespace climate_uart
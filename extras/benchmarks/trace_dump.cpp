@@ -0,0 +1,152 @@
+// Runs one protocol's driver against its emulator in simulated time (see simulation.h) and
+// writes the trace of init, getState, setState and getRoomTemperature as Chrome trace_event
+// JSON, for chrome://tracing or ui.perfetto.dev. Timestamps are bus time at the protocol's
+// real line rate. Needs a library built with -DCLIMATE_UART_TRACE=ON.
+//
+//   trace_dump toshiba > toshiba.json
+//   trace_dump fujitsu --out=fujitsu.json
+
+#include "simulation.h"
+
+#include "daikin_s21_emulator.h"
+#include "fujitsu_emulator.h"
+#include "hitachi_hlink_emulator.h"
+#include "lg_aircon_emulator.h"
+#include "mitsubishi_emulator.h"
+#include "sharp_emulator.h"
+#include "toshiba_emulator.h"
+
+#include "climate_uart/platform_host.h"
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+#include "climate_uart/trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace climate_uart;
+using namespace climate_uart::emulators;
+using namespace climate_uart::protocols;
+
+#if CLIMATE_UART_TRACE
+
+namespace {
+
+constexpr uint64_t kStartLimitUs = 30000000;
+// Application idle time after the calls, so periodic traffic (Fujitsu bus turns, LG and
+// Sharp broadcasts) shows up too
+constexpr uint64_t kTailUs = 3000000;
+
+TraceEvent events[8192];
+
+void writeFile(const char *data, size_t size, void *context) {
+	fwrite(data, 1, size, static_cast<FILE *>(context));
+}
+
+template <typename Driver, typename Emulator>
+int dump(const char *protocol, FILE *out) {
+	TraceBuffer buffer(events, sizeof(events) / sizeof(events[0]));
+	trace_set_buffer(&buffer);
+
+	{
+		bench::Simulation<Driver, Emulator> sim(1);
+		trace_set_source_name(&sim.driver(), protocol);
+
+		if (sim.start(kStartLimitUs, [](Emulator &) {}) != kSuccess) {
+			fprintf(stderr, "%s: driver never became ready\n", protocol);
+			trace_set_buffer(nullptr);
+			return 1;
+		}
+
+		ClimateSettings settings;
+		sim.driver().getState(settings);
+
+		ClimateSettings wanted = settings;
+		wanted.action = HeatpumpAction::On;
+		wanted.mode = HeatpumpMode::Heat;
+		wanted.temperature = 23;
+		wanted.fanSpeed = HeatpumpFanSpeed::High;
+		sim.driver().setState(wanted);
+
+		float temperature = 0.0f;
+		sim.driver().getRoomTemperature(temperature);
+		sim.idle(kTailUs);
+	}
+
+	trace_set_buffer(nullptr);
+	trace_export_chrome(buffer, writeFile, out);
+	if (buffer.overwritten() > 0) {
+		fprintf(stderr, "%s: trace buffer full, %lu oldest events lost\n", protocol,
+				static_cast<unsigned long>(buffer.overwritten()));
+	}
+	return 0;
+}
+
+int usage() {
+	fprintf(stderr, "usage: trace_dump <mitsubishi|daikin|toshiba|sharp|hitachi|lg|fujitsu> [--out=<file>]\n");
+	return 2;
+}
+
+}  // namespace
+
+#endif
+
+int main(int argc, char **argv) {
+#if !CLIMATE_UART_TRACE
+	(void)argc;
+	(void)argv;
+	fprintf(stderr, "trace_dump: the library was built without trace points, configure with -DCLIMATE_UART_TRACE=ON\n");
+	return 1;
+#else
+	const char *protocol = nullptr;
+	const char *path = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--out=", 6) == 0) {
+			path = argv[i] + 6;
+		} else if (!protocol && argv[i][0] != '-') {
+			protocol = argv[i];
+		} else {
+			return usage();
+		}
+	}
+	if (!protocol) {
+		return usage();
+	}
+
+	FILE *out = path ? fopen(path, "w") : stdout;
+	if (!out) {
+		fprintf(stderr, "trace_dump: cannot write %s\n", path);
+		return 1;
+	}
+
+	host::set_log_enabled(false);
+	int ret;
+	if (strcmp(protocol, "mitsubishi") == 0) {
+		ret = dump<Mitsubishi, MitsubishiEmulator>(protocol, out);
+	} else if (strcmp(protocol, "daikin") == 0) {
+		ret = dump<DaikinS21, DaikinS21Emulator>(protocol, out);
+	} else if (strcmp(protocol, "toshiba") == 0) {
+		ret = dump<Toshiba, ToshibaEmulator>(protocol, out);
+	} else if (strcmp(protocol, "sharp") == 0) {
+		ret = dump<Sharp, SharpEmulator>(protocol, out);
+	} else if (strcmp(protocol, "hitachi") == 0) {
+		ret = dump<HitachiHLink, HitachiHLinkEmulator>(protocol, out);
+	} else if (strcmp(protocol, "lg") == 0) {
+		ret = dump<LgAircon, LgAirconEmulator>(protocol, out);
+	} else if (strcmp(protocol, "fujitsu") == 0) {
+		ret = dump<Fujitsu, FujitsuEmulator>(protocol, out);
+	} else {
+		ret = usage();
+	}
+
+	if (path) {
+		fclose(out);
+	}
+	return ret;
+#endif
+}
@@ -0,0 +1,253 @@
+// Worst-case blocking time of every ClimateInterface call that can reach the line, against
+// misbehaving units, in simulated time. Peers: a healthy emulator, a silent unit, a babbling
+// line (random bytes mixed with the protocol's start bytes) and a slow-drip emulator whose
+// replies arrive one byte at a time with gaps up to just under a second. The harness
+// prints the longest time spent inside each call and exits with 1 when one exceeds the
+// bound declared for it below.
+
+#include "bench.h"
+#include "simulation.h"
+
+#include "adversarial_peers.h"
+#include "daikin_s21_emulator.h"
+#include "fujitsu_emulator.h"
+#include "hitachi_hlink_emulator.h"
+#include "lg_aircon_emulator.h"
+#include "mitsubishi_emulator.h"
+#include "sharp_emulator.h"
+#include "toshiba_emulator.h"
+
+#include "climate_uart/platform_host.h"
+#include "climate_uart/protocols/daikin_s21.h"
+#include "climate_uart/protocols/fujitsu.h"
+#include "climate_uart/protocols/hitachi_hlink.h"
+#include "climate_uart/protocols/lg_aircon.h"
+#include "climate_uart/protocols/mitsubishi.h"
+#include "climate_uart/protocols/sharp.h"
+#include "climate_uart/protocols/toshiba.h"
+
+#include <stdio.h>
+
+using namespace climate_uart;
+using namespace climate_uart::emulators;
+using namespace climate_uart::protocols;
+
+namespace {
+
+enum Call : uint8_t {
+	kInit,
+	kService,
+	kGetState,
+	kSetState,
+	kGetRoomTemperature,
+	kRefresh,
+	kCallCount,
+};
+
+enum Peer : uint8_t {
+	kHealthy,
+	kSilent,
+	kBabbling,
+	kSlowDrip,
+	kPeerCount,
+};
+
+const char *const kCallNames[kCallCount] = {"init", "service", "getState", "setState", "getRoomTemperature",
+											"refresh"};
+const char *const kPeerNames[kPeerCount] = {"healthy", "silent", "babbling", "slow-drip"};
+
+// Gaps between the bytes of a slow-drip reply, cycled through the runs
+const uint32_t kDripGapsUs[] = {10000, 100000, 250000, 490000, 990000};
+// Calls per run after init(), and the application idle time between them
+constexpr uint8_t kRounds = 3;
+constexpr uint32_t kMaxIdleUs = 500000;
+// The unit powers off this long into a call, so a driver that would never return still ends
+// (against a dead line) and shows up as a bound violation rather than a hang.
+constexpr uint64_t kCallCapUs = 300000000;
+
+// Declared worst cases, in ms of bus time, per call
+struct Bounds {
+	const char *protocol;
+	uint32_t ms[kCallCount];
+};
+
+struct Worst {
+	uint64_t us[kPeerCount][kCallCount];
+};
+
+class Harness {
+public:
+	Harness(int argc, char **argv) { options_.parse("wcet", argc, argv); }
+
+	uint32_t runs() const { return options_.samples; }
+	bool selected(const char *protocol) const { return options_.selected(protocol); }
+
+	void report(const Bounds &bounds, const Worst &worst) {
+		for (uint8_t call = 0; call < kCallCount; call++) {
+			uint64_t maxUs = 0;
+			for (uint8_t peer = 0; peer < kPeerCount; peer++) {
+				if (worst.us[peer][call] > maxUs) {
+					maxUs = worst.us[peer][call];
+				}
+			}
+			bool ok = maxUs <= static_cast<uint64_t>(bounds.ms[call]) * 1000;
+			violations_ += ok ? 0 : 1;
+
+			char name[64];
+			snprintf(name, sizeof(name), "%s/%s", bounds.protocol, kCallNames[call]);
+			if (options_.json) {
+				printf("%s  {\"name\": \"%s\"", first_ ? "" : ",\n", name);
+				for (uint8_t peer = 0; peer < kPeerCount; peer++) {
+					printf(", \"%s_ms\": %.1f", kPeerNames[peer], worst.us[peer][call] / 1000.0);
+				}
+				printf(", \"bound_ms\": %u, \"ok\": %s}", bounds.ms[call], ok ? "true" : "false");
+			} else {
+				if (first_) {
+					printf("%-32s %10s %10s %10s %10s %10s\n", "call (max ms)", kPeerNames[kHealthy],
+						   kPeerNames[kSilent], kPeerNames[kBabbling], kPeerNames[kSlowDrip], "bound");
+				}
+				printf("%-32s", name);
+				for (uint8_t peer = 0; peer < kPeerCount; peer++) {
+					printf(" %10.1f", worst.us[peer][call] / 1000.0);
+				}
+				printf(" %10u%s\n", bounds.ms[call], ok ? "" : "  EXCEEDED");
+			}
+			first_ = false;
+		}
+	}
+
+	int finish() {
+		if (options_.json) {
+			printf("\n]}\n");
+		} else if (violations_ > 0) {
+			printf("%u call(s) exceeded their bound\n", violations_);
+		}
+		return violations_ ? 1 : 0;
+	}
+
+	void begin() {
+		if (options_.json) {
+			printf("{\"suite\": \"wcet\", \"results\": [\n");
+		}
+	}
+
+private:
+	bench::Options options_;
+	bool first_{true};
+	uint32_t violations_{0};
+};
+
+ClimateSettings randomSettings(uint32_t value) {
+	ClimateSettings settings;
+	settings.action = (value & 1) ? HeatpumpAction::On : HeatpumpAction::Off;
+	settings.mode = static_cast<HeatpumpMode>(1 + (value >> 1) % (static_cast<uint8_t>(HeatpumpMode::Count) - 1));
+	settings.fanSpeed =
+		static_cast<HeatpumpFanSpeed>(1 + (value >> 4) % (static_cast<uint8_t>(HeatpumpFanSpeed::Count) - 1));
+	settings.vaneMode = static_cast<HeatpumpVaneMode>((value >> 7) % static_cast<uint8_t>(HeatpumpVaneMode::Count));
+	settings.temperature = 18 + static_cast<int>((value >> 10) % 12);
+	return settings;
+}
+
+// Times one call; the unit is powered for at most kCallCapUs of it.
+template <typename Sim, typename Unit, typename Fn>
+void timed(Sim &sim, Unit *unit, uint64_t &worstUs, Fn fn) {
+	if (unit) {
+		unit->setOnline(true);
+		unit->setPowerOffAtUs(sim.nowUs() + kCallCapUs);
+	}
+	uint64_t start = sim.nowUs();
+	fn();
+	uint64_t elapsed = sim.nowUs() - start;
+	if (elapsed > worstUs) {
+		worstUs = elapsed;
+	}
+}
+
+// One run against one peer: init, then rounds of every call with idle service() in between.
+template <typename Driver, typename Unit, typename Setup>
+void run(uint32_t seed, bool singleWire, Setup setup, uint64_t *worst) {
+	using Sim = bench::Simulation<Driver, Unit>;
+	Sim sim(seed);
+	sim.link().setHostEcho(singleWire);
+	Driver &driver = sim.driver();
+
+	timed(sim, static_cast<Unit *>(nullptr), worst[kInit], [&] { driver.init(); });
+	Unit *unit = &sim.attach(setup);
+
+	for (uint8_t round = 0; round < kRounds; round++) {
+		uint64_t idleUntil = sim.nowUs() + sim.random() % kMaxIdleUs;
+		while (sim.nowUs() < idleUntil) {
+			uint64_t before = sim.nowUs();
+			timed(sim, unit, worst[kService], [&] { driver.service(); });
+			unit->service();
+			if (sim.nowUs() == before) {
+				sim.idle(100);
+			}
+		}
+
+		ClimateSettings settings;
+		float temperature = 0.0f;
+		ClimateSettings wanted = randomSettings(sim.random());
+		timed(sim, unit, worst[kGetState], [&] { driver.getState(settings); });
+		timed(sim, unit, worst[kSetState], [&] { driver.setState(wanted); });
+		timed(sim, unit, worst[kGetRoomTemperature], [&] { driver.getRoomTemperature(temperature); });
+		timed(sim, unit, worst[kRefresh], [&] { driver.refresh(kAllFields); });
+	}
+}
+
+template <typename Driver, typename Emulator>
+void check(Harness &harness, const Bounds &bounds, const uint8_t *hotBytes, size_t hotCount, bool singleWire) {
+	if (!harness.selected(bounds.protocol)) {
+		return;
+	}
+
+	Worst worst{};
+	for (uint32_t i = 0; i < harness.runs(); i++) {
+		uint32_t seed = (i + 1) * 2654435761u;
+		run<Driver, Emulator>(seed, singleWire, [](Emulator &) {}, worst.us[kHealthy]);
+		run<Driver, SilentPeer>(seed, singleWire, [](SilentPeer &) {}, worst.us[kSilent]);
+		run<Driver, BabblingPeer>(
+			seed, singleWire, [&](BabblingPeer &peer) { peer.setHotBytes(hotBytes, hotCount); }, worst.us[kBabbling]);
+		uint32_t gap = kDripGapsUs[i % (sizeof(kDripGapsUs) / sizeof(kDripGapsUs[0]))];
+		run<Driver, Emulator>(seed, singleWire, [&](Emulator &unit) { unit.setByteGapUs(gap); }, worst.us[kSlowDrip]);
+	}
+	harness.report(bounds, worst);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	host::set_log_enabled(false);
+	Harness harness(argc, argv);
+	harness.begin();
+
+	// Start-of-frame bytes the babbler favours
+	static const uint8_t kMitsubishiHot[] = {0xFC, 0x62, 0x7A, 0x10};
+	static const uint8_t kDaikinHot[] = {0x02, 0x03, 0x06, 0x15};
+	static const uint8_t kToshibaHot[] = {0x02, 0x00, 0x03};
+	static const uint8_t kSharpHot[] = {0xDD, 0x02, 0x03};
+	static const uint8_t kHitachiHot[] = {'O', 'K', 'N', 'G', ' ', 'P', '=', 'C', '\r'};
+	static const uint8_t kLgHot[] = {0xC8, 0xA8};
+	static const uint8_t kFujitsuHot[] = {0xFE, 0xDF, 0xFF};
+
+	// init service getState setState getRoomTemperature refresh
+	static const Bounds kMitsubishi = {"mitsubishi", {10, 3000, 3000, 3000, 3000, 3000}};
+	static const Bounds kDaikin = {"daikin", {10, 10, 2000, 1000, 2000, 2000}};
+	static const Bounds kToshiba = {"toshiba", {10, 1500, 6000, 6000, 6000, 6000}};
+	static const Bounds kSharp = {"sharp", {10, 1500, 6000, 1500, 1500, 1500}};
+	static const Bounds kHitachi = {"hitachi", {10, 10, 4500, 1000, 1000, 4500}};
+	// Every read waits up to one status cycle: our frame's echo, then the unit's (readStatus)
+	static const Bounds kLg = {"lg", {10, 3500, 3500, 3500, 3500, 3500}};
+	// Calls made before the unit has logged us onto the bus wait for it (waitForLogin)
+	static const Bounds kFujitsu = {"fujitsu", {10, 10, 10500, 10500, 10500, 10500}};
+
+	check<Mitsubishi, MitsubishiEmulator>(harness, kMitsubishi, kMitsubishiHot, sizeof(kMitsubishiHot), false);
+	check<DaikinS21, DaikinS21Emulator>(harness, kDaikin, kDaikinHot, sizeof(kDaikinHot), false);
+	check<Toshiba, ToshibaEmulator>(harness, kToshiba, kToshibaHot, sizeof(kToshibaHot), false);
+	check<Sharp, SharpEmulator>(harness, kSharp, kSharpHot, sizeof(kSharpHot), false);
+	check<HitachiHLink, HitachiHLinkEmulator>(harness, kHitachi, kHitachiHot, sizeof(kHitachiHot), false);
+	check<LgAircon, LgAirconEmulator>(harness, kLg, kLgHot, sizeof(kLgHot), true);
+	check<Fujitsu, FujitsuEmulator>(harness, kFujitsu, kFujitsuHot, sizeof(kFujitsuHot), true);
+
+	return harness.finish();
+}
@@ -0,0 +1,41 @@
+#include "adversarial_peers.h"
+
+namespace climate_uart {
+namespace emulators {
+
+BabblingPeer::BabblingPeer(MemoryUartLink &link, uint32_t seed) : DeviceEmulator(link), random_(seed ? seed : 1) {}
+
+uint32_t BabblingPeer::nextRandom() {
+    // xorshift32
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    return random_;
+}
+
+void BabblingPeer::onTick(uint64_t nowUs) {
+    // Keep the line busy up to now, one character time per byte
+    uint32_t charUs = link_.charTimeUs();
+    if (sentUntilUs_ < nowUs) {
+        sentUntilUs_ = nowUs;
+    }
+    if (sentUntilUs_ > nowUs + charUs) {
+        return;
+    }
+
+    uint8_t bytes[16];
+    size_t count = 0;
+    while (count < sizeof(bytes) && sentUntilUs_ <= nowUs + charUs) {
+        uint32_t value = nextRandom();
+        if (!hot_.empty() && (value & 0x300) == 0) {
+            bytes[count++] = hot_[(value >> 10) % hot_.size()];
+        } else {
+            bytes[count++] = static_cast<uint8_t>(value);
+        }
+        sentUntilUs_ += charUs;
+    }
+    sendNow(bytes, count);
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
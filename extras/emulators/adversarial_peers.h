@@ -0,0 +1,41 @@
+#pragma once
+
+#include "device_emulator.h"
+
+#include <vector>
+
+namespace climate_uart {
+namespace emulators {
+
+// A unit that is powered but never answers: the driver only ever meets its timeouts.
+class SilentPeer : public DeviceEmulator {
+public:
+    explicit SilentPeer(MemoryUartLink &link) : DeviceEmulator(link) {}
+
+protected:
+    void onByte(uint8_t byte) override { (void)byte; }
+};
+
+// A unit, or a broken cable, that keeps the line saturated with garbage. Bytes are random,
+// with one in four drawn from the "hot" set when one is given (a protocol's start-of-frame
+// bytes), so frame hunters keep locking onto false starts.
+class BabblingPeer : public DeviceEmulator {
+public:
+    explicit BabblingPeer(MemoryUartLink &link, uint32_t seed = 1);
+
+    void setHotBytes(const uint8_t *bytes, size_t size) { hot_.assign(bytes, bytes + size); }
+
+protected:
+    void onByte(uint8_t byte) override { (void)byte; }
+    void onTick(uint64_t nowUs) override;
+
+private:
+    uint32_t nextRandom();
+
+    std::vector<uint8_t> hot_;
+    uint32_t random_;
+    uint64_t sentUntilUs_{0};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,107 @@
+#include "daikin_s21_emulator.h"
+
+#include <stdio.h>
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint8_t kStx = 0x02;
+constexpr uint8_t kEtx = 0x03;
+constexpr uint8_t kAck = 0x06;
+constexpr uint8_t kNak = 0x15;
+constexpr int kSetpointOffset = 28;
+
+// Indexed by the library enums
+constexpr uint8_t kModes[] = {'0', '3', '2', '6', '1', '4'};
+constexpr uint8_t kFans[] = {'A', 'A', '7', '5', '3', 'B'};
+}  // namespace
+
+DaikinS21Emulator::DaikinS21Emulator(MemoryUartLink &link) : DeviceEmulator(link) {}
+
+uint8_t DaikinS21Emulator::checksum(const uint8_t *bytes, size_t len) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum = static_cast<uint8_t>(sum + bytes[i]);
+    }
+    return sum;
+}
+
+void DaikinS21Emulator::onByte(uint8_t byte) {
+    if (!inFrame_) {
+        // ACKs of our replies and line noise between frames
+        if (byte == kStx) {
+            inFrame_ = true;
+            rxCount_ = 0;
+        }
+        return;
+    }
+
+    if (byte != kEtx) {
+        if (rxCount_ < sizeof(rx_)) {
+            rx_[rxCount_++] = byte;
+        }
+        return;
+    }
+
+    inFrame_ = false;
+    if (rxCount_ < 3 || checksum(rx_, rxCount_ - 1u) != rx_[rxCount_ - 1]) {
+        uint8_t nak = kNak;
+        sendFrame(&nak, 1);
+        return;
+    }
+
+    countFrameReceived();
+    handleFrame(rx_, static_cast<uint8_t>(rxCount_ - 1));
+}
+
+void DaikinS21Emulator::handleFrame(const uint8_t *payload, uint8_t size) {
+    uint8_t ack = kAck;
+    sendFrame(&ack, 1);
+
+    if (payload[0] == 'F' && payload[1] == '1') {
+        uint8_t out[] = {'G', '1', static_cast<uint8_t>(settings_.action == HeatpumpAction::On ? '1' : '0'),
+                         kModes[static_cast<uint8_t>(settings_.mode)],
+                         static_cast<uint8_t>(settings_.temperature * 2 + kSetpointOffset),
+                         kFans[static_cast<uint8_t>(settings_.fanSpeed)]};
+        reply(out, sizeof(out));
+    } else if (payload[0] == 'F' && payload[1] == '5') {
+        uint8_t bits = (settings_.vaneMode == HeatpumpVaneMode::Swing) ? 7 : 0;
+        uint8_t out[] = {'G', '5', static_cast<uint8_t>('0' + bits), static_cast<uint8_t>(bits ? '?' : '0'), '0', '0'};
+        reply(out, sizeof(out));
+    } else if (payload[0] == 'R' && payload[1] == 'H') {
+        char digits[12];
+        int len = snprintf(digits, sizeof(digits), "SH%d", static_cast<int>(roomTemperature_ * 10.0f));
+        reply(reinterpret_cast<const uint8_t *>(digits), static_cast<uint8_t>(len));
+    } else if (payload[0] == 'D' && payload[1] == '1' && size >= 6) {
+        settings_.action = (payload[2] == '1') ? HeatpumpAction::On : HeatpumpAction::Off;
+        for (uint8_t i = 1; i < sizeof(kModes); i++) {
+            if (payload[3] == kModes[i]) {
+                settings_.mode = static_cast<HeatpumpMode>(i);
+            }
+        }
+        settings_.temperature = ((payload[4] - kSetpointOffset) * 5) / 10;
+        for (uint8_t i = 1; i < sizeof(kFans); i++) {
+            if (payload[5] == kFans[i]) {
+                settings_.fanSpeed = static_cast<HeatpumpFanSpeed>(i);
+                break;
+            }
+        }
+    } else if (payload[0] == 'D' && payload[1] == '5' && size >= 3) {
+        settings_.vaneMode = ((payload[2] - '0') & 3) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+    }
+}
+
+void DaikinS21Emulator::reply(const uint8_t *payload, uint8_t size) {
+    uint8_t buffer[40];
+    buffer[0] = kStx;
+    for (uint8_t i = 0; i < size; i++) {
+        buffer[1 + i] = payload[i];
+    }
+    buffer[1 + size] = checksum(payload, size);
+    buffer[2 + size] = kEtx;
+    sendFrame(buffer, size + 3u);
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "device_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+// S21 unit: acknowledges every frame, answers F1/F5/RH with G1/G5/SH and applies D1/D5.
+class DaikinS21Emulator : public DeviceEmulator {
+public:
+    explicit DaikinS21Emulator(MemoryUartLink &link);
+
+protected:
+    void onByte(uint8_t byte) override;
+
+private:
+    static uint8_t checksum(const uint8_t *bytes, size_t len);
+
+    void handleFrame(const uint8_t *payload, uint8_t size);
+    void reply(const uint8_t *payload, uint8_t size);
+
+    uint8_t rx_[64]{};
+    uint8_t rxCount_{0};
+    bool inFrame_{false};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
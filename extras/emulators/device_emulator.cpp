@@ -0,0 +1,117 @@
+#include "device_emulator.h"
+
+#include "climate_uart/platform_host.h"
+
+namespace climate_uart {
+namespace emulators {
+
+DeviceEmulator::DeviceEmulator(MemoryUartLink &link) : link_(link) {
+    settings_.action = HeatpumpAction::Off;
+    settings_.mode = HeatpumpMode::Cold;
+    settings_.temperature = 22;
+    settings_.fanSpeed = HeatpumpFanSpeed::Auto;
+    settings_.vaneMode = HeatpumpVaneMode::Auto;
+
+    link_.device().open(link_.baudrate(), link_.parity(), link_.stopBits());
+    link_.setPollHook(&DeviceEmulator::pollHook, this);
+}
+
+DeviceEmulator::~DeviceEmulator() {
+    link_.setPollHook(nullptr, nullptr);
+}
+
+void DeviceEmulator::pollHook(void *context) {
+    static_cast<DeviceEmulator *>(context)->service();
+}
+
+void DeviceEmulator::service() {
+    transport::UartTransport &uart = link_.device();
+    uint64_t now = host::time_now_us();
+    if (powerOffAtUs_ != 0 && now >= powerOffAtUs_) {
+        online_ = false;
+    }
+
+    uint8_t buffer[64];
+    size_t size = sizeof(buffer);
+    while (uart.read(buffer, &size) == kSuccess && size > 0) {
+        if (online_) {
+            for (size_t i = 0; i < size; i++) {
+                onByte(buffer[i]);
+            }
+        }
+        size = sizeof(buffer);
+    }
+
+    if (!online_) {
+        pending_.clear();
+        return;
+    }
+    onTick(now);
+
+    while (!pending_.empty() && pending_.front().dueUs <= now) {
+        transmit(pending_.front().bytes.data(), pending_.front().bytes.size());
+        pending_.pop_front();
+    }
+}
+
+void DeviceEmulator::setReplyJitterUs(uint32_t maxUs, uint32_t seed) {
+    replyJitterUs_ = maxUs;
+    jitterState_ = seed ? seed : 1;
+}
+
+uint32_t DeviceEmulator::nextJitterUs() {
+    if (replyJitterUs_ == 0) {
+        return 0;
+    }
+
+    // xorshift32
+    jitterState_ ^= jitterState_ << 13;
+    jitterState_ ^= jitterState_ >> 17;
+    jitterState_ ^= jitterState_ << 5;
+    return jitterState_ % (replyJitterUs_ + 1);
+}
+
+void DeviceEmulator::sendFrame(const uint8_t *data, size_t size) {
+    framesSent_++;
+    uint32_t latency = replyLatencyUs_ + nextJitterUs();
+    if (latency == 0 && byteGapUs_ == 0 && pending_.empty()) {
+        transmit(data, size);
+        return;
+    }
+    schedule(host::time_now_us() + latency, data, size);
+}
+
+void DeviceEmulator::sendNow(const uint8_t *data, size_t size) {
+    framesSent_++;
+    if (byteGapUs_ == 0) {
+        transmit(data, size);
+        return;
+    }
+    schedule(host::time_now_us(), data, size);
+}
+
+void DeviceEmulator::schedule(uint64_t dueUs, const uint8_t *data, size_t size) {
+    // Replies never overtake each other
+    if (!pending_.empty() && pending_.back().dueUs > dueUs) {
+        dueUs = pending_.back().dueUs;
+    }
+
+    if (byteGapUs_ == 0) {
+        pending_.push_back({dueUs, std::vector<uint8_t>(data, data + size)});
+        return;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        if (i > 0 || !pending_.empty()) {
+            dueUs += byteGapUs_;
+        }
+        pending_.push_back({dueUs, std::vector<uint8_t>(data + i, data + i + 1)});
+    }
+}
+
+void DeviceEmulator::transmit(const uint8_t *data, size_t size) {
+    link_.device().write(data, size);
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
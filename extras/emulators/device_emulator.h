@@ -0,0 +1,87 @@
+#pragma once
+
+#include "memory_uart.h"
+
+#include "climate_uart/climate_types.h"
+
+#include <deque>
+#include <vector>
+
+namespace climate_uart {
+namespace emulators {
+
+// Base of the in-memory units. An emulator owns the device end of a MemoryUartLink and runs
+// whenever the driver polls the host end, so drivers can be exercised with their real
+// blocking loops. Subclasses parse requests in onByte() and answer through sendFrame().
+class DeviceEmulator {
+public:
+    explicit DeviceEmulator(MemoryUartLink &link);
+    virtual ~DeviceEmulator();
+
+    DeviceEmulator(const DeviceEmulator &) = delete;
+    DeviceEmulator &operator=(const DeviceEmulator &) = delete;
+
+    // Drains received bytes, runs periodic work and releases replies that are due.
+    void service();
+
+    // Unit state; the driver reads it back and setState() commands land here.
+    ClimateSettings &settings() { return settings_; }
+    const ClimateSettings &settings() const { return settings_; }
+    float roomTemperature() const { return roomTemperature_; }
+    void setRoomTemperature(float temperature) { roomTemperature_ = temperature; }
+
+    // Delay between the end of a request and the first byte of the reply.
+    void setReplyLatencyUs(uint32_t latencyUs) { replyLatencyUs_ = latencyUs; }
+    // Adds a uniform 0..maxUs to each reply's latency, from a seeded generator so runs repeat.
+    void setReplyJitterUs(uint32_t maxUs, uint32_t seed = 1);
+    // Slow drip: every frame, replies and broadcasts alike, goes out one byte at a time with
+    // gapUs between bytes. 0 sends frames back to back.
+    void setByteGapUs(uint32_t gapUs) { byteGapUs_ = gapUs; }
+    // An offline unit ignores everything it receives and stops broadcasting.
+    // Queued replies are lost.
+    void setOnline(bool online) { online_ = online; }
+    bool online() const { return online_; }
+    // Goes offline by itself once simulated time reaches timeUs; 0 cancels.
+    void setPowerOffAtUs(uint64_t timeUs) { powerOffAtUs_ = timeUs; }
+
+    uint32_t framesReceived() const { return framesReceived_; }
+    uint32_t framesSent() const { return framesSent_; }
+
+protected:
+    virtual void onByte(uint8_t byte) = 0;
+    virtual void onTick(uint64_t nowUs) { (void)nowUs; }
+
+    // Queues a reply for replyLatencyUs from now, after any reply already queued.
+    void sendFrame(const uint8_t *data, size_t size);
+    // Writes straight to the link, for unsolicited traffic.
+    void sendNow(const uint8_t *data, size_t size);
+    void countFrameReceived() { framesReceived_++; }
+
+    MemoryUartLink &link_;
+    ClimateSettings settings_;
+    float roomTemperature_{21.0f};
+
+private:
+    struct PendingReply {
+        uint64_t dueUs;
+        std::vector<uint8_t> bytes;
+    };
+
+    static void pollHook(void *context);
+    uint32_t nextJitterUs();
+    void schedule(uint64_t dueUs, const uint8_t *data, size_t size);
+    void transmit(const uint8_t *data, size_t size);
+
+    std::deque<PendingReply> pending_;
+    uint32_t replyLatencyUs_{0};
+    uint32_t replyJitterUs_{0};
+    uint32_t byteGapUs_{0};
+    uint32_t jitterState_{1};
+    bool online_{true};
+    uint64_t powerOffAtUs_{0};
+    uint32_t framesReceived_{0};
+    uint32_t framesSent_{0};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,216 @@
+#include "fault_injection_uart.h"
+
+#include "climate_uart/platform_host.h"
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint8_t bit(Fault fault) {
+    return static_cast<uint8_t>(1u << static_cast<uint8_t>(fault));
+}
+}  // namespace
+
+FaultInjectionUart::FaultInjectionUart(transport::UartTransport &inner, uint32_t seed)
+    : inner_(inner), random_(seed ? seed : 1) {
+    scratch_.reserve(64);
+}
+
+Result FaultInjectionUart::open(uint32_t baudrate, transport::UartParity parity, uint8_t stopBits) {
+    if (baudrate == 0) {
+        return kInvalidParameters;
+    }
+
+    frameGapUs_ = static_cast<uint32_t>(3ull * transport::bitsPerChar(parity, stopBits) * 1000000ull / baudrate);
+    rx_.clear();
+    for (Lane &lane : lanes_) {
+        lane.frameLength = 0;
+        lane.stallUntilUs = 0;
+    }
+    wireOpened(baudrate, parity, stopBits);
+    return inner_.open(baudrate, parity, stopBits);
+}
+
+Result FaultInjectionUart::close() {
+    rx_.clear();
+    return inner_.close();
+}
+
+void FaultInjectionUart::setProfile(Direction direction, const FaultProfile &profile) {
+    lanes_[static_cast<uint8_t>(direction)].profile = profile;
+}
+
+void FaultInjectionUart::inject(Direction direction, Fault fault) {
+    if (fault != Fault::Count) {
+        lanes_[static_cast<uint8_t>(direction)].armed |= bit(fault);
+    }
+}
+
+void FaultInjectionUart::setNakFrame(const uint8_t *bytes, size_t size) {
+    nakFrame_.assign(bytes, bytes + size);
+}
+
+uint32_t FaultInjectionUart::nextRandom() {
+    // xorshift32
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    return random_;
+}
+
+bool FaultInjectionUart::roll(uint32_t ppm) {
+    return ppm != 0 && (nextRandom() % 1000000u) < ppm;
+}
+
+void FaultInjectionUart::beginFrame(Lane &lane, Direction direction, uint32_t expectedLength, uint64_t nowUs) {
+    if (lane.frameLength > 0) {
+        lane.lastFrameLength = lane.frameLength;
+    }
+    lane.frameLength = 0;
+    lane.truncateAt = 0;
+    lane.nak = false;
+
+    // A byte fault aimed past the end of the last frame moves on to this one
+    for (uint8_t i = 0; i < 3; i++) {
+        if (lane.bytePosition[i] >= 0) {
+            lane.armed |= bit(static_cast<Fault>(i));
+            lane.bytePosition[i] = -1;
+        }
+    }
+
+    uint32_t length = expectedLength ? expectedLength : lane.lastFrameLength;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (lane.armed & bit(static_cast<Fault>(i))) {
+            lane.armed &= static_cast<uint8_t>(~bit(static_cast<Fault>(i)));
+            lane.bytePosition[i] = static_cast<int32_t>(nextRandom() % length);
+        }
+    }
+
+    if ((lane.armed & bit(Fault::Stall)) || roll(lane.profile.stallPpm)) {
+        lane.armed &= static_cast<uint8_t>(~bit(Fault::Stall));
+        lane.stallUntilUs = nowUs + lane.profile.stallUs;
+        injected_[static_cast<uint8_t>(Fault::Stall)]++;
+    }
+
+    if (((lane.armed & bit(Fault::Truncate)) || roll(lane.profile.truncatePpm)) && length > 1) {
+        lane.armed &= static_cast<uint8_t>(~bit(Fault::Truncate));
+        lane.truncateAt = 1 + nextRandom() % (length - 1);
+        injected_[static_cast<uint8_t>(Fault::Truncate)]++;
+    }
+
+    if ((lane.armed & bit(Fault::Nak)) || roll(lane.profile.nakPpm)) {
+        lane.armed &= static_cast<uint8_t>(~bit(Fault::Nak));
+        // Only a unit answers with a NAK
+        if (direction == Direction::ToHost && !nakFrame_.empty()) {
+            lane.nak = true;
+            rx_.insert(rx_.end(), nakFrame_.begin(), nakFrame_.end());
+            injected_[static_cast<uint8_t>(Fault::Nak)]++;
+        }
+    }
+}
+
+void FaultInjectionUart::processByte(Lane &lane, uint8_t byte, uint64_t nowUs, std::vector<uint8_t> &out) {
+    int32_t position = static_cast<int32_t>(lane.frameLength++);
+    lane.lastByteUs = nowUs;
+
+    if (nowUs < lane.stallUntilUs || lane.nak) {
+        return;
+    }
+    if (lane.truncateAt && static_cast<uint32_t>(position) >= lane.truncateAt) {
+        return;
+    }
+
+    int32_t *target = lane.bytePosition;
+    if (position == target[static_cast<uint8_t>(Fault::Drop)] || roll(lane.profile.dropPpm)) {
+        target[static_cast<uint8_t>(Fault::Drop)] = -1;
+        injected_[static_cast<uint8_t>(Fault::Drop)]++;
+        return;
+    }
+
+    if (position == target[static_cast<uint8_t>(Fault::BitFlip)] || roll(lane.profile.bitFlipPpm)) {
+        target[static_cast<uint8_t>(Fault::BitFlip)] = -1;
+        byte ^= static_cast<uint8_t>(1u << (nextRandom() % 8));
+        injected_[static_cast<uint8_t>(Fault::BitFlip)]++;
+    }
+    out.push_back(byte);
+
+    if (position == target[static_cast<uint8_t>(Fault::Insert)] || roll(lane.profile.insertPpm)) {
+        target[static_cast<uint8_t>(Fault::Insert)] = -1;
+        out.push_back(static_cast<uint8_t>(nextRandom()));
+        injected_[static_cast<uint8_t>(Fault::Insert)]++;
+    }
+}
+
+void FaultInjectionUart::pull() {
+    Lane &lane = lanes_[static_cast<uint8_t>(Direction::ToHost)];
+
+    uint8_t buffer[64];
+    while (inner_.available() > 0) {
+        size_t size = sizeof(buffer);
+        if (inner_.read(buffer, &size) != kSuccess || size == 0) {
+            break;
+        }
+
+        uint64_t now = host::time_now_us();
+        scratch_.clear();
+        for (size_t i = 0; i < size; i++) {
+            if (lane.frameLength == 0 || now - lane.lastByteUs > frameGapUs_) {
+                rx_.insert(rx_.end(), scratch_.begin(), scratch_.end());
+                scratch_.clear();
+                beginFrame(lane, Direction::ToHost, 0, now);
+            }
+            processByte(lane, buffer[i], now, scratch_);
+        }
+        rx_.insert(rx_.end(), scratch_.begin(), scratch_.end());
+    }
+}
+
+size_t FaultInjectionUart::available() {
+    pull();
+    return rx_.size();
+}
+
+Result FaultInjectionUart::read(uint8_t *buffer, size_t *size) {
+    if (!buffer || !size) {
+        return kInvalidParameters;
+    }
+
+    pull();
+
+    size_t count = 0;
+    while (count < *size && !rx_.empty()) {
+        buffer[count++] = rx_.front();
+        rx_.pop_front();
+    }
+    wireReceived(count);
+    *size = count;
+    return kSuccess;
+}
+
+Result FaultInjectionUart::write(const uint8_t *buffer, size_t size) {
+    if (!buffer && size > 0) {
+        return kInvalidParameters;
+    }
+    if (size == 0) {
+        return inner_.write(buffer, size);
+    }
+
+    Lane &lane = lanes_[static_cast<uint8_t>(Direction::ToDevice)];
+    uint64_t now = host::time_now_us();
+    beginFrame(lane, Direction::ToDevice, static_cast<uint32_t>(size), now);
+    wireSent(size);
+
+    scratch_.clear();
+    for (size_t i = 0; i < size; i++) {
+        processByte(lane, buffer[i], now, scratch_);
+    }
+
+    // Whatever the line lost still counts as written from the driver's side
+    if (scratch_.empty()) {
+        return kSuccess;
+    }
+    return inner_.write(scratch_.data(), scratch_.size());
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "climate_uart/transport/uart_transport.h"
+
+#include <deque>
+#include <stdint.h>
+#include <vector>
+
+namespace climate_uart {
+namespace emulators {
+
+enum class Fault : uint8_t {
+    BitFlip = 0,  // one bit of a byte inverted
+    Drop,         // a byte lost
+    Insert,       // a spurious byte after a real one
+    Stall,        // the line goes dead: everything sent for stallUs is lost
+    Truncate,     // a frame cut short
+    Nak,          // a reply replaced by the NAK frame (unit to driver only)
+    Count
+};
+
+enum class Direction : uint8_t {
+    ToDevice = 0,  // what the driver writes
+    ToHost,        // what the driver reads
+};
+
+// Random faults on one direction. Byte faults are rolled per byte, the others per frame,
+// as chances in parts per million.
+struct FaultProfile {
+    uint32_t bitFlipPpm{0};
+    uint32_t dropPpm{0};
+    uint32_t insertPpm{0};
+    uint32_t stallPpm{0};
+    uint32_t truncatePpm{0};
+    uint32_t nakPpm{0};
+    uint32_t stallUs{2000000};
+};
+
+// UartTransport decorator that corrupts traffic on its way through, for exercising the
+// drivers' checksum, timeout and reconnect paths. Wraps the transport a driver would use
+// (typically MemoryUartLink::host()). A frame is one write() call towards the device; from
+// the device it is a burst of bytes read without a gap of more than three character times.
+// Faults come from a seeded generator, so a run repeats exactly.
+class FaultInjectionUart : public transport::UartTransport {
+public:
+    explicit FaultInjectionUart(transport::UartTransport &inner, uint32_t seed = 1);
+
+    Result open(uint32_t baudrate, transport::UartParity parity, uint8_t stopBits) override;
+    Result close() override;
+    size_t available() override;
+    Result read(uint8_t *buffer, size_t *size) override;
+    Result write(const uint8_t *buffer, size_t size) override;
+
+    void setProfile(Direction direction, const FaultProfile &profile);
+    // Applies `fault` once, to the next frame in `direction`; byte faults hit a random byte.
+    void inject(Direction direction, Fault fault);
+    // Bytes a Nak fault answers with instead of the unit's reply (e.g. 0x15 for Daikin).
+    void setNakFrame(const uint8_t *bytes, size_t size);
+
+    // Faults actually applied so far, per class.
+    uint32_t injected(Fault fault) const { return injected_[static_cast<uint8_t>(fault)]; }
+
+private:
+    static constexpr uint8_t kFaultCount = static_cast<uint8_t>(Fault::Count);
+
+    struct Lane {
+        FaultProfile profile;
+        uint8_t armed{0};
+        // Faults resolved for the frame in progress
+        int32_t bytePosition[3]{-1, -1, -1};
+        uint32_t truncateAt{0};
+        bool nak{false};
+        uint64_t stallUntilUs{0};
+        // Frame tracking
+        uint32_t frameLength{0};
+        uint32_t lastFrameLength{4};
+        uint64_t lastByteUs{0};
+    };
+
+    uint32_t nextRandom();
+    bool roll(uint32_t ppm);
+    void beginFrame(Lane &lane, Direction direction, uint32_t expectedLength, uint64_t nowUs);
+    void processByte(Lane &lane, uint8_t byte, uint64_t nowUs, std::vector<uint8_t> &out);
+    void pull();
+
+    transport::UartTransport &inner_;
+    uint32_t random_;
+    Lane lanes_[2];
+    uint32_t frameGapUs_{3000};
+    std::vector<uint8_t> nakFrame_;
+    std::deque<uint8_t> rx_;
+    std::vector<uint8_t> scratch_;
+    uint32_t injected_[kFaultCount]{};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
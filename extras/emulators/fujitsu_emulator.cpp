@@ -0,0 +1,114 @@
+#include "fujitsu_emulator.h"
+
+#include "climate_uart/platform_host.h"
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint8_t kFrameSize = 8;
+constexpr uint8_t kAddressUnit = 1;
+constexpr uint8_t kAddressPrimary = 32;
+constexpr uint8_t kTypeStatus = 0;
+constexpr uint8_t kTypeLogin = 2;
+// Bytes of one frame are back to back; anything older belongs to a lost frame.
+constexpr uint64_t kFrameSilenceUs = 50000;
+// One turn: our frame (8 bytes 8E1 at 500 baud), the controller's 50 ms gap and its reply.
+// The next status never starts before the reply slot has passed.
+constexpr uint64_t kFrameWireUs = kFrameSize * 11 * 1000000ull / 500;
+constexpr uint64_t kTurnUs = kFrameWireUs + 50000 + kFrameWireUs;
+
+// Indexed by the library enums
+constexpr uint8_t kModes[] = {5, 3, 2, 1, 5, 4};
+constexpr uint8_t kFans[] = {0, 0, 4, 3, 2, 1};
+}  // namespace
+
+FujitsuEmulator::FujitsuEmulator(MemoryUartLink &link) : DeviceEmulator(link) {
+    link_.setHostEcho(true);
+}
+
+void FujitsuEmulator::onByte(uint8_t byte) {
+    uint64_t now = host::time_now_us();
+    if (rxCount_ > 0 && now - lastRxUs_ > kFrameSilenceUs) {
+        rxCount_ = 0;
+    }
+    lastRxUs_ = now;
+
+    rx_[rxCount_++] = static_cast<uint8_t>(byte ^ 0xFF);
+    if (rxCount_ == kFrameSize) {
+        rxCount_ = 0;
+        countFrameReceived();
+        handleFrame(rx_);
+    }
+}
+
+void FujitsuEmulator::handleFrame(const uint8_t *frame) {
+    uint8_t dest = frame[1] & 0x7F;
+    uint8_t type = (frame[2] & 0x30) >> 4;
+    bool writeBit = (frame[2] & 0x08) != 0;
+    if (frame[0] != kAddressPrimary || dest != kAddressUnit) {
+        return;
+    }
+
+    if (type == kTypeLogin) {
+        loggedIn_ = true;
+        return;
+    }
+
+    if (type != kTypeStatus || !writeBit) {
+        return;
+    }
+
+    settings_.action = (frame[3] & 0x01) ? HeatpumpAction::On : HeatpumpAction::Off;
+    uint8_t mode = (frame[3] & 0x0E) >> 1;
+    for (uint8_t i = 1; i < sizeof(kModes); i++) {
+        if (mode == kModes[i]) {
+            settings_.mode = static_cast<HeatpumpMode>(i);
+            break;
+        }
+    }
+    uint8_t fan = (frame[3] & 0x70) >> 4;
+    for (uint8_t i = 1; i < sizeof(kFans); i++) {
+        if (fan == kFans[i]) {
+            settings_.fanSpeed = static_cast<HeatpumpFanSpeed>(i);
+            break;
+        }
+    }
+    settings_.temperature = frame[4] & 0x7F;
+    settings_.vaneMode = (frame[5] & 0x04) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+}
+
+void FujitsuEmulator::onTick(uint64_t nowUs) {
+    uint64_t intervalUs = cycleIntervalMs_ * 1000ull;
+    if (nowUs - lastCycleUs_ < ((intervalUs > kTurnUs) ? intervalUs : kTurnUs)) {
+        return;
+    }
+    // A controller reply still coming in holds the bus
+    if (rxCount_ > 0 && nowUs - lastRxUs_ <= kFrameSilenceUs) {
+        return;
+    }
+    lastCycleUs_ = nowUs;
+    sendStatus();
+}
+
+void FujitsuEmulator::sendStatus() {
+    uint8_t frame[kFrameSize]{};
+    frame[0] = kAddressUnit;
+    frame[1] = kAddressPrimary;
+    frame[2] = static_cast<uint8_t>(kTypeStatus << 4);
+    frame[3] = static_cast<uint8_t>((settings_.action == HeatpumpAction::On ? 0x01 : 0x00) |
+                                    (kModes[static_cast<uint8_t>(settings_.mode)] << 1) |
+                                    (kFans[static_cast<uint8_t>(settings_.fanSpeed)] << 4));
+    frame[4] = static_cast<uint8_t>(settings_.temperature & 0x7F);
+    frame[5] = (settings_.vaneMode == HeatpumpVaneMode::Swing) ? 0x04 : 0x00;
+    frame[6] = static_cast<uint8_t>((loggedIn_ ? 0x01 : 0x00) |
+                                    ((static_cast<uint8_t>(roomTemperature_) & 0x3F) << 1));
+
+    for (uint8_t &byte : frame) {
+        byte ^= 0xFF;
+    }
+    sendNow(frame, sizeof(frame));
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "device_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+// Fujitsu indoor unit (address 1) on the single-wire bus: sends its status to the primary
+// controller every cycle (600 ms by default, never shorter than a whole turn), logs the
+// controller in when it answers with a login frame and applies status replies that carry
+// the write bit.
+class FujitsuEmulator : public DeviceEmulator {
+public:
+    explicit FujitsuEmulator(MemoryUartLink &link);
+
+    void setCycleIntervalMs(uint32_t intervalMs) { cycleIntervalMs_ = intervalMs; }
+    bool controllerLoggedIn() const { return loggedIn_; }
+
+protected:
+    void onByte(uint8_t byte) override;
+    void onTick(uint64_t nowUs) override;
+
+private:
+    void handleFrame(const uint8_t *frame);
+    void sendStatus();
+
+    uint8_t rx_[8]{};
+    uint8_t rxCount_{0};
+    uint64_t lastRxUs_{0};
+    uint32_t cycleIntervalMs_{600};
+    uint64_t lastCycleUs_{0};
+    bool loggedIn_{false};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
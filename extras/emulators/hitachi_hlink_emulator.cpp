@@ -0,0 +1,200 @@
+#include "hitachi_hlink_emulator.h"
+
+#include "climate_uart/protocols/hitachi_hlink_codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint16_t kFeaturePowerState = 0x0000;
+constexpr uint16_t kFeatureMode = 0x0001;
+constexpr uint16_t kFeatureFanMode = 0x0002;
+constexpr uint16_t kFeatureTargetTemp = 0x0003;
+constexpr uint16_t kFeatureSwingMode = 0x0014;
+constexpr uint16_t kFeatureCurrentIndoorTemp = 0x0100;
+
+// Indexed by the library enums
+constexpr uint16_t kModes[] = {0x8000, 0x0040, 0x0020, 0x0050, 0x8000, 0x0010};
+constexpr uint8_t kFans[] = {0x00, 0x00, 0x01, 0x02, 0x03, 0x04};
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+}  // namespace
+
+HitachiHLinkEmulator::HitachiHLinkEmulator(MemoryUartLink &link) : DeviceEmulator(link) {}
+
+void HitachiHLinkEmulator::onByte(uint8_t byte) {
+    if (byte != '\r') {
+        if (lineLen_ + 1u < sizeof(line_)) {
+            line_[lineLen_++] = static_cast<char>(byte);
+        }
+        return;
+    }
+
+    line_[lineLen_] = '\0';
+    lineLen_ = 0;
+    countFrameReceived();
+
+    if (maxPipelineDepth_ > 0 && requestsThisPass_ >= maxPipelineDepth_) {
+        requestsDropped_++;
+        return;
+    }
+    requestsThisPass_++;
+    handleLine();
+}
+
+void HitachiHLinkEmulator::onTick(uint64_t nowUs) {
+    (void)nowUs;
+    requestsThisPass_ = 0;
+}
+
+void HitachiHLinkEmulator::handleLine() {
+    // "MT P=AAAA C=CCCC" or "ST P=AAAA,DD.. C=CCCC"
+    bool isQuery = strncmp(line_, "MT P=", 5) == 0;
+    bool isSet = strncmp(line_, "ST P=", 5) == 0;
+    if (!isQuery && !isSet) {
+        replyStatus(false);
+        return;
+    }
+
+    const char *p = line_ + 5;
+    uint16_t address = static_cast<uint16_t>(strtoul(p, nullptr, 16));
+    p += 4;
+
+    uint8_t data[protocols::hlink::kMaxRequestData];
+    uint8_t len = 0;
+    if (*p == ',') {
+        p++;
+        while (hexValue(p[0]) >= 0 && hexValue(p[1]) >= 0 && len < sizeof(data)) {
+            data[len++] = static_cast<uint8_t>((hexValue(p[0]) << 4) | hexValue(p[1]));
+            p += 2;
+        }
+    }
+
+    const char *crc = strstr(p, "C=");
+    if (!crc || strtoul(crc + 2, nullptr, 16) != protocols::hlink::checksum(address, data, len)) {
+        replyStatus(false);
+        return;
+    }
+
+    if (isSet) {
+        replyStatus(writeFeature(address, data, len));
+        return;
+    }
+
+    uint8_t value[2];
+    uint8_t valueLen = 0;
+    if (!readFeature(address, value, valueLen)) {
+        replyStatus(false);
+        return;
+    }
+    replyData(value, valueLen);
+}
+
+bool HitachiHLinkEmulator::readFeature(uint16_t address, uint8_t *data, uint8_t &len) const {
+    switch (address) {
+    case kFeaturePowerState:
+        data[0] = (settings_.action == HeatpumpAction::On) ? 0x01 : 0x00;
+        len = 1;
+        return true;
+    case kFeatureMode: {
+        uint16_t mode = kModes[static_cast<uint8_t>(settings_.mode)];
+        data[0] = static_cast<uint8_t>(mode >> 8);
+        data[1] = static_cast<uint8_t>(mode & 0xFF);
+        len = 2;
+        return true;
+    }
+    case kFeatureFanMode:
+        data[0] = kFans[static_cast<uint8_t>(settings_.fanSpeed)];
+        len = 1;
+        return true;
+    case kFeatureTargetTemp:
+        data[0] = 0x00;
+        data[1] = static_cast<uint8_t>(settings_.temperature);
+        len = 2;
+        return true;
+    case kFeatureSwingMode:
+        data[0] = (settings_.vaneMode == HeatpumpVaneMode::Swing) ? 0x03 : 0x00;
+        len = 1;
+        return true;
+    case kFeatureCurrentIndoorTemp: {
+        uint16_t temp = static_cast<uint16_t>(static_cast<int16_t>(roomTemperature_));
+        data[0] = static_cast<uint8_t>(temp >> 8);
+        data[1] = static_cast<uint8_t>(temp & 0xFF);
+        len = 2;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool HitachiHLinkEmulator::writeFeature(uint16_t address, const uint8_t *data, uint8_t len) {
+    if (len == 0) {
+        return false;
+    }
+
+    switch (address) {
+    case kFeaturePowerState:
+        settings_.action = (data[0] == 0x01) ? HeatpumpAction::On : HeatpumpAction::Off;
+        return true;
+    case kFeatureMode: {
+        if (len < 2) {
+            return false;
+        }
+        uint16_t mode = static_cast<uint16_t>((data[0] << 8) | data[1]);
+        for (uint8_t i = 1; i < sizeof(kModes) / sizeof(kModes[0]); i++) {
+            if (mode == kModes[i]) {
+                settings_.mode = static_cast<HeatpumpMode>(i);
+                break;
+            }
+        }
+        return true;
+    }
+    case kFeatureFanMode:
+        for (uint8_t i = 1; i < sizeof(kFans); i++) {
+            if (data[0] == kFans[i]) {
+                settings_.fanSpeed = static_cast<HeatpumpFanSpeed>(i);
+                break;
+            }
+        }
+        return true;
+    case kFeatureTargetTemp:
+        settings_.temperature = (len >= 2) ? ((data[0] << 8) | data[1]) : data[0];
+        return true;
+    case kFeatureSwingMode:
+        settings_.vaneMode = (data[0] != 0x00) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void HitachiHLinkEmulator::replyStatus(bool ok) {
+    const char *reply = ok ? "OK\r" : "NG\r";
+    sendFrame(reinterpret_cast<const uint8_t *>(reply), 3);
+}
+
+void HitachiHLinkEmulator::replyData(const uint8_t *data, uint8_t len) {
+    char reply[32];
+    int pos = snprintf(reply, sizeof(reply), "OK P=");
+    for (uint8_t i = 0; i < len; i++) {
+        pos += snprintf(reply + pos, sizeof(reply) - pos, "%02X", data[i]);
+    }
+    pos += snprintf(reply + pos, sizeof(reply) - pos, " C=%04X\r", protocols::hlink::checksum(0, data, len));
+    sendFrame(reinterpret_cast<const uint8_t *>(reply), static_cast<size_t>(pos));
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "device_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+// H-Link adapter: answers "MT" queries with "OK P=<value> C=<checksum>", acknowledges "ST"
+// writes with "OK" and replies "NG" to unknown addresses or bad checksums.
+class HitachiHLinkEmulator : public DeviceEmulator {
+public:
+    explicit HitachiHLinkEmulator(MemoryUartLink &link);
+
+    // Requests arriving together beyond this many are dropped, like an adapter that cannot
+    // queue pipelined requests. 0 (default) accepts any number.
+    void setMaxPipelineDepth(uint8_t depth) { maxPipelineDepth_ = depth; }
+    uint32_t requestsDropped() const { return requestsDropped_; }
+
+protected:
+    void onByte(uint8_t byte) override;
+    void onTick(uint64_t nowUs) override;
+
+private:
+    void handleLine();
+    bool readFeature(uint16_t address, uint8_t *data, uint8_t &len) const;
+    bool writeFeature(uint16_t address, const uint8_t *data, uint8_t len);
+    void replyStatus(bool ok);
+    void replyData(const uint8_t *data, uint8_t len);
+
+    char line_[64]{};
+    uint8_t lineLen_{0};
+    uint8_t maxPipelineDepth_{0};
+    uint8_t requestsThisPass_{0};
+    uint32_t requestsDropped_{0};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,95 @@
+#include "lg_aircon_emulator.h"
+
+#include <string.h>
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint8_t kMsgLen = 13;
+constexpr uint8_t kMsgTypeStatusMaster = 0xA8;
+constexpr uint8_t kMsgTypeStatusUnit = 0xC8;
+constexpr uint8_t kPowerOn = 0x02;
+constexpr uint8_t kSwingVertical = 0x80;
+
+// Indexed by the library enums
+constexpr uint8_t kModes[] = {3, 0, 1, 2, 3, 4};
+constexpr uint8_t kFans[] = {3, 3, 2, 1, 0, 4};
+}  // namespace
+
+LgAirconEmulator::LgAirconEmulator(MemoryUartLink &link) : DeviceEmulator(link) {
+    link_.setHostEcho(true);
+}
+
+uint8_t LgAirconEmulator::crc(const uint8_t *buffer, size_t size) {
+    uint32_t result = 0;
+    for (size_t i = 0; i < size; i++) {
+        result += buffer[i];
+    }
+    return static_cast<uint8_t>((result & 0xFF) ^ 0x55);
+}
+
+void LgAirconEmulator::onByte(uint8_t byte) {
+    if (rxCount_ == kMsgLen) {
+        memmove(rx_, rx_ + 1, kMsgLen - 1);
+        rxCount_--;
+    }
+    rx_[rxCount_++] = byte;
+
+    if (rxCount_ == kMsgLen && (rx_[0] & 0xF8) == kMsgTypeStatusMaster && rx_[kMsgLen - 1] == crc(rx_, kMsgLen - 1)) {
+        countFrameReceived();
+        handleFrame();
+        rxCount_ = 0;
+    }
+}
+
+void LgAirconEmulator::handleFrame() {
+    if (rx_[1] & 0x01) {
+        settings_.action = (rx_[1] & kPowerOn) ? HeatpumpAction::On : HeatpumpAction::Off;
+
+        uint8_t mode = (rx_[1] >> 2) & 0x07;
+        for (uint8_t i = 1; i < sizeof(kModes); i++) {
+            if (mode == kModes[i]) {
+                settings_.mode = static_cast<HeatpumpMode>(i);
+                break;
+            }
+        }
+
+        uint8_t fan = (rx_[1] >> 5) & 0x07;
+        for (uint8_t i = 1; i < sizeof(kFans); i++) {
+            if (fan == kFans[i]) {
+                settings_.fanSpeed = static_cast<HeatpumpFanSpeed>(i);
+                break;
+            }
+        }
+
+        settings_.vaneMode = (rx_[2] & kSwingVertical) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+        settings_.temperature = (rx_[6] & 0x0F) + 15;
+    }
+
+    sendStatus();
+}
+
+void LgAirconEmulator::onTick(uint64_t nowUs) {
+    if (broadcastIntervalMs_ == 0 || nowUs - lastBroadcastUs_ < broadcastIntervalMs_ * 1000ull) {
+        return;
+    }
+    lastBroadcastUs_ = nowUs;
+    sendStatus();
+}
+
+void LgAirconEmulator::sendStatus() {
+    uint8_t msg[kMsgLen]{};
+    msg[0] = kMsgTypeStatusUnit;
+    msg[1] = static_cast<uint8_t>((settings_.action == HeatpumpAction::On ? kPowerOn : 0x00) |
+                                  (kModes[static_cast<uint8_t>(settings_.mode)] << 2) |
+                                  (kFans[static_cast<uint8_t>(settings_.fanSpeed)] << 5));
+    msg[2] = (settings_.vaneMode == HeatpumpVaneMode::Swing) ? kSwingVertical : 0x00;
+    msg[6] = static_cast<uint8_t>((settings_.temperature - 15) & 0x0F);
+    msg[7] = static_cast<uint8_t>(static_cast<int>((roomTemperature_ - 10.0f) * 2.0f) & 0x3F);
+    msg[12] = crc(msg, kMsgLen - 1);
+    sendFrame(msg, kMsgLen);
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "device_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+// LG unit on the single-wire bus: the host reads back its own frames, every valid master
+// frame (0xA8) is answered with a unit status (0xC8), and 0xA8 frames with bit 0 of byte 1
+// set carry new settings.
+class LgAirconEmulator : public DeviceEmulator {
+public:
+    explicit LgAirconEmulator(MemoryUartLink &link);
+
+    // 0 (default) disables the periodic status broadcast.
+    void setBroadcastIntervalMs(uint32_t intervalMs) { broadcastIntervalMs_ = intervalMs; }
+
+protected:
+    void onByte(uint8_t byte) override;
+    void onTick(uint64_t nowUs) override;
+
+private:
+    static uint8_t crc(const uint8_t *buffer, size_t size);
+
+    void handleFrame();
+    void sendStatus();
+
+    uint8_t rx_[13]{};
+    uint8_t rxCount_{0};
+    uint32_t broadcastIntervalMs_{0};
+    uint64_t lastBroadcastUs_{0};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,162 @@
+#include "memory_uart.h"
+
+#include "virtual_clock.h"
+
+#include "climate_uart/platform_host.h"
+
+namespace climate_uart {
+namespace emulators {
+
+MemoryUartLink::MemoryUartLink() {
+    host_.link_ = this;
+    host_.peer_ = &device_;
+    device_.link_ = this;
+    device_.peer_ = &host_;
+}
+
+void MemoryUartLink::setPollHook(PollHook hook, void *context) {
+    pollHook_ = hook;
+    pollContext_ = context;
+}
+
+void MemoryUartLink::setHostEcho(bool enabled) {
+    host_.echo_ = enabled;
+}
+
+void MemoryUartLink::setClock(VirtualClock *clock, uint32_t idleStepUs) {
+    clock_ = clock;
+    idleStepUs_ = idleStepUs ? idleStepUs : 1;
+}
+
+uint32_t MemoryUartLink::charTimeUs() const {
+    return static_cast<uint32_t>((transport::bitsPerChar(parity_, stopBits_) * 1000000ull + baudrate_ - 1) / baudrate_);
+}
+
+void MemoryUartLink::deliver(Endpoint &from, const uint8_t *buffer, size_t size) {
+    Endpoint &to = *from.peer_;
+    uint64_t now = host::time_now_us();
+    uint64_t readyUs = now;
+
+    uint64_t *wireFree = nullptr;
+    if (paced_) {
+        // Shared wire on half-duplex buses, one per direction otherwise
+        wireFree = &wireFreeUs_[(host_.echo_ || &from == &host_) ? 0 : 1];
+        readyUs = (*wireFree > now) ? *wireFree : now;
+    }
+
+    uint32_t charUs = paced_ ? charTimeUs() : 0;
+    for (size_t i = 0; i < size; i++) {
+        readyUs += charUs;
+        to.rx_.push_back({buffer[i], readyUs});
+        if (from.echo_) {
+            from.rx_.push_back({buffer[i], readyUs});
+        }
+    }
+
+    if (wireFree) {
+        *wireFree = readyUs;
+    }
+}
+
+void MemoryUartLink::advanceIdleClock() {
+    uint64_t now = clock_->nowUs();
+    if (!host_.rx_.empty() && host_.rx_.front().readyUs <= now) {
+        return;
+    }
+
+    uint64_t target = now + idleStepUs_;
+    if (!host_.rx_.empty() && host_.rx_.front().readyUs < target) {
+        target = host_.rx_.front().readyUs;
+    }
+    clock_->advanceTo(target);
+}
+
+void MemoryUartLink::Endpoint::poll() {
+    // Only the host end drives the far end, and never re-entrantly.
+    if (this != &link_->host_ || link_->polling_) {
+        return;
+    }
+
+    if (!link_->pollHook_) {
+        if (link_->clock_) {
+            link_->advanceIdleClock();
+        }
+        return;
+    }
+
+    link_->polling_ = true;
+    link_->pollHook_(link_->pollContext_);
+    link_->polling_ = false;
+
+    if (link_->clock_) {
+        link_->advanceIdleClock();
+    }
+}
+
+Result MemoryUartLink::Endpoint::open(uint32_t baudrate, transport::UartParity parity, uint8_t stopBits) {
+    if (this == &link_->host_) {
+        link_->baudrate_ = baudrate;
+        link_->parity_ = parity;
+        link_->stopBits_ = stopBits;
+    }
+    rx_.clear();
+    open_ = true;
+    wireOpened(baudrate, parity, stopBits);
+    return kSuccess;
+}
+
+Result MemoryUartLink::Endpoint::close() {
+    open_ = false;
+    return kSuccess;
+}
+
+size_t MemoryUartLink::Endpoint::available() {
+    poll();
+
+    uint64_t now = host::time_now_us();
+    size_t count = 0;
+    for (const TimedByte &byte : rx_) {
+        if (byte.readyUs > now) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+Result MemoryUartLink::Endpoint::read(uint8_t *buffer, size_t *size) {
+    if (!buffer || !size) {
+        return kInvalidParameters;
+    }
+
+    poll();
+
+    uint64_t now = host::time_now_us();
+    size_t count = 0;
+    while (count < *size && !rx_.empty() && rx_.front().readyUs <= now) {
+        buffer[count++] = rx_.front().value;
+        rx_.pop_front();
+    }
+
+    bytesRead_ += count;
+    wireReceived(count);
+    *size = count;
+    return kSuccess;
+}
+
+Result MemoryUartLink::Endpoint::write(const uint8_t *buffer, size_t size) {
+    if (!buffer && size > 0) {
+        return kInvalidParameters;
+    }
+    if (!open_) {
+        return kWriteError;
+    }
+
+    link_->deliver(*this, buffer, size);
+    bytesWritten_ += size;
+    wireSent(size);
+    return kSuccess;
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "climate_uart/transport/uart_transport.h"
+
+#include <deque>
+#include <stdint.h>
+
+namespace climate_uart {
+namespace emulators {
+
+class VirtualClock;
+
+// Two UartTransport ends joined in memory: what one end writes, the other reads.
+// The host end is handed to a driver, the device end to an emulator. Every byte carries
+// the time it becomes readable, so links can model latency and wire time.
+class MemoryUartLink {
+public:
+    class Endpoint : public transport::UartTransport {
+    public:
+        Result open(uint32_t baudrate, transport::UartParity parity, uint8_t stopBits) override;
+        Result close() override;
+        size_t available() override;
+        Result read(uint8_t *buffer, size_t *size) override;
+        Result write(const uint8_t *buffer, size_t size) override;
+
+        bool isOpen() const { return open_; }
+        uint64_t bytesRead() const { return bytesRead_; }
+        uint64_t bytesWritten() const { return bytesWritten_; }
+
+    private:
+        friend class MemoryUartLink;
+
+        struct TimedByte {
+            uint8_t value;
+            uint64_t readyUs;
+        };
+
+        void poll();
+
+        MemoryUartLink *link_{nullptr};
+        Endpoint *peer_{nullptr};
+        std::deque<TimedByte> rx_;
+        bool open_{false};
+        bool echo_{false};
+        uint64_t bytesRead_{0};
+        uint64_t bytesWritten_{0};
+    };
+
+    // Called whenever the host end polls; emulators hook their service() here so they
+    // run while a driver busy-waits in a read loop.
+    using PollHook = void (*)(void *context);
+
+    MemoryUartLink();
+    MemoryUartLink(const MemoryUartLink &) = delete;
+    MemoryUartLink &operator=(const MemoryUartLink &) = delete;
+
+    Endpoint &host() { return host_; }
+    Endpoint &device() { return device_; }
+
+    void setPollHook(PollHook hook, void *context);
+    // Half-duplex single-wire buses (LG, Fujitsu): the host reads back what it writes.
+    void setHostEcho(bool enabled);
+
+    // Paced links deliver each byte one character time (from the settings the host end was
+    // opened with) after the previous one on its wire. The two directions are separate
+    // wires, except with host echo where both ends share one.
+    void setPaced(bool paced) { paced_ = paced; }
+    // With a clock attached, a host-end poll that finds nothing to read advances it to the
+    // next byte on the way, by at most idleStepUs: timeouts expire in virtual time.
+    void setClock(VirtualClock *clock, uint32_t idleStepUs = 100);
+    // Wire time of one character at the current settings.
+    uint32_t charTimeUs() const;
+
+    uint32_t baudrate() const { return baudrate_; }
+    transport::UartParity parity() const { return parity_; }
+    uint8_t stopBits() const { return stopBits_; }
+
+private:
+    void deliver(Endpoint &from, const uint8_t *buffer, size_t size);
+    void advanceIdleClock();
+
+    Endpoint host_;
+    Endpoint device_;
+    PollHook pollHook_{nullptr};
+    void *pollContext_{nullptr};
+    bool polling_{false};
+    bool paced_{false};
+    VirtualClock *clock_{nullptr};
+    uint32_t idleStepUs_{100};
+    uint64_t wireFreeUs_[2]{};
+    uint32_t baudrate_{9600};
+    transport::UartParity parity_{transport::UartParity::None};
+    uint8_t stopBits_{1};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
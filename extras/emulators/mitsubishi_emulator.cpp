@@ -0,0 +1,106 @@
+#include "mitsubishi_emulator.h"
+
+#include <string.h>
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint8_t kStx = 0xFC;
+constexpr uint8_t kProtoReply = 0x20;
+
+// Indexed by the library enums, as in the driver
+constexpr uint8_t kModes[] = {0xFF, 0x03, 0x02, 0x07, 0x08, 0x01};
+constexpr uint8_t kFans[] = {0xFF, 0x00, 0x06, 0x03, 0x02, 0x01};
+constexpr uint8_t kVanes[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x07};
+}  // namespace
+
+MitsubishiEmulator::MitsubishiEmulator(MemoryUartLink &link) : DeviceEmulator(link) {}
+
+uint8_t MitsubishiEmulator::crc(const uint8_t *buffer, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = 1; i < size; i++) {
+        sum += buffer[i];
+    }
+    return static_cast<uint8_t>(-static_cast<int8_t>(sum));
+}
+
+void MitsubishiEmulator::onByte(uint8_t byte) {
+    if (rxCount_ == 0 && byte != kStx) {
+        return;
+    }
+
+    rx_[rxCount_++] = byte;
+    if (rxCount_ == 5 && rx_[4] > 16) {
+        rxCount_ = 0;
+        return;
+    }
+    if (rxCount_ >= 6 && rxCount_ == rx_[4] + 6) {
+        if (crc(rx_, rxCount_ - 1) == rx_[rxCount_ - 1]) {
+            countFrameReceived();
+            handlePacket();
+        }
+        rxCount_ = 0;
+    }
+}
+
+void MitsubishiEmulator::handlePacket() {
+    uint8_t cmd = rx_[1];
+    const uint8_t *data = &rx_[5];
+    uint8_t out[16]{};
+
+    if (cmd == 0x5A) {
+        reply(static_cast<uint8_t>(cmd | kProtoReply), out, 1);
+        return;
+    }
+
+    if (cmd == 0x41 && data[0] == 0x01) {
+        settings_.action = (data[3] == 0x01) ? HeatpumpAction::On : HeatpumpAction::Off;
+        for (uint8_t i = 1; i < sizeof(kModes); i++) {
+            if (data[4] == kModes[i]) {
+                settings_.mode = static_cast<HeatpumpMode>(i);
+            }
+        }
+        settings_.temperature = (0x0F - data[5]) + 16;
+        for (uint8_t i = 1; i < sizeof(kFans); i++) {
+            if (data[6] == kFans[i]) {
+                settings_.fanSpeed = static_cast<HeatpumpFanSpeed>(i);
+            }
+        }
+        for (uint8_t i = 0; i < sizeof(kVanes); i++) {
+            if (data[7] == kVanes[i]) {
+                settings_.vaneMode = static_cast<HeatpumpVaneMode>(i);
+            }
+        }
+        reply(static_cast<uint8_t>(cmd | kProtoReply), out, sizeof(out));
+        return;
+    }
+
+    if (cmd == 0x42 && data[0] == 0x02) {
+        out[0] = 0x02;
+        out[3] = (settings_.action == HeatpumpAction::On) ? 0x01 : 0x00;
+        out[4] = kModes[static_cast<uint8_t>(settings_.mode)];
+        out[5] = static_cast<uint8_t>(0x0F - (settings_.temperature - 16));
+        out[6] = kFans[static_cast<uint8_t>(settings_.fanSpeed)];
+        out[7] = kVanes[static_cast<uint8_t>(settings_.vaneMode)];
+        reply(static_cast<uint8_t>(cmd | kProtoReply), out, sizeof(out));
+        return;
+    }
+
+    if (cmd == 0x42 && data[0] == 0x03) {
+        out[0] = 0x03;
+        out[3] = static_cast<uint8_t>(static_cast<int>(roomTemperature_) - 10);
+        out[6] = static_cast<uint8_t>(0x80 | static_cast<uint8_t>(roomTemperature_ * 2.0f + 0.5f));
+        reply(static_cast<uint8_t>(cmd | kProtoReply), out, sizeof(out));
+    }
+}
+
+void MitsubishiEmulator::reply(uint8_t cmd, const uint8_t *data, uint8_t size) {
+    uint8_t buffer[32] = {kStx, cmd, 0x01, 0x30, size};
+    memcpy(&buffer[5], data, size);
+    buffer[5 + size] = crc(buffer, size + 5u);
+    sendFrame(buffer, size + 6u);
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
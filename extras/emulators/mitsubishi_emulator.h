@@ -0,0 +1,27 @@
+#pragma once
+
+#include "device_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+// CN105 unit: answers connect (0x5A), set (0x41) and get (0x42: settings, room temperature).
+class MitsubishiEmulator : public DeviceEmulator {
+public:
+    explicit MitsubishiEmulator(MemoryUartLink &link);
+
+protected:
+    void onByte(uint8_t byte) override;
+
+private:
+    static uint8_t crc(const uint8_t *buffer, size_t size);
+
+    void handlePacket();
+    void reply(uint8_t cmd, const uint8_t *data, uint8_t size);
+
+    uint8_t rx_[32]{};
+    uint8_t rxCount_{0};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
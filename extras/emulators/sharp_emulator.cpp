@@ -0,0 +1,147 @@
+#include "sharp_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint8_t kFrameStartTx = 0xDD;
+constexpr uint8_t kFrameStartRx = 0xDC;
+constexpr uint8_t kFrameTypeCommand = 0xFB;
+constexpr uint8_t kFrameTypeMode = 0xFC;
+constexpr uint8_t kFrameTypeStatus = 0xFD;
+constexpr uint8_t kAckByte = 0x06;
+
+// Indexed by the library enums
+constexpr uint8_t kModes[] = {0x02, 0x02, 0x03, 0x04, 0x02, 0x01};
+constexpr uint8_t kFans[] = {0x02, 0x02, 0x05, 0x03, 0x04, 0x04};
+constexpr uint8_t kVanes[] = {0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0F};
+}  // namespace
+
+SharpEmulator::SharpEmulator(MemoryUartLink &link) : DeviceEmulator(link) {}
+
+uint8_t SharpEmulator::crc(const uint8_t *buffer, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = 1; i < size; i++) {
+        sum += buffer[i];
+    }
+    return static_cast<uint8_t>(0 - static_cast<uint8_t>(sum));
+}
+
+uint8_t SharpEmulator::expectedSize() const {
+    if (rx_[0] == kFrameStartTx) {
+        // Requests are "DD 02 <type> 62", commands carry data[1] + 3 bytes
+        return (rx_[1] == 0x02) ? 4 : static_cast<uint8_t>(rx_[1] + 3);
+    }
+    // Handshake messages: 7 bytes, 8 for "02 FF FF 01"
+    return (rx_[0] == 0x02 && rx_[1] == 0xFF && rx_[3] == 0x01) ? 8 : 7;
+}
+
+void SharpEmulator::onByte(uint8_t byte) {
+    if (rxCount_ == 0) {
+        if (byte == kAckByte) {
+            acksReceived_++;
+            return;
+        }
+        if (byte != kFrameStartTx && byte != 0x02 && byte != 0x03) {
+            return;
+        }
+    }
+
+    rx_[rxCount_++] = byte;
+    if (rxCount_ < 4) {
+        return;
+    }
+
+    // A corrupt length byte can announce a frame shorter than what is already buffered
+    uint8_t size = expectedSize();
+    if (size > sizeof(rx_) || size < rxCount_) {
+        rxCount_ = 0;
+    } else if (rxCount_ == size) {
+        countFrameReceived();
+        handleFrame();
+        rxCount_ = 0;
+    }
+}
+
+void SharpEmulator::handleFrame() {
+    if (rx_[0] != kFrameStartTx) {
+        sendShortFrame();
+        return;
+    }
+
+    switch (rx_[2]) {
+    case kFrameTypeMode:
+        sendModeFrame();
+        break;
+    case kFrameTypeStatus:
+        sendStatusFrame();
+        break;
+    case kFrameTypeCommand:
+        if (crc(rx_, rxCount_ - 1u) != rx_[rxCount_ - 1]) {
+            return;
+        }
+        settings_.action = (rx_[9] & 0x80) ? HeatpumpAction::On : HeatpumpAction::Off;
+        if ((rx_[4] & 0xC0) == 0xC0) {
+            settings_.temperature = (rx_[4] & 0x0F) + 16;
+        }
+        for (uint8_t i = 1; i < sizeof(kModes); i++) {
+            if ((rx_[6] & 0x0F) == kModes[i] && i != static_cast<uint8_t>(HeatpumpMode::Auto)) {
+                settings_.mode = static_cast<HeatpumpMode>(i);
+                break;
+            }
+        }
+        for (uint8_t i = 1; i < sizeof(kFans); i++) {
+            if ((rx_[6] >> 4) == kFans[i]) {
+                settings_.fanSpeed = static_cast<HeatpumpFanSpeed>(i);
+                break;
+            }
+        }
+        for (uint8_t i = 0; i < sizeof(kVanes); i++) {
+            if ((rx_[8] & 0x0F) == kVanes[i]) {
+                settings_.vaneMode = static_cast<HeatpumpVaneMode>(i);
+                break;
+            }
+        }
+        sendShortFrame();
+        break;
+    default:
+        break;
+    }
+}
+
+void SharpEmulator::onTick(uint64_t nowUs) {
+    if (broadcastIntervalMs_ == 0 || nowUs - lastBroadcastUs_ < broadcastIntervalMs_ * 1000ull) {
+        return;
+    }
+    lastBroadcastUs_ = nowUs;
+    sendModeFrame();
+}
+
+void SharpEmulator::sendModeFrame() {
+    uint8_t frame[14] = {kFrameStartRx, 0x0B, kFrameTypeMode, 0x60};
+    frame[4] = static_cast<uint8_t>(0xC0 | ((settings_.temperature - 16) & 0x0F));
+    frame[5] = static_cast<uint8_t>(kModes[static_cast<uint8_t>(settings_.mode)] |
+                                    (kFans[static_cast<uint8_t>(settings_.fanSpeed)] << 4));
+    frame[6] = kVanes[static_cast<uint8_t>(settings_.vaneMode)];
+    frame[8] = (settings_.action == HeatpumpAction::On) ? 0x80 : 0x00;
+    reply(frame, sizeof(frame));
+}
+
+void SharpEmulator::sendStatusFrame() {
+    uint8_t frame[18] = {kFrameStartRx, 0x0F, kFrameTypeStatus};
+    frame[7] = static_cast<uint8_t>(roomTemperature_);
+    reply(frame, sizeof(frame));
+}
+
+void SharpEmulator::sendShortFrame() {
+    uint8_t frame[4] = {kFrameStartRx, 0x01, 0x00};
+    reply(frame, sizeof(frame));
+}
+
+void SharpEmulator::reply(uint8_t *frame, uint8_t size) {
+    frame[size - 1] = crc(frame, size - 1u);
+    sendFrame(frame, size);
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
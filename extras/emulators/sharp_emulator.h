@@ -0,0 +1,40 @@
+#pragma once
+
+#include "device_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+// Sharp unit: acknowledges the handshake messages, answers the mode (0xFC) and status (0xFD)
+// requests, applies 0xFB commands and can broadcast its mode frame on its own.
+class SharpEmulator : public DeviceEmulator {
+public:
+    explicit SharpEmulator(MemoryUartLink &link);
+
+    // 0 (default) disables the periodic mode frame broadcast.
+    void setBroadcastIntervalMs(uint32_t intervalMs) { broadcastIntervalMs_ = intervalMs; }
+    uint32_t acksReceived() const { return acksReceived_; }
+
+protected:
+    void onByte(uint8_t byte) override;
+    void onTick(uint64_t nowUs) override;
+
+private:
+    static uint8_t crc(const uint8_t *buffer, size_t size);
+
+    uint8_t expectedSize() const;
+    void handleFrame();
+    void sendModeFrame();
+    void sendStatusFrame();
+    void sendShortFrame();
+    void reply(uint8_t *frame, uint8_t size);
+
+    uint8_t rx_[32]{};
+    uint8_t rxCount_{0};
+    uint32_t acksReceived_{0};
+    uint32_t broadcastIntervalMs_{0};
+    uint64_t lastBroadcastUs_{0};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,171 @@
+#include "toshiba_emulator.h"
+
+#include <string.h>
+
+namespace climate_uart {
+namespace emulators {
+
+namespace {
+constexpr uint8_t kStx = 0x02;
+constexpr uint8_t kTypeCommand = 0x10;
+constexpr uint8_t kTypeReplyMask = 0x80;
+
+constexpr uint8_t kFunctionPowerState = 0x80;
+constexpr uint8_t kFunctionStatus = 0x88;
+constexpr uint8_t kFunctionFanMode = 0xA0;
+constexpr uint8_t kFunctionSwing = 0xA3;
+constexpr uint8_t kFunctionUnitMode = 0xB0;
+constexpr uint8_t kFunctionSetpoint = 0xB3;
+constexpr uint8_t kFunctionRoomTemp = 0xBB;
+constexpr uint8_t kFunctionGroup1 = 0xF8;
+
+constexpr uint8_t kPowerStateOn = 0x30;
+constexpr uint8_t kPowerStateOff = 0x31;
+
+// Indexed by the library enums
+constexpr uint8_t kModes[] = {0x41, 0x42, 0x44, 0x45, 0x41, 0x43};
+constexpr uint8_t kFans[] = {0x41, 0x41, 0x36, 0x34, 0x32, 0x31};
+constexpr uint8_t kVanes[] = {0x31, 0x50, 0x51, 0x52, 0x53, 0x54, 0x41};
+
+// Reply data before the (function, value) pairs
+constexpr uint8_t kReplyHeader[] = {0x01, 0x30, 0x01, 0x00, 0x00, 0x81, 0x00};
+}  // namespace
+
+ToshibaEmulator::ToshibaEmulator(MemoryUartLink &link) : DeviceEmulator(link) {}
+
+uint8_t ToshibaEmulator::crc(const uint8_t *buffer, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = 1; i < size; i++) {
+        sum += buffer[i];
+    }
+    return static_cast<uint8_t>(-static_cast<uint8_t>(sum));
+}
+
+void ToshibaEmulator::onByte(uint8_t byte) {
+    if (rxCount_ == 0 && byte != kStx) {
+        return;
+    }
+
+    rx_[rxCount_++] = byte;
+    if (rxCount_ == 7 && rx_[6] > sizeof(rx_) - 8) {
+        rxCount_ = 0;
+        return;
+    }
+    if (rxCount_ >= 8 && rxCount_ == rx_[6] + 8) {
+        if (crc(rx_, rxCount_ - 1) == rx_[rxCount_ - 1]) {
+            countFrameReceived();
+            handlePacket();
+        }
+        rxCount_ = 0;
+    }
+}
+
+uint8_t ToshibaEmulator::functionValue(uint8_t function) const {
+    switch (function) {
+    case kFunctionPowerState:
+        return (settings_.action == HeatpumpAction::On) ? kPowerStateOn : kPowerStateOff;
+    case kFunctionUnitMode:
+        return kModes[static_cast<uint8_t>(settings_.mode)];
+    case kFunctionSetpoint:
+        return static_cast<uint8_t>(settings_.temperature);
+    case kFunctionFanMode:
+        return kFans[static_cast<uint8_t>(settings_.fanSpeed)];
+    case kFunctionSwing:
+        return kVanes[static_cast<uint8_t>(settings_.vaneMode)];
+    case kFunctionRoomTemp:
+        return static_cast<uint8_t>(static_cast<int8_t>(roomTemperature_));
+    default:
+        return 0x00;
+    }
+}
+
+void ToshibaEmulator::applyFunction(uint8_t function, uint8_t value) {
+    switch (function) {
+    case kFunctionPowerState:
+        settings_.action = (value == kPowerStateOn) ? HeatpumpAction::On : HeatpumpAction::Off;
+        break;
+    case kFunctionUnitMode:
+        for (uint8_t i = 1; i < sizeof(kModes); i++) {
+            if (value == kModes[i]) {
+                settings_.mode = static_cast<HeatpumpMode>(i);
+                break;
+            }
+        }
+        break;
+    case kFunctionSetpoint:
+        settings_.temperature = value;
+        break;
+    case kFunctionFanMode:
+        for (uint8_t i = 1; i < sizeof(kFans); i++) {
+            if (value == kFans[i]) {
+                settings_.fanSpeed = static_cast<HeatpumpFanSpeed>(i);
+                break;
+            }
+        }
+        break;
+    case kFunctionSwing:
+        for (uint8_t i = 0; i < sizeof(kVanes); i++) {
+            if (value == kVanes[i]) {
+                settings_.vaneMode = static_cast<HeatpumpVaneMode>(i);
+                break;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void ToshibaEmulator::handlePacket() {
+    uint8_t size = rx_[6];
+    const uint8_t *data = &rx_[7];
+
+    uint8_t out[32];
+    memcpy(out, kReplyHeader, sizeof(kReplyHeader));
+    uint8_t len = sizeof(kReplyHeader);
+
+    if (rx_[3] != kTypeCommand || size < 6) {
+        // Handshake SYN: any acknowledgement ends the driver's wait early
+        reply(static_cast<uint8_t>(rx_[3] | kTypeReplyMask), nullptr, 0);
+        return;
+    }
+
+    uint8_t function = data[5];
+    if (size >= 7) {
+        applyFunction(function, data[6]);
+        out[len++] = function;
+        out[len++] = data[6];
+    } else if (function == kFunctionStatus) {
+        out[len++] = function;
+        out[len++] = 0x00;
+        const uint8_t functions[] = {kFunctionPowerState, kFunctionUnitMode, kFunctionSetpoint,
+                                     kFunctionFanMode,    kFunctionSwing,    kFunctionRoomTemp};
+        for (uint8_t f : functions) {
+            out[len++] = f;
+            out[len++] = functionValue(f);
+        }
+    } else if (function == kFunctionGroup1) {
+        out[len++] = function;
+        out[len++] = functionValue(kFunctionUnitMode);
+        out[len++] = functionValue(kFunctionSetpoint);
+        out[len++] = functionValue(kFunctionFanMode);
+        out[len++] = 0x00;
+    } else {
+        out[len++] = function;
+        out[len++] = functionValue(function);
+    }
+
+    reply(static_cast<uint8_t>(kTypeCommand | kTypeReplyMask), out, len);
+}
+
+void ToshibaEmulator::reply(uint8_t type, const uint8_t *data, uint8_t size) {
+    uint8_t buffer[48] = {kStx, 0x00, 0x03, type, 0x00, 0x00, size};
+    if (size > 0) {
+        memcpy(&buffer[7], data, size);
+    }
+    buffer[7 + size] = crc(buffer, size + 7u);
+    sendFrame(buffer, size + 8u);
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "device_emulator.h"
+
+namespace climate_uart {
+namespace emulators {
+
+// Toshiba/Carrier unit: acknowledges the SYN sequence, answers function queries (status,
+// Group1 and single functions) and applies function commands.
+class ToshibaEmulator : public DeviceEmulator {
+public:
+    explicit ToshibaEmulator(MemoryUartLink &link);
+
+protected:
+    void onByte(uint8_t byte) override;
+
+private:
+    static uint8_t crc(const uint8_t *buffer, size_t size);
+
+    void handlePacket();
+    uint8_t functionValue(uint8_t function) const;
+    void applyFunction(uint8_t function, uint8_t value);
+    void reply(uint8_t type, const uint8_t *data, uint8_t size);
+
+    uint8_t rx_[64]{};
+    uint8_t rxCount_{0};
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
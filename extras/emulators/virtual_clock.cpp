@@ -0,0 +1,27 @@
+#include "virtual_clock.h"
+
+#include "climate_uart/platform_host.h"
+
+namespace climate_uart {
+namespace emulators {
+
+VirtualClock::VirtualClock(uint64_t startUs) : nowUs_(startUs) {
+    host::set_clock(&VirtualClock::read, this);
+}
+
+VirtualClock::~VirtualClock() {
+    host::set_clock(nullptr, nullptr);
+}
+
+uint64_t VirtualClock::read(void *context) {
+    return static_cast<const VirtualClock *>(context)->nowUs_;
+}
+
+void VirtualClock::advanceTo(uint64_t timeUs) {
+    if (timeUs > nowUs_) {
+        nowUs_ = timeUs;
+    }
+}
+
+}  // namespace emulators
+}  // namespace climate_uart
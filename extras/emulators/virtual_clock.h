@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace climate_uart {
+namespace emulators {
+
+// Simulated time base for host runs: while an instance exists it is the clock behind
+// time_now_ms(). Time only moves when advanced, usually by a MemoryUartLink whose driver
+// is polling an idle line, so slow buses simulate in a fraction of their wall time.
+class VirtualClock {
+public:
+    explicit VirtualClock(uint64_t startUs = 1000000);
+    ~VirtualClock();
+
+    VirtualClock(const VirtualClock &) = delete;
+    VirtualClock &operator=(const VirtualClock &) = delete;
+
+    uint64_t nowUs() const { return nowUs_; }
+    void advanceUs(uint64_t deltaUs) { nowUs_ += deltaUs; }
+    void advanceTo(uint64_t timeUs);
+
+private:
+    static uint64_t read(void *context);
+
+    uint64_t nowUs_;
+};
+
+}  // namespace emulators
+}  // namespace climate_uart
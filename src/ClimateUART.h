@@ -5,6 +5,8 @@
 
 #include "climate_uart/transport/uart_transport_arduino.h"
 #include "climate_uart/transport/uart_transport_esp32.h"
+#include "climate_uart/transport/uart_transport_capture.h"
+#include "climate_uart/transport/uart_transport_replay.h"
 
 #include "climate_uart/protocols/daikin_s21.h"
 #include "climate_uart/protocols/fujitsu.h"
@@ -14,4 +16,7 @@
 #include "climate_uart/protocols/sharp.h"
 #include "climate_uart/protocols/toshiba.h"
 
+#include "climate_uart/storage/state_storage_file.h"
+
+#include "climate_uart/climate_poller.h"
 #include "climate_uart/platform.h"
\ No newline at end of file
@@ -0,0 +1,340 @@
+#include "climate_uart/climate_interface.h"
+
+namespace climate_uart {
+
+namespace {
+constexpr uint8_t kSnapshotMagic = 0xC5;
+constexpr uint8_t kSnapshotVersion = 1;
+constexpr size_t kSnapshotHeaderSize = 3;
+// Cached state after the driver part: known fields, five settings, room temperature
+constexpr size_t kSnapshotCommonSize = 1 + 5 + 2;
+
+uint8_t snapshotChecksum(const uint8_t *buffer, size_t size) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum = static_cast<uint8_t>(sum + buffer[i]);
+    }
+    return static_cast<uint8_t>(~sum);
+}
+
+#if CLIMATE_UART_TRACE
+const char *const kOperationNames[] = {"handshake", "getState", "setState", "getRoomTemperature", "refresh"};
+const char *const kCounterNames[] = {"write", "frame ok", "crc error", "timeout", "nak", "resync", "corrupt", "reconnect", "retry"};
+#endif
+}  // namespace
+
+constexpr size_t ClimateInterface::kSnapshotMaxSize;
+
+Result ClimateInterface::refresh(ClimateFieldMask fields) {
+    TimedOperation timed(*this, MetricOperation::Refresh);
+    Result ret = kSuccess;
+
+    if (fields & kSettingsFields) {
+        ClimateSettings settings;
+        ret = getState(settings);
+        // A unit that did not answer once will not answer the next read either: do not
+        // spend a second timeout on it within the same call.
+        if (ret == kTimeout || ret == kInvalidNotConnected) {
+            return ret;
+        }
+    }
+
+    if (fields & fieldMask(ClimateField::RoomTemperature)) {
+        float temperature = 0.0f;
+        Result tempRet = getRoomTemperature(temperature);
+        if (ret == kSuccess) {
+            ret = tempRet;
+        }
+    }
+
+    return ret;
+}
+
+Result ClimateInterface::service() {
+    return kSuccess;
+}
+
+bool ClimateInterface::isReady() const {
+    return ready_;
+}
+
+void ClimateInterface::onReady(ReadyCallback callback, void *context) {
+    readyCallback_ = callback;
+    readyContext_ = context;
+}
+
+void ClimateInterface::setReady(bool ready) {
+    if (ready == ready_) {
+        return;
+    }
+
+    ready_ = ready;
+    wasReady_ = wasReady_ || ready;
+    if (ready && readyCallback_) {
+        readyCallback_(readyContext_);
+    }
+}
+
+const HandshakeStats &ClimateInterface::handshakeStats() const {
+    return handshakeStats_;
+}
+
+const Metrics &ClimateInterface::metrics() const {
+    return metrics_;
+}
+
+void ClimateInterface::countMetric(MetricCounter counter, uint32_t amount) {
+    metrics_.increment(counter, amount);
+#if CLIMATE_UART_TRACE
+    // Every counted event is also a point on the driver's timeline
+    if (counter < MetricCounter::Count) {
+        trace_record(TracePhase::Instant, kCounterNames[static_cast<uint8_t>(counter)], this,
+                     static_cast<uint16_t>(amount));
+    }
+#endif
+}
+
+ClimateInterface::TimedOperation::TimedOperation(ClimateInterface &climate, MetricOperation operation)
+    : climate_(climate), operation_(operation), startMs_(time_now_ms()), outermost_(climate.timedDepth_++ == 0) {
+#if CLIMATE_UART_TRACE
+    trace_record(TracePhase::Begin, kOperationNames[static_cast<uint8_t>(operation)], &climate);
+#endif
+}
+
+ClimateInterface::TimedOperation::~TimedOperation() {
+#if CLIMATE_UART_TRACE
+    trace_record(TracePhase::End, kOperationNames[static_cast<uint8_t>(operation_)], &climate_);
+#endif
+    climate_.timedDepth_--;
+    if (outermost_) {
+        climate_.metrics_.record(operation_, time_elapsed_ms(startMs_));
+    }
+}
+
+void ClimateInterface::beginHandshake() {
+    if (wasReady_) {
+        metrics_.increment(MetricCounter::Reconnects);
+    }
+    handshakeStartMs_ = time_now_ms();
+#if CLIMATE_UART_TRACE
+    trace_record(TracePhase::Begin, kOperationNames[static_cast<uint8_t>(MetricOperation::Handshake)], this);
+#endif
+    handshakeStats_.result = kInProgress;
+    handshakeStats_.steps = 0;
+    handshakeStats_.totalMs = 0;
+    handshakeStats_.attempts++;
+}
+
+void ClimateInterface::recordHandshakeStep(uint32_t stepStartMs) {
+    uint32_t elapsed = time_elapsed_ms(stepStartMs);
+#if CLIMATE_UART_TRACE
+    trace_record(TracePhase::Instant, "handshake step", this, handshakeStats_.steps);
+#endif
+    if (handshakeStats_.steps < HandshakeStats::kMaxSteps) {
+        handshakeStats_.stepMs[handshakeStats_.steps] = static_cast<uint16_t>((elapsed > 0xFFFF) ? 0xFFFF : elapsed);
+    }
+    if (handshakeStats_.steps < 0xFF) {
+        handshakeStats_.steps++;
+    }
+}
+
+void ClimateInterface::endHandshake(Result result) {
+    handshakeStats_.totalMs = time_elapsed_ms(handshakeStartMs_);
+    handshakeStats_.result = result;
+    metrics_.record(MetricOperation::Handshake, handshakeStats_.totalMs);
+#if CLIMATE_UART_TRACE
+    trace_record(TracePhase::End, kOperationNames[static_cast<uint8_t>(MetricOperation::Handshake)], this,
+                 static_cast<uint16_t>(result));
+#endif
+    CLIMATE_LOG_INFO("Handshake %s in %u ms (%u steps)", (result == kSuccess) ? "done" : "failed",
+                     static_cast<unsigned>(handshakeStats_.totalMs), static_cast<unsigned>(handshakeStats_.steps));
+}
+
+uint32_t ClimateInterface::handshakeElapsedMs() const {
+    return time_elapsed_ms(handshakeStartMs_);
+}
+
+void ClimateInterface::onStateChanged(StateChangedCallback callback, void *context) {
+    stateCallback_ = callback;
+    stateContext_ = context;
+    hasLastState_ = false;
+}
+
+void ClimateInterface::onRoomTemperatureChanged(RoomTemperatureChangedCallback callback, float threshold,
+                                                void *context) {
+    roomTemperatureCallback_ = callback;
+    roomTemperatureContext_ = context;
+    roomTemperatureThreshold_ = (threshold < 0.0f) ? -threshold : threshold;
+    hasLastRoomTemperature_ = false;
+}
+
+bool ClimateInterface::cachedState(ClimateSettings &settings) const {
+    settings = cachedState_;
+    return (knownFields_ & kSettingsFields) == kSettingsFields;
+}
+
+bool ClimateInterface::cachedRoomTemperature(float &temperature) const {
+    temperature = cachedRoomTemperature_;
+    return (knownFields_ & fieldMask(ClimateField::RoomTemperature)) != 0;
+}
+
+uint32_t ClimateInterface::fieldAgeMs(ClimateField field) const {
+    if ((knownFields_ & fieldMask(field)) == 0 || (staleFields_ & fieldMask(field)) != 0) {
+        return UINT32_MAX;
+    }
+    return time_elapsed_ms(refreshedAtMs_[static_cast<uint8_t>(field)]);
+}
+
+void ClimateInterface::markRefreshed(ClimateFieldMask fields) {
+    uint32_t now = time_now_ms();
+    for (uint8_t i = 0; i < static_cast<uint8_t>(ClimateField::Count); i++) {
+        if (fields & (1u << i)) {
+            refreshedAtMs_[i] = now;
+        }
+    }
+    knownFields_ |= fields;
+    staleFields_ &= static_cast<ClimateFieldMask>(~fields);
+}
+
+Result ClimateInterface::saveSnapshot(uint8_t *buffer, size_t *size) const {
+    if (!buffer || !size || *size < kSnapshotHeaderSize + 1) {
+        return kInvalidParameters;
+    }
+
+    // Layout: magic, version, payload length, payload (driver part then cached state), checksum.
+    SnapshotWriter writer(&buffer[kSnapshotHeaderSize], *size - kSnapshotHeaderSize - 1);
+    writeSnapshot(writer);
+
+    writer.putU8(knownFields_);
+    writer.putU8(static_cast<uint8_t>(cachedState_.action));
+    writer.putU8(static_cast<uint8_t>(cachedState_.mode));
+    writer.putU8(static_cast<uint8_t>(cachedState_.temperature));
+    writer.putU8(static_cast<uint8_t>(cachedState_.fanSpeed));
+    writer.putU8(static_cast<uint8_t>(cachedState_.vaneMode));
+    writer.putU16(static_cast<uint16_t>(static_cast<int16_t>(cachedRoomTemperature_ * 10.0f)));
+
+    if (!writer.ok() || writer.size() > 0xFF) {
+        return kInvalidParameters;
+    }
+
+    buffer[0] = kSnapshotMagic;
+    buffer[1] = kSnapshotVersion;
+    buffer[2] = static_cast<uint8_t>(writer.size());
+
+    size_t total = kSnapshotHeaderSize + writer.size();
+    buffer[total] = snapshotChecksum(buffer, total);
+    *size = total + 1;
+    return kSuccess;
+}
+
+Result ClimateInterface::restoreSnapshot(const uint8_t *buffer, size_t size) {
+    if (!buffer || size < kSnapshotHeaderSize + 1) {
+        return kInvalidParameters;
+    }
+
+    if (buffer[0] != kSnapshotMagic || buffer[1] != kSnapshotVersion) {
+        return kInvalidData;
+    }
+
+    size_t payloadSize = buffer[2];
+    if (kSnapshotHeaderSize + payloadSize + 1 > size) {
+        return kInvalidData;
+    }
+
+    if (snapshotChecksum(buffer, kSnapshotHeaderSize + payloadSize) != buffer[kSnapshotHeaderSize + payloadSize]) {
+        return kInvalidCrc;
+    }
+
+    if (payloadSize < kSnapshotCommonSize) {
+        return kInvalidData;
+    }
+
+    // Nothing is applied until the whole snapshot has parsed: the fixed-size common part at
+    // the end first, then the driver part, the last step that can fail.
+    size_t driverSize = payloadSize - kSnapshotCommonSize;
+    SnapshotReader common(&buffer[kSnapshotHeaderSize + driverSize], kSnapshotCommonSize);
+    ClimateFieldMask known = static_cast<ClimateFieldMask>(common.getU8() & kAllFields);
+    ClimateSettings settings;
+    settings.action = static_cast<HeatpumpAction>(common.getU8());
+    settings.mode = static_cast<HeatpumpMode>(common.getU8());
+    settings.temperature = static_cast<int8_t>(common.getU8());
+    settings.fanSpeed = static_cast<HeatpumpFanSpeed>(common.getU8());
+    settings.vaneMode = static_cast<HeatpumpVaneMode>(common.getU8());
+    float roomTemperature = static_cast<int16_t>(common.getU16()) / 10.0f;
+    if (!common.ok()) {
+        return kInvalidData;
+    }
+
+    SnapshotReader reader(&buffer[kSnapshotHeaderSize], driverSize);
+    Result ret = readSnapshot(reader);
+    if (ret != kSuccess) {
+        return ret;
+    }
+
+    // Restored values are served from the cache but remain due for polling.
+    cachedState_ = settings;
+    cachedRoomTemperature_ = roomTemperature;
+    knownFields_ = known;
+    staleFields_ = known;
+    return kSuccess;
+}
+
+void ClimateInterface::notifyState(const ClimateSettings &settings, ClimateFieldMask fields) {
+    fields &= kSettingsFields;
+    if (fields & fieldMask(ClimateField::Action)) {
+        cachedState_.action = settings.action;
+    }
+    if (fields & fieldMask(ClimateField::Mode)) {
+        cachedState_.mode = settings.mode;
+    }
+    if (fields & fieldMask(ClimateField::Temperature)) {
+        cachedState_.temperature = settings.temperature;
+    }
+    if (fields & fieldMask(ClimateField::FanSpeed)) {
+        cachedState_.fanSpeed = settings.fanSpeed;
+    }
+    if (fields & fieldMask(ClimateField::VaneMode)) {
+        cachedState_.vaneMode = settings.vaneMode;
+    }
+    markRefreshed(fields);
+
+    // Partial refreshes only publish once the whole state is known.
+    if ((knownFields_ & kSettingsFields) != kSettingsFields) {
+        return;
+    }
+
+    if (hasLastState_ && lastState_ == cachedState_) {
+        return;
+    }
+
+    lastState_ = cachedState_;
+    hasLastState_ = true;
+
+    if (stateCallback_) {
+        stateCallback_(lastState_, stateContext_);
+    }
+}
+
+void ClimateInterface::notifyRoomTemperature(float temperature) {
+    cachedRoomTemperature_ = temperature;
+    markRefreshed(fieldMask(ClimateField::RoomTemperature));
+
+    if (hasLastRoomTemperature_) {
+        float delta = temperature - lastRoomTemperature_;
+        if (delta < 0.0f) {
+            delta = -delta;
+        }
+        if (delta < roomTemperatureThreshold_ || delta == 0.0f) {
+            return;
+        }
+    }
+
+    lastRoomTemperature_ = temperature;
+    hasLastRoomTemperature_ = true;
+
+    if (roomTemperatureCallback_) {
+        roomTemperatureCallback_(temperature, roomTemperatureContext_);
+    }
+}
+
+}  // namespace climate_uart
@@ -0,0 +1,84 @@
+#include "climate_uart/climate_poller.h"
+
+namespace climate_uart {
+
+constexpr uint32_t ClimatePoller::kDefaultSettingsIntervalMs;
+constexpr uint32_t ClimatePoller::kDefaultFanVaneIntervalMs;
+constexpr uint32_t ClimatePoller::kDefaultRoomTemperatureIntervalMs;
+
+ClimatePoller::ClimatePoller(ClimateInterface &climate) : climate_(climate) {
+    intervalMs_[static_cast<uint8_t>(ClimateField::Action)] = kDefaultSettingsIntervalMs;
+    intervalMs_[static_cast<uint8_t>(ClimateField::Mode)] = kDefaultSettingsIntervalMs;
+    intervalMs_[static_cast<uint8_t>(ClimateField::Temperature)] = kDefaultSettingsIntervalMs;
+    intervalMs_[static_cast<uint8_t>(ClimateField::FanSpeed)] = kDefaultFanVaneIntervalMs;
+    intervalMs_[static_cast<uint8_t>(ClimateField::VaneMode)] = kDefaultFanVaneIntervalMs;
+    intervalMs_[static_cast<uint8_t>(ClimateField::RoomTemperature)] = kDefaultRoomTemperatureIntervalMs;
+}
+
+void ClimatePoller::setInterval(ClimateField field, uint32_t intervalMs) {
+    if (field < ClimateField::Count) {
+        intervalMs_[static_cast<uint8_t>(field)] = intervalMs;
+    }
+}
+
+void ClimatePoller::setInterval(ClimateFieldMask fields, uint32_t intervalMs) {
+    for (uint8_t i = 0; i < static_cast<uint8_t>(ClimateField::Count); i++) {
+        if (fields & (1u << i)) {
+            intervalMs_[i] = intervalMs;
+        }
+    }
+}
+
+uint32_t ClimatePoller::interval(ClimateField field) const {
+    if (field >= ClimateField::Count) {
+        return 0;
+    }
+    return intervalMs_[static_cast<uint8_t>(field)];
+}
+
+ClimateFieldMask ClimatePoller::dueFields() const {
+    ClimateFieldMask due = 0;
+
+    for (uint8_t i = 0; i < static_cast<uint8_t>(ClimateField::Count); i++) {
+        uint32_t intervalMs = intervalMs_[i];
+        if (intervalMs == 0) {
+            continue;
+        }
+
+        if (climate_.fieldAgeMs(static_cast<ClimateField>(i)) < intervalMs) {
+            continue;
+        }
+
+        // A field that failed to refresh is retried at its own rate, not on every call.
+        if ((attemptedFields_ & (1u << i)) && time_elapsed_ms(attemptedAtMs_[i]) < intervalMs) {
+            continue;
+        }
+
+        due |= static_cast<ClimateFieldMask>(1u << i);
+    }
+
+    return due;
+}
+
+Result ClimatePoller::service() {
+    ClimateFieldMask due = dueFields();
+    if (due == 0) {
+        return kSuccess;
+    }
+
+    uint32_t now = time_now_ms();
+    for (uint8_t i = 0; i < static_cast<uint8_t>(ClimateField::Count); i++) {
+        if (due & (1u << i)) {
+            attemptedAtMs_[i] = now;
+        }
+    }
+    attemptedFields_ |= due;
+
+    Result ret = climate_.refresh(due);
+    if (ret != kSuccess) {
+        CLIMATE_LOG_WARNING("Poller: refresh of fields 0x%02X failed: %d", due, ret);
+    }
+    return ret;
+}
+
+}  // namespace climate_uart
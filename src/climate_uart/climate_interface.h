@@ -2,17 +2,123 @@
 
 #include "climate_uart/result.h"
 #include "climate_uart/climate_types.h"
+#include "climate_uart/handshake.h"
+#include "climate_uart/metrics.h"
+#include "climate_uart/trace.h"
+#include "climate_uart/snapshot.h"
 
 namespace climate_uart {
 
+using StateChangedCallback = void (*)(const ClimateSettings &settings, void *context);
+using RoomTemperatureChangedCallback = void (*)(float temperature, void *context);
+using ReadyCallback = void (*)(void *context);
+
 class ClimateInterface {
 public:
     virtual ~ClimateInterface() = default;
 
+    // Opens the transport and returns; the handshake with the unit runs from service()
+    // or lazily on the first call that needs it.
     virtual Result init() = 0;
     virtual Result setState(const ClimateSettings &settings) = 0;
     virtual Result getState(ClimateSettings &settings) = 0;
     virtual Result getRoomTemperature(float &temperature) = 0;
+
+    // Re-reads only the requested fields, using as few exchanges as the protocol allows.
+    // Results are published through the cache and the listeners below.
+    virtual Result refresh(ClimateFieldMask fields);
+
+    // Advances pending background work (one handshake step at a time) and returns quickly.
+    // Call it from the application loop. Returns kInProgress while the handshake is running.
+    virtual Result service();
+
+    bool isReady() const;
+    // Invoked each time the driver becomes ready (handshake done, or session restored).
+    void onReady(ReadyCallback callback, void *context = nullptr);
+    const HandshakeStats &handshakeStats() const;
+    // Frame, error and retry counters, and latency histograms per operation. Another task may
+    // call metrics().snapshot() while the driver runs.
+    const Metrics &metrics() const;
+
+    // Listeners are invoked from whichever call observes a new frame (getState, getRoomTemperature,
+    // refresh, or an unsolicited frame received while waiting for a reply), and only when the value changed.
+    void onStateChanged(StateChangedCallback callback, void *context = nullptr);
+    void onRoomTemperatureChanged(RoomTemperatureChangedCallback callback, float threshold = 0.5f,
+                                  void *context = nullptr);
+
+    // Last observed values; return false until every settings field (or the temperature) has been seen once.
+    bool cachedState(ClimateSettings &settings) const;
+    bool cachedRoomTemperature(float &temperature) const;
+    // Milliseconds since the field was last observed, UINT32_MAX if it never was.
+    uint32_t fieldAgeMs(ClimateField field) const;
+
+    // Warm start: serialise what the driver learned from the unit (last state, protocol
+    // bytes, session flags) and restore it before init() after a reboot, so the first
+    // reads and writes can go out without a full discovery cycle.
+    static constexpr size_t kSnapshotMaxSize = 64;
+    Result saveSnapshot(uint8_t *buffer, size_t *size) const;
+    Result restoreSnapshot(const uint8_t *buffer, size_t size);
+
+protected:
+    void notifyState(const ClimateSettings &settings, ClimateFieldMask fields = kSettingsFields);
+    void notifyRoomTemperature(float temperature);
+    void setReady(bool ready);
+
+    void beginHandshake();
+    void recordHandshakeStep(uint32_t stepStartMs);
+    void endHandshake(Result result);
+    uint32_t handshakeElapsedMs() const;
+
+    void countMetric(MetricCounter counter, uint32_t amount = 1);
+
+    // Records the time until the end of the enclosing scope into the operation's histogram.
+    // Only the outermost one counts: a getState() that runs a refresh() is one GetState sample.
+    class TimedOperation {
+    public:
+        TimedOperation(ClimateInterface &climate, MetricOperation operation);
+        ~TimedOperation();
+
+    private:
+        ClimateInterface &climate_;
+        MetricOperation operation_;
+        uint32_t startMs_;
+        bool outermost_;
+    };
+
+    // Drivers append their own state after a tag byte identifying the protocol. readSnapshot()
+    // runs once the rest of the snapshot has parsed; it validates everything it reads before
+    // changing any state.
+    virtual void writeSnapshot(SnapshotWriter &writer) const = 0;
+    virtual Result readSnapshot(SnapshotReader &reader) = 0;
+
+private:
+    void markRefreshed(ClimateFieldMask fields);
+
+    ClimateSettings cachedState_{};
+    float cachedRoomTemperature_{0.0f};
+    ClimateFieldMask knownFields_{0};
+    ClimateFieldMask staleFields_{0};
+    uint32_t refreshedAtMs_[static_cast<uint8_t>(ClimateField::Count)]{};
+
+    bool ready_{false};
+    ReadyCallback readyCallback_{nullptr};
+    void *readyContext_{nullptr};
+    HandshakeStats handshakeStats_{};
+    uint32_t handshakeStartMs_{0};
+    bool wasReady_{false};
+    Metrics metrics_{};
+    uint8_t timedDepth_{0};
+
+    StateChangedCallback stateCallback_{nullptr};
+    void *stateContext_{nullptr};
+    ClimateSettings lastState_{};
+    bool hasLastState_{false};
+
+    RoomTemperatureChangedCallback roomTemperatureCallback_{nullptr};
+    void *roomTemperatureContext_{nullptr};
+    float roomTemperatureThreshold_{0.5f};
+    float lastRoomTemperature_{0.0f};
+    bool hasLastRoomTemperature_{false};
 };
 
 }  // namespace climate_uart
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "climate_uart/climate_interface.h"
+
+namespace climate_uart {
+
+// Refreshes each field of a climate at its own rate. Every service() call gathers the
+// fields whose interval elapsed and hands them to ClimateInterface::refresh() in a single
+// call, so the driver can merge them into as few protocol exchanges as possible.
+// Fields updated by other paths (getState, unsolicited frames) are not polled again
+// until their interval elapses from that update.
+class ClimatePoller {
+public:
+    static constexpr uint32_t kDefaultSettingsIntervalMs = 2000;
+    static constexpr uint32_t kDefaultFanVaneIntervalMs = 5000;
+    static constexpr uint32_t kDefaultRoomTemperatureIntervalMs = 60000;
+
+    explicit ClimatePoller(ClimateInterface &climate);
+
+    // An interval of 0 disables polling of the field.
+    void setInterval(ClimateField field, uint32_t intervalMs);
+    void setInterval(ClimateFieldMask fields, uint32_t intervalMs);
+    uint32_t interval(ClimateField field) const;
+
+    ClimateFieldMask dueFields() const;
+
+    // Returns kSuccess when nothing was due.
+    Result service();
+
+private:
+    ClimateInterface &climate_;
+    uint32_t intervalMs_[static_cast<uint8_t>(ClimateField::Count)];
+    uint32_t attemptedAtMs_[static_cast<uint8_t>(ClimateField::Count)]{};
+    ClimateFieldMask attemptedFields_{0};
+};
+
+}  // namespace climate_uart
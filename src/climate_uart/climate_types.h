@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 namespace climate_uart {
 
 enum class HeatpumpMode : uint8_t {
@@ -39,6 +41,25 @@ enum class HeatpumpVaneMode : uint8_t {
     Count
 };
 
+enum class ClimateField : uint8_t {
+    Action = 0,
+    Mode,
+    Temperature,
+    FanSpeed,
+    VaneMode,
+    RoomTemperature,
+    Count
+};
+
+using ClimateFieldMask = uint8_t;
+
+constexpr ClimateFieldMask fieldMask(ClimateField field) {
+    return static_cast<ClimateFieldMask>(1u << static_cast<uint8_t>(field));
+}
+
+constexpr ClimateFieldMask kSettingsFields = 0x1F;
+constexpr ClimateFieldMask kAllFields = 0x3F;
+
 struct ClimateSettings {
     HeatpumpAction action{HeatpumpAction::Off};
     int temperature{0};
@@ -47,4 +68,13 @@ struct ClimateSettings {
     HeatpumpVaneMode vaneMode{HeatpumpVaneMode::Auto};
 };
 
+inline bool operator==(const ClimateSettings &lhs, const ClimateSettings &rhs) {
+    return lhs.action == rhs.action && lhs.temperature == rhs.temperature && lhs.fanSpeed == rhs.fanSpeed &&
+           lhs.mode == rhs.mode && lhs.vaneMode == rhs.vaneMode;
+}
+
+inline bool operator!=(const ClimateSettings &lhs, const ClimateSettings &rhs) {
+    return !(lhs == rhs);
+}
+
 }  // namespace climate_uart
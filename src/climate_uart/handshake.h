@@ -0,0 +1,34 @@
+#pragma once
+
+#include "climate_uart/result.h"
+#include "climate_uart/transport/uart_transport.h"
+
+namespace climate_uart {
+
+// Timing of the last handshake attempt, per step, to track reconnect latency in production.
+struct HandshakeStats {
+    static constexpr uint8_t kMaxSteps = 12;
+
+    Result result{kInProgress};
+    uint8_t steps{0};
+    uint16_t stepMs[kMaxSteps]{};
+    uint32_t totalMs{0};
+    uint32_t attempts{0};
+};
+
+constexpr uint32_t kQuietGapChars = 10;
+constexpr uint32_t kMinQuietGapMs = 5;
+
+constexpr uint32_t quietGapRawMs(uint32_t baudrate, uint32_t bitsPerChar) {
+    return (kQuietGapChars * bitsPerChar * 1000 + baudrate - 1) / baudrate;
+}
+
+// Line silence after which a burst of replies is considered over: kQuietGapChars character
+// times at the link settings, but never less than kMinQuietGapMs to absorb UART driver latency.
+constexpr uint32_t quietGapMs(uint32_t baudrate, transport::UartParity parity, uint8_t stopBits) {
+    return (quietGapRawMs(baudrate, transport::bitsPerChar(parity, stopBits)) < kMinQuietGapMs)
+               ? kMinQuietGapMs
+               : quietGapRawMs(baudrate, transport::bitsPerChar(parity, stopBits));
+}
+
+}  // namespace climate_uart
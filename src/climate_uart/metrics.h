@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace climate_uart {
+
+enum class MetricCounter : uint8_t {
+    FramesSent = 0,
+    FramesReceived,  // whole frames, checksum verified where the protocol has one
+    CrcErrors,       // frames whose checksum did not match, dropped or not (LG finds frames by
+                     // their checksum: its mismatches count as ResyncBytes)
+    Timeouts,        // expected frames that did not arrive in time
+    Naks,            // negative acknowledgements from the unit (Daikin NAK, Hitachi NG)
+    ResyncBytes,     // bytes discarded while hunting for the start of a frame
+    CorruptBytes,    // bytes of the frames counted in CrcErrors
+    Reconnects,      // handshakes started after the driver had been ready once
+    Retries,         // requests sent again after a failed exchange
+    Count
+};
+
+enum class MetricOperation : uint8_t {
+    Handshake = 0,
+    GetState,
+    SetState,
+    GetRoomTemperature,
+    Refresh,
+    Count
+};
+
+// Time spent in one operation, in fixed buckets so recording never allocates.
+struct LatencyHistogram {
+    static constexpr uint8_t kBuckets = 12;
+    // Inclusive upper bound of each bucket in ms; the last bucket takes everything above.
+    static constexpr uint16_t kUpperBoundMs[kBuckets - 1] = {1, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+    uint32_t counts[kBuckets]{};
+    uint32_t samples{0};
+    uint32_t totalMs{0};
+    uint32_t maxMs{0};
+
+    static uint8_t bucket(uint32_t elapsedMs);
+};
+
+struct MetricsSnapshot {
+    uint32_t counters[static_cast<uint8_t>(MetricCounter::Count)]{};
+    LatencyHistogram latency[static_cast<uint8_t>(MetricOperation::Count)]{};
+
+    uint32_t counter(MetricCounter which) const { return counters[static_cast<uint8_t>(which)]; }
+    const LatencyHistogram &histogram(MetricOperation operation) const {
+        return latency[static_cast<uint8_t>(operation)];
+    }
+};
+
+// Counters and latency histograms of one driver, in fixed storage so they can stay enabled
+// in production. The driver is the only writer. snapshot() can run from another task
+// without a lock: updates bump a sequence number around each write, and the reader copies
+// again when one raced its copy.
+class Metrics {
+public:
+    void increment(MetricCounter counter, uint32_t amount = 1);
+    void record(MetricOperation operation, uint32_t elapsedMs);
+    // Writer side only: call it from the task that drives the unit.
+    void reset();
+
+    // Returns false when the driver kept updating through every attempt (out is then stale).
+    bool snapshot(MetricsSnapshot &out) const;
+
+private:
+    static constexpr uint8_t kSnapshotAttempts = 4;
+
+    void beginWrite();
+    void endWrite();
+
+    uint32_t sequence_{0};
+    MetricsSnapshot data_{};
+};
+
+}  // namespace climate_uart
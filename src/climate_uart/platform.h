@@ -13,6 +13,14 @@ enum class LogLevel {
 
 uint32_t time_now_ms();
 uint32_t time_elapsed_ms(uint32_t start_ms);
+// Microsecond tick for trace timestamps; wraps every ~71 minutes.
+uint32_t time_now_us();
+
+// What is left of a budget_ms deadline that started at start_ms; 0 once it has passed.
+inline uint32_t time_remaining_ms(uint32_t start_ms, uint32_t budget_ms) {
+    uint32_t elapsed = time_elapsed_ms(start_ms);
+    return (elapsed < budget_ms) ? budget_ms - elapsed : 0;
+}
 
 void log_buffer(const uint8_t *buffer, size_t size);
 void log_write(LogLevel level, const char *format, ...);
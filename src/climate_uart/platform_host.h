@@ -0,0 +1,24 @@
+#pragma once
+
+#include "climate_uart/platform.h"
+
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+
+namespace climate_uart {
+namespace host {
+
+// Desktop builds (emulators, benchmarks, tools) get their time base and log sink from here.
+
+// Microsecond clock behind time_now_ms(). nullptr restores the monotonic system clock.
+using ClockFn = uint64_t (*)(void *context);
+void set_clock(ClockFn clock, void *context);
+uint64_t time_now_us();
+
+// Messages below minLevel are dropped; logging is on (kWarning and above) by default.
+void set_log_level(LogLevel minLevel);
+void set_log_enabled(bool enabled);
+
+}  // namespace host
+}  // namespace climate_uart
+
+#endif
@@ -14,24 +14,57 @@ public:
     Result setState(const ClimateSettings &settings) override;
     Result getState(ClimateSettings &settings) override;
     Result getRoomTemperature(float &temperature) override;
+    Result refresh(ClimateFieldMask fields) override;
 
-private:
+    static constexpr uint8_t kMaxCachedResponses = 8;
+    static constexpr uint8_t kMaxPayloadSize = 32;
+
+    // Runs the given two-character S21 queries ("F1", "F5", "RH", ...) back to back, acking each
+    // reply together with the next query, and caches every reply with its timestamp.
+    // Returns the last error if any query went unanswered; the others are still cached.
+    Result queryCycle(const char *const *queries, uint8_t count);
+    // Copies the cached reply to `query` if it is at most maxAgeMs old.
+    Result cachedResponse(const char *query, uint32_t maxAgeMs, uint8_t *payload, uint8_t *payloadLen) const;
+    // Replies younger than this are reused by getState/getRoomTemperature instead of re-querying.
+    void setCacheMaxAge(uint32_t maxAgeMs);
+
+    // S21 frame checksum (8-bit sum of the payload) and the ASCII mode/fan codes.
     static uint8_t checksum(const uint8_t *bytes, uint16_t len);
     static HeatpumpMode byteToMode(uint8_t mode);
     static uint8_t modeToByte(HeatpumpMode mode, HeatpumpAction action);
     static HeatpumpFanSpeed byteToFan(uint8_t code);
     static uint8_t fanToByte(HeatpumpFanSpeed fan);
 
+private:
+    void writeSnapshot(SnapshotWriter &writer) const override;
+    Result readSnapshot(SnapshotReader &reader) override;
+
     Result readByte(uint8_t *byte, uint32_t timeoutMs);
     Result waitForAck();
-    Result sendFrame(const uint8_t *frame, uint16_t frameLen);
-    Result readFrame(uint8_t *buffer, uint16_t *outSize);
-    Result query(const uint8_t *frame, uint16_t frameLen, uint8_t *payload, uint16_t *payloadLen);
+    Result sendFrame(const uint8_t *frame, uint16_t frameLen, bool ackPrevious = false);
+    Result readFrame(uint8_t *payload, uint16_t *payloadLen);
     Result sendCmd(const uint8_t *frame, uint16_t frameLen);
+
+    struct CachedResponse {
+        char query[2]{};
+        uint8_t payload[kMaxPayloadSize]{};
+        uint8_t size{0};
+        uint32_t timestampMs{0};
+    };
+
+    CachedResponse *findCached(const char *query);
+    const CachedResponse *findCached(const char *query) const;
+    void storeResponse(const char *query, const uint8_t *payload, uint8_t size);
+    void applyResponse(const uint8_t *payload, uint8_t size);
     Result setSwingSettings(bool swingV, bool swingH);
+    // For units without F5: vane mode is known as Auto without a query
+    void reportFixedVane();
 
     transport::UartTransport &uart_;
     bool connected_{false};
+    bool f5Supported_{true};
+    uint32_t cacheMaxAgeMs_{1000};
+    CachedResponse cache_[kMaxCachedResponses]{};
 };
 
 }  // namespace protocols
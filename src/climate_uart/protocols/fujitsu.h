@@ -14,22 +14,10 @@ public:
     Result setState(const ClimateSettings &settings) override;
     Result getState(ClimateSettings &settings) override;
     Result getRoomTemperature(float &temperature) override;
+    Result service() override;
 
-private:
-    enum class Address : uint8_t {
-        Start     = 0,
-        Unit      = 1,
-        Primary   = 32,
-        Secondary = 33,
-    };
-
-    enum class MessageType : uint8_t {
-        Status  = 0,
-        Error   = 1,
-        Login   = 2,
-        Unknown = 3,
-    };
-
+    // One 8-byte bus frame, decoded. encodeFrame/decodeFrame work on the plain bytes; the
+    // XOR 0xFF line coding is applied by the bus engine.
     struct Frame {
         uint8_t source{0};
         uint8_t dest{0};
@@ -56,24 +44,56 @@ private:
     static HeatpumpMode byteToMode(uint8_t val);
     static uint8_t fanToByte(HeatpumpFanSpeed fanSpeed);
     static HeatpumpFanSpeed byteToFan(uint8_t val);
+    static ClimateSettings frameToSettings(const Frame &frame);
+
+    static Frame decodeFrame(const uint8_t *buf);
+    static void encodeFrame(const Frame &frame, uint8_t *buf);
 
-    Frame decodeFrame(const uint8_t *buf);
-    void encodeFrame(const Frame &frame, uint8_t *buf);
+private:
+    void writeSnapshot(SnapshotWriter &writer) const override;
+    Result readSnapshot(SnapshotReader &reader) override;
+
+    enum class Address : uint8_t {
+        Start     = 0,
+        Unit      = 1,
+        Primary   = 32,
+        Secondary = 33,
+    };
 
-    Result readFrame(Frame &frame);
-    Result writeFrame(const Frame &frame);
+    enum class MessageType : uint8_t {
+        Status  = 0,
+        Error   = 1,
+        Login   = 2,
+        Unknown = 3,
+    };
+
+    void queueFrame(const Frame &frame);
+    Result sendPendingFrame();
+    void receiveEcho(uint8_t byte);
 
     Result processStatusFrame(Frame &rx, Frame &tx);
     Result processLoginFrame(Frame &rx, Frame &tx);
-    Result poll();
+    Result processFrame(const uint8_t *buf);
+    Result waitForLogin();
 
     transport::UartTransport &uart_;
     bool secondary_{false};
     uint8_t controllerAddress_{0};
+    bool opened_{false};
     bool loggedIn_{false};
     bool seenSecondary_{false};
+    bool warmStart_{false};
     uint32_t lastFrameMs_{0};
 
+    uint8_t rxBuf_[8]{};
+    uint8_t rxCount_{0};
+    uint32_t rxLastByteMs_{0};
+    uint8_t txBuf_[8]{};
+    bool txPending_{false};
+    bool txHadUpdate_{false};
+    uint32_t txSentMs_{0};
+    uint8_t echoCount_{0};
+
     ClimateSettings pendingUpdate_{};
     bool hasPendingUpdate_{false};
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "climate_uart/climate_interface.h"
+#include "climate_uart/protocols/hitachi_hlink_codec.h"
 #include "climate_uart/transport/uart_transport.h"
 
 namespace climate_uart {
@@ -14,21 +15,23 @@ public:
     Result setState(const ClimateSettings &settings) override;
     Result getState(ClimateSettings &settings) override;
     Result getRoomTemperature(float &temperature) override;
+    Result refresh(ClimateFieldMask fields) override;
 
-private:
-    enum class ResponseStatus : uint8_t {
-        Ok = 0,
-        Ng,
-        Invalid
-    };
-
-    struct Response {
-        ResponseStatus status{ResponseStatus::Invalid};
-        uint8_t data[32]{};
-        uint8_t dataLen{0};
-    };
-
-    static uint16_t crc(uint16_t address, const uint8_t *data, uint8_t dataLen);
+    using Response = hlink::Response;
+
+    static constexpr uint8_t kMaxBatchSize = 8;
+    static constexpr uint8_t kMaxPipelineDepth = 4;
+
+    // Queries `count` feature addresses in windows of pipelineDepth MT requests and matches
+    // the replies in order. results[i] is the outcome of addresses[i]; the return
+    // value is the last failure, if any. A reply lost while pipelining makes the driver fall
+    // back to depth 1 for good and re-query the outstanding addresses.
+    Result queryBatch(const uint16_t *addresses, uint8_t count, Response *responses, Result *results);
+    // 1 disables pipelining; clamped to kMaxPipelineDepth.
+    void setPipelineDepth(uint8_t depth);
+    uint8_t pipelineDepth() const { return pipelineDepth_; }
+
+    // Feature value mappings; framing lives in hitachi_hlink_codec.h.
     static uint16_t modeToWord(HeatpumpMode mode);
     static HeatpumpMode wordToMode(uint16_t val);
     static uint8_t fanToByte(HeatpumpFanSpeed fanSpeed);
@@ -36,15 +39,21 @@ private:
     static uint8_t vaneToByte(HeatpumpVaneMode vaneMode);
     static HeatpumpVaneMode byteToVane(uint8_t val);
 
+private:
+    void writeSnapshot(SnapshotWriter &writer) const override;
+    Result readSnapshot(SnapshotReader &reader) override;
+
     Result readByte(uint8_t *byte, uint32_t timeoutMs);
     Result readLine(char *buffer, uint16_t bufferSize, uint32_t timeoutMs);
-    Result parseResponse(const char *line, Response &response);
+    Result readResponse(Response &response);
     Result sendFrame(const char *type, uint16_t address, const uint8_t *data, uint8_t dataLen);
     Result query(uint16_t address, Response &response);
     Result command(uint16_t address, const uint8_t *data, uint8_t dataLen);
+    void drainLines();
 
     transport::UartTransport &uart_;
     bool connected_{false};
+    uint8_t pipelineDepth_{2};
 };
 
 }  // namespace protocols
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "climate_uart/result.h"
+
+#include <stddef.h>
+
+namespace climate_uart {
+namespace protocols {
+namespace hlink {
+
+// H-Link frames are ASCII lines: "MT P=0001 C=FFFE\r" out, "OK P=0010 C=FFEF\r" back.
+// Encoding and parsing work in place on caller buffers, without printf, strtok or heap.
+
+constexpr uint8_t kMaxRequestData = 8;
+constexpr uint8_t kMaxResponseData = 32;
+// "ST P=AAAA," + 8 data bytes + " C=CCCC\r" + NUL
+constexpr size_t kMaxFrameSize = 10 + kMaxRequestData * 2 + 8 + 1;
+
+enum class Status : uint8_t {
+    Ok = 0,
+    Ng,
+    Invalid
+};
+
+struct Response {
+    Status status{Status::Invalid};
+    uint8_t data[kMaxResponseData]{};
+    uint8_t dataLen{0};
+};
+
+uint16_t checksum(uint16_t address, const uint8_t *data, uint8_t dataLen);
+
+// Writes "<type> P=<address>[,<data>] C=<checksum>\r" and a terminating NUL into buffer.
+// type is the two-letter command ("MT" query, "ST" set). Returns the frame length without
+// the NUL, or 0 if the arguments are invalid or the frame does not fit.
+size_t encodeFrame(const char *type, uint16_t address, const uint8_t *data, uint8_t dataLen, char *buffer,
+                   size_t bufferSize);
+
+// Parses one received line (without '\r'): a bare "OK"/"NG", or "<..OK|..NG> P=<hex> C=<hex>"
+// with the checksum verified. Serial noise before OK/NG in the first token is tolerated.
+Result parseResponse(const char *line, Response &response);
+
+}  // namespace hlink
+}  // namespace protocols
+}  // namespace climate_uart
@@ -14,20 +14,42 @@ public:
     Result setState(const ClimateSettings &settings) override;
     Result getState(ClimateSettings &settings) override;
     Result getRoomTemperature(float &temperature) override;
+    Result service() override;
 
-private:
+    // 13-byte frames: crc is the byte sum XOR 0x55; isFrame checks type and crc of a window.
     static uint8_t crc(const uint8_t *buffer, size_t size);
+    static void decodeStatus(const uint8_t *status, ClimateSettings &settings);
+    static bool isFrame(const uint8_t *window);
+
+private:
+    void writeSnapshot(SnapshotWriter &writer) const override;
+    Result readSnapshot(SnapshotReader &reader) override;
 
     Result readByte(uint8_t *byte, uint32_t timeoutMs);
-    Result readMsg(uint8_t *buffer, size_t bufferSize);
+    bool pushByte(uint8_t byte, uint8_t *buffer);
+    Result readMsg(uint8_t *buffer, size_t bufferSize, uint32_t timeoutMs);
     Result writeMsg(uint8_t *buffer, size_t bufferSize);
-    Result readStatus(uint8_t *buffer, size_t bufferSize);
-    Result connect();
+    bool processMsg(const uint8_t *msg);
+    // Ingests what arrived without blocking; true when it held a unit status
+    bool pollBus();
+    // Waits for the next unit status; marks the link down when none comes
+    Result readStatus();
+    Result awaitFreshStatus();
+    Result connectStep();
 
     transport::UartTransport &uart_;
+    bool opened_{false};
     bool connected_{false};
+    bool warmStart_{false};
+    bool hasStatus_{false};
+    uint8_t handshakeStep_{0};
+    uint32_t stepStartMs_{0};
+    uint32_t lastStatusMs_{0};
     float roomTemperature_{20.0f};
     uint8_t lastRecvStatus_[13]{};
+    uint8_t rxWindow_[13]{};
+    uint8_t rxCount_{0};
+    uint32_t rxLastByteMs_{0};
 };
 
 }  // namespace protocols
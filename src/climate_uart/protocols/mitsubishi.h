@@ -14,8 +14,15 @@ public:
     Result setState(const ClimateSettings &settings) override;
     Result getState(ClimateSettings &settings) override;
     Result getRoomTemperature(float &temperature) override;
+    Result service() override;
+
+    // Two's complement of the sum of buffer[1..size), i.e. everything after STX.
+    static uint8_t crc(const uint8_t *buffer, uint8_t size);
 
 private:
+    void writeSnapshot(SnapshotWriter &writer) const override;
+    Result readSnapshot(SnapshotReader &reader) override;
+
     enum class PacketType : uint8_t {
         Unknown = 0x00,
         SetSettingsInformation,
@@ -35,15 +42,18 @@ private:
         uint8_t checksum{0};
     };
 
-    static uint8_t crc(const uint8_t *buffer, uint8_t size);
-
     Result readByte(uint8_t *byte, uint32_t timeoutMs);
     Result readPacket(Packet &packet);
     Result writePacket(const Packet &packet);
+    Result connectStep();
     Result connect();
 
     transport::UartTransport &uart_;
+    bool opened_{false};
     bool connected_{false};
+    bool warmStart_{false};
+    uint8_t handshakeStep_{0};
+    uint32_t stepStartMs_{0};
 };
 
 }  // namespace protocols
@@ -14,8 +14,26 @@ public:
     Result setState(const ClimateSettings &settings) override;
     Result getState(ClimateSettings &settings) override;
     Result getRoomTemperature(float &temperature) override;
+    Result service() override;
+
+    static constexpr uint8_t kCommandFrameSize = 14;
+
+    // Builds the 0xFB command frame for `settings` into buffer[kCommandFrameSize].
+    static void encodeCommand(const ClimateSettings &settings, uint8_t *buffer);
+    // crc: negated sum of buffer[1..size); cmdCrc: nibble parity of the command payload.
+    static uint8_t crc(const uint8_t *buffer, size_t size);
+    static uint8_t cmdCrc(const uint8_t *buffer);
+    static uint8_t modeToByte(HeatpumpMode mode);
+    static HeatpumpMode byteToMode(uint8_t val);
+    static uint8_t fanToByte(HeatpumpFanSpeed fanSpeed);
+    static HeatpumpFanSpeed byteToFan(uint8_t val);
+    static uint8_t vaneToByte(HeatpumpVaneMode vaneMode);
+    static HeatpumpVaneMode byteToVane(uint8_t val);
 
 private:
+    void writeSnapshot(SnapshotWriter &writer) const override;
+    Result readSnapshot(SnapshotReader &reader) override;
+
     struct Frame {
         uint8_t data[18];
         uint8_t size{0};
@@ -23,22 +41,27 @@ private:
 
     Result readByte(uint8_t *byte, uint16_t timeoutMs);
     Result readFrame(Frame &frame);
+    Result readFrame(Frame &frame, uint16_t firstByteTimeoutMs, uint16_t idleTimeoutMs);
     Result sendAck();
     Result sendCommand(const ClimateSettings &settings);
+    void awaitReplies(uint16_t replyTimeoutMs);
     void flushRx();
+    Result connectStep();
     Result connect();
+    void processFrame(const Frame &frame);
 
-    static uint8_t crc(const uint8_t *buffer, size_t size);
-    static uint8_t cmdCrc(const uint8_t *buffer);
-    static uint8_t modeToByte(HeatpumpMode mode);
-    static HeatpumpMode byteToMode(uint8_t val);
-    static uint8_t fanToByte(HeatpumpFanSpeed fanSpeed);
-    static HeatpumpFanSpeed byteToFan(uint8_t val);
-    static uint8_t vaneToByte(HeatpumpVaneMode vaneMode);
-    static HeatpumpVaneMode byteToVane(uint8_t val);
+    using FrameMatcher = bool (*)(const Frame &frame);
+    Result request(const uint8_t *msg, size_t size, FrameMatcher matches, Frame &frame);
+    static bool isModeFrame(const Frame &frame);
+    static bool isStatusFrame(const Frame &frame);
+
+    static bool decodeModeFrame(const Frame &frame, ClimateSettings &settings);
+    static bool decodeStatusFrame(const Frame &frame, float &temperature);
 
     transport::UartTransport &uart_;
+    bool opened_{false};
     bool connected_{false};
+    uint8_t handshakeStep_{0};
 };
 
 }  // namespace protocols
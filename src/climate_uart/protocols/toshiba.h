@@ -14,8 +14,22 @@ public:
     Result setState(const ClimateSettings &settings) override;
     Result getState(ClimateSettings &settings) override;
     Result getRoomTemperature(float &temperature) override;
+    Result service() override;
+    Result refresh(ClimateFieldMask fields) override;
+
+    // Packet checksum and function value mappings.
+    static uint8_t crc(const uint8_t *data, uint8_t dataLen);
+    static uint8_t modeToByte(HeatpumpMode mode);
+    static HeatpumpMode byteToMode(uint8_t val);
+    static uint8_t fanToByte(HeatpumpFanSpeed fanSpeed);
+    static HeatpumpFanSpeed byteToFan(uint8_t val);
+    static uint8_t vaneToByte(HeatpumpVaneMode vaneMode);
+    static HeatpumpVaneMode byteToVane(uint8_t val);
 
 private:
+    void writeSnapshot(SnapshotWriter &writer) const override;
+    Result readSnapshot(SnapshotReader &reader) override;
+
     struct Packet {
         uint8_t stx{0x00};
         uint8_t header[2]{};
@@ -27,24 +41,27 @@ private:
         uint8_t checksum{0x00};
     };
 
-    static uint8_t crc(const uint8_t *data, uint8_t dataLen);
-    static uint8_t modeToByte(HeatpumpMode mode);
-    static HeatpumpMode byteToMode(uint8_t val);
-    static uint8_t fanToByte(HeatpumpFanSpeed fanSpeed);
-    static HeatpumpFanSpeed byteToFan(uint8_t val);
-    static uint8_t vaneToByte(HeatpumpVaneMode vaneMode);
-    static HeatpumpVaneMode byteToVane(uint8_t val);
-
     Result readByte(uint8_t *byte, uint32_t timeoutMs);
     Result readPacket(Packet &packet);
+    Result readPacket(Packet &packet, uint32_t firstByteTimeoutMs, uint32_t idleTimeoutMs);
     Result sendCommand(uint8_t *data, uint16_t dataSize);
     Result query(uint8_t function, Packet &result);
+    static ClimateFieldMask decodeReply(const Packet &packet, ClimateSettings &settings, float &roomTemperature);
+    // A reply to the status query (function 0x88) whose checksum holds
+    static bool isStatusReply(const Packet &packet);
+    ClimateFieldMask applyReply(const Packet &packet);
+    void awaitReplies(uint32_t replyTimeoutMs);
     void flushRx();
+    Result connectStep();
     Result connect();
     Result command(uint8_t function, uint8_t value);
 
     transport::UartTransport &uart_;
+    bool opened_{false};
     bool connected_{false};
+    bool warmStart_{false};
+    uint8_t handshakeStep_{0};
+    ClimateFieldMask statusFields_{kAllFields};
 };
 
 }  // namespace protocols
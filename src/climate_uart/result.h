@@ -22,5 +22,6 @@ constexpr Result kInvalidParameters = -13;
 constexpr Result kInvalidState = -14;
 constexpr Result kInvalidNotConnected = -15;
 constexpr Result kInvalidReply = -16;
+constexpr Result kInProgress = -17;
 
 }  // namespace climate_uart
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace climate_uart {
+
+// Minimal little-endian writer/reader used by drivers to serialise what they learned
+// from the unit (see ClimateInterface::saveSnapshot). Both stop at the buffer end and
+// report it through ok() instead of writing or reading out of bounds.
+class SnapshotWriter {
+public:
+    SnapshotWriter(uint8_t *buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+    void putU8(uint8_t value) { putBytes(&value, 1); }
+    void putU16(uint16_t value) {
+        uint8_t bytes[2] = {static_cast<uint8_t>(value & 0xFF), static_cast<uint8_t>(value >> 8)};
+        putBytes(bytes, sizeof(bytes));
+    }
+    void putBytes(const uint8_t *data, size_t size) {
+        if (!ok_ || size > capacity_ - size_) {
+            ok_ = false;
+            return;
+        }
+        memcpy(&buffer_[size_], data, size);
+        size_ += size;
+    }
+
+    bool ok() const { return ok_; }
+    size_t size() const { return size_; }
+
+private:
+    uint8_t *buffer_;
+    size_t capacity_;
+    size_t size_{0};
+    bool ok_{true};
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const uint8_t *buffer, size_t size) : buffer_(buffer), size_(size) {}
+
+    uint8_t getU8() {
+        uint8_t value = 0;
+        getBytes(&value, 1);
+        return value;
+    }
+    uint16_t getU16() {
+        uint8_t bytes[2] = {0, 0};
+        getBytes(bytes, sizeof(bytes));
+        return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+    }
+    void getBytes(uint8_t *data, size_t size) {
+        if (!ok_ || size > size_ - pos_) {
+            ok_ = false;
+            memset(data, 0x00, size);
+            return;
+        }
+        memcpy(data, &buffer_[pos_], size);
+        pos_ += size;
+    }
+
+    bool ok() const { return ok_; }
+    size_t remaining() const { return size_ - pos_; }
+
+private:
+    const uint8_t *buffer_;
+    size_t size_;
+    size_t pos_{0};
+    bool ok_{true};
+};
+
+}  // namespace climate_uart
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "climate_uart/climate_interface.h"
+
+namespace climate_uart {
+namespace storage {
+
+// Persists one opaque snapshot blob (at most ClimateInterface::kSnapshotMaxSize bytes,
+// checksummed by the snapshot itself) so it fits an NVS entry or a small EEPROM area.
+class StateStorage {
+public:
+    virtual ~StateStorage() = default;
+
+    // On input *size is the buffer capacity, on output the number of bytes loaded.
+    virtual Result load(uint8_t *buffer, size_t *size) = 0;
+    virtual Result save(const uint8_t *buffer, size_t size) = 0;
+};
+
+// Call saveState() after the driver learned something worth keeping (e.g. periodically or
+// before a planned reboot) and restoreState() before init().
+Result saveState(const ClimateInterface &climate, StateStorage &storage);
+Result restoreState(ClimateInterface &climate, StateStorage &storage);
+
+}  // namespace storage
+}  // namespace climate_uart
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "climate_uart/storage/state_storage.h"
+
+#if !defined(ARDUINO) || defined(ARDUINO_ARCH_ESP32)
+
+namespace climate_uart {
+namespace storage {
+
+// Stores the snapshot in a regular file (Linux gateways, or a mounted VFS partition on ESP32).
+// The file is replaced atomically through a temporary sibling so a power cut never leaves
+// a truncated snapshot behind.
+class StateStorageFile : public StateStorage {
+public:
+    explicit StateStorageFile(const char *path);
+
+    Result load(uint8_t *buffer, size_t *size) override;
+    Result save(const uint8_t *buffer, size_t size) override;
+
+private:
+    const char *path_;
+};
+
+}  // namespace storage
+}  // namespace climate_uart
+
+#endif
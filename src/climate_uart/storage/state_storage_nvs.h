@@ -0,0 +1,26 @@
+#pragma once
+
+#include "climate_uart/storage/state_storage.h"
+
+#ifdef ESP_PLATFORM
+
+namespace climate_uart {
+namespace storage {
+
+// Stores the snapshot as an NVS blob. nvs_flash_init() must have been called by the application.
+class StateStorageNvs : public StateStorage {
+public:
+    StateStorageNvs(const char *nameSpace, const char *key);
+
+    Result load(uint8_t *buffer, size_t *size) override;
+    Result save(const uint8_t *buffer, size_t size) override;
+
+private:
+    const char *nameSpace_;
+    const char *key_;
+};
+
+}  // namespace storage
+}  // namespace climate_uart
+
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Trace points are compiled in only when the library is built with CLIMATE_UART_TRACE=1
+// (CMake option of the same name); otherwise every CLIMATE_TRACE_* macro expands to nothing.
+#ifndef CLIMATE_UART_TRACE
+#define CLIMATE_UART_TRACE 0
+#endif
+
+namespace climate_uart {
+
+enum class TracePhase : uint8_t {
+    Begin,
+    End,
+    Instant,
+};
+
+struct TraceEvent {
+    uint32_t timeUs;
+    const char *name;    // string literal, never copied
+    const void *source;  // the driver that recorded it, one timeline per driver
+    uint16_t arg;        // byte count, step or function code; meaning depends on the event
+    TracePhase phase;
+};
+
+// Fixed-size ring of trace events over caller-provided storage; once full, the oldest events
+// are overwritten. Recording and reading are meant for the task that drives the units.
+class TraceBuffer {
+public:
+    TraceBuffer(TraceEvent *storage, size_t capacity) : events_(storage), capacity_(capacity) {}
+
+    void record(TracePhase phase, const char *name, const void *source, uint16_t arg);
+    void clear();
+
+    // Oldest first
+    size_t size() const { return count_; }
+    const TraceEvent &at(size_t index) const;
+    // Events overwritten since the last clear()
+    uint32_t overwritten() const { return overwritten_; }
+
+private:
+    TraceEvent *events_;
+    size_t capacity_;
+    size_t head_{0};
+    size_t count_{0};
+    uint32_t overwritten_{0};
+};
+
+// Buffer the trace points write to; nullptr (the default) records nothing.
+void trace_set_buffer(TraceBuffer *buffer);
+// Names the timeline of one driver in exports (e.g. "Toshiba"); up to kTraceMaxSources.
+constexpr uint8_t kTraceMaxSources = 8;
+void trace_set_source_name(const void *source, const char *name);
+void trace_record(TracePhase phase, const char *name, const void *source, uint16_t arg = 0);
+
+// Writes the buffer as Chrome trace_event JSON (chrome://tracing, Perfetto) in small chunks
+// through `write`, without allocating. Timestamps are relative to the oldest event.
+using TraceWriteFn = void (*)(const char *data, size_t size, void *context);
+void trace_export_chrome(const TraceBuffer &buffer, TraceWriteFn write, void *context);
+
+// Begin on construction, End on scope exit
+class TraceSpan {
+public:
+    TraceSpan(const char *name, const void *source, uint16_t arg = 0) : name_(name), source_(source) {
+        trace_record(TracePhase::Begin, name, source, arg);
+    }
+    ~TraceSpan() { trace_record(TracePhase::End, name_, source_); }
+
+private:
+    const char *name_;
+    const void *source_;
+};
+
+}  // namespace climate_uart
+
+#define CLIMATE_TRACE_CONCAT_INNER(a, b) a##b
+#define CLIMATE_TRACE_CONCAT(a, b) CLIMATE_TRACE_CONCAT_INNER(a, b)
+
+// Used from driver member functions: the driver (`this`) is the timeline.
+#if CLIMATE_UART_TRACE
+    #define CLIMATE_TRACE_SPAN(name, arg) \
+        ::climate_uart::TraceSpan CLIMATE_TRACE_CONCAT(traceSpan, __LINE__)(name, this, arg)
+    #define CLIMATE_TRACE_BEGIN(name, arg) \
+        ::climate_uart::trace_record(::climate_uart::TracePhase::Begin, name, this, arg)
+    #define CLIMATE_TRACE_END(name) ::climate_uart::trace_record(::climate_uart::TracePhase::End, name, this)
+    #define CLIMATE_TRACE_INSTANT(name, arg) \
+        ::climate_uart::trace_record(::climate_uart::TracePhase::Instant, name, this, arg)
+#else
+    #define CLIMATE_TRACE_SPAN(name, arg) do {} while (0)
+    #define CLIMATE_TRACE_BEGIN(name, arg) do {} while (0)
+    #define CLIMATE_TRACE_END(name) do {} while (0)
+    #define CLIMATE_TRACE_INSTANT(name, arg) do {} while (0)
+#endif
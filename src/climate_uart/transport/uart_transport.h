@@ -11,6 +11,34 @@ enum class UartParity : uint8_t {
     Odd
 };
 
+// Bits one 8-bit character occupies on the wire: start bit, data bits, parity bit, stop bits.
+constexpr uint32_t bitsPerChar(UartParity parity, uint8_t stopBits) {
+    return 1 + 8 + ((parity == UartParity::None) ? 0 : 1) + stopBits;
+}
+
+// On-wire time of the traffic through one transport since open() (or resetWireStats()),
+// at the baud rate, parity and stop bits it was opened with. Each direction is its own line;
+// on a single-wire bus (LG, Fujitsu) the receive line also carries our own echo, so its busy
+// time is the whole bus.
+struct WireStats {
+    uint32_t baudrate{0};
+    uint8_t bitsPerChar{0};
+    uint32_t bytesSent{0};
+    uint32_t bytesReceived{0};
+    uint64_t txBusyUs{0};
+    uint64_t rxBusyUs{0};
+    uint64_t windowUs{0};  // time observed
+
+    // Wire time of `bytes` characters at the current settings, e.g. of the bytes a driver
+    // discarded (MetricCounter::ResyncBytes, MetricCounter::CorruptBytes).
+    uint64_t wireTimeUs(uint32_t bytes) const;
+    uint64_t txIdleUs() const { return (windowUs > txBusyUs) ? windowUs - txBusyUs : 0; }
+    uint64_t rxIdleUs() const { return (windowUs > rxBusyUs) ? windowUs - rxBusyUs : 0; }
+    // Busy share of each line, 0 to 1
+    float txUtilisation() const;
+    float rxUtilisation() const;
+};
+
 class UartTransport {
 public:
     virtual ~UartTransport() = default;
@@ -20,6 +48,25 @@ public:
     virtual size_t available() = 0;
     virtual Result read(uint8_t *buffer, size_t *size) = 0;
     virtual Result write(const uint8_t *buffer, size_t size) = 0;
+
+    // windowUs runs up to now. Call it from the task that drives the unit.
+    WireStats wireStats() const;
+    void resetWireStats();
+
+protected:
+    // Implementations report what crossed the line: open() its settings (which restarts the
+    // accounting), read() and write() the byte counts.
+    void wireOpened(uint32_t baudrate, UartParity parity, uint8_t stopBits);
+    void wireSent(size_t size);
+    void wireReceived(size_t size);
+
+private:
+    // Folds the time since the last update into windowUs. Updates come with every read and
+    // write, so the 32-bit microsecond tick never wraps in between on a polled bus.
+    void advanceWindow();
+
+    WireStats wire_{};
+    uint32_t wireUpdatedUs_{0};
 };
 
 }  // namespace transport
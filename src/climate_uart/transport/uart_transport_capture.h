@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "climate_uart/transport/uart_transport.h"
+
+namespace climate_uart {
+namespace transport {
+
+// Capture format: append-only, written as the traffic happens.
+//   magic   'C' 'U' 'C' kCaptureVersion
+//   record  tag, varint delta in µs since the previous record (since the capture started for
+//           the first one), then a body depending on the kind in the tag's top two bits:
+//             rx, tx  length in the low six bits (63: a varint length follows), then the bytes
+//             open    varint baud rate, parity byte, stop bits byte
+//             close   nothing
+// Varints are LEB128 (7 bits per byte, low bits first). Each rx record is one read() that
+// returned data, each tx record one write(), so a byte read alone costs about four bytes.
+constexpr uint8_t kCaptureMagic[3] = {'C', 'U', 'C'};
+constexpr uint8_t kCaptureVersion = 1;
+
+enum class CaptureRecord : uint8_t {
+    Rx = 0,
+    Tx,
+    Open,
+    Close,
+};
+
+constexpr uint8_t kCaptureInlineLengthMax = 62;
+// Magic and version
+constexpr size_t kCaptureHeaderSize = 4;
+
+// One record, read in place: `data` points into the capture. Only the fields of its kind
+// are set.
+struct CaptureRecordView {
+    CaptureRecord kind;
+    uint32_t deltaUs;
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t baudrate;
+    uint8_t parity;
+    uint8_t stopBits;
+};
+
+// The capture starts with the magic and the version this library writes.
+bool isCapture(const uint8_t *capture, size_t size);
+
+// Reads the record at `offset` and moves `offset` past it. False at the end of the capture
+// and on a record cut short (a capture ended by a power loss), `offset` left on it.
+bool readCaptureRecord(const uint8_t *capture, size_t size, size_t &offset, CaptureRecordView &record);
+
+using CaptureWriteFn = void (*)(const uint8_t *data, size_t size, void *context);
+
+// UartTransport decorator that passes everything through to `inner` and records it in the
+// capture format through `write` (a file, a flash partition, a socket...). Records go out
+// whole, as soon as they happen; nothing is buffered or allocated. Deltas come from the 32-bit
+// microsecond tick, so a silence of over 71 minutes is recorded modulo that.
+class UartTransportCapture : public UartTransport {
+public:
+    explicit UartTransportCapture(UartTransport &inner, CaptureWriteFn write = nullptr, void *context = nullptr);
+
+    // Starts a new capture (magic first) on `write`; nullptr stops capturing. Set it before
+    // the driver's init() so the capture begins with the line settings.
+    void setSink(CaptureWriteFn write, void *context);
+
+    Result open(uint32_t baudrate, UartParity parity, uint8_t stopBits) override;
+    Result close() override;
+    size_t available() override;
+    Result read(uint8_t *buffer, size_t *size) override;
+    Result write(const uint8_t *buffer, size_t size) override;
+
+    // Traffic passes through either way; the next record after a pause carries the whole gap.
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    // Capture bytes handed to the write function so far, magic included
+    uint32_t bytesCaptured() const { return bytesCaptured_; }
+
+private:
+    void emit(const uint8_t *data, size_t size);
+    void record(CaptureRecord kind, const uint8_t *data, size_t size);
+    void recordOpen(uint32_t baudrate, UartParity parity, uint8_t stopBits);
+    size_t beginRecord(uint8_t *header, CaptureRecord kind, uint8_t lowBits);
+
+    UartTransport &inner_;
+    CaptureWriteFn write_;
+    void *context_;
+    bool enabled_{true};
+    bool started_{false};
+    uint32_t lastRecordUs_{0};
+    uint32_t bytesCaptured_{0};
+};
+
+}  // namespace transport
+}  // namespace climate_uart
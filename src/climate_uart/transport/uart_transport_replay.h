@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "climate_uart/transport/uart_transport_capture.h"
+
+namespace climate_uart {
+namespace transport {
+
+// Feeds a recorded session (UartTransportCapture format) back to a driver. Received chunks
+// come out in their recorded order and sizes, each once its recorded time has come and the
+// driver has written at least as many bytes as had been sent before it, so a reply never
+// overtakes its request. What the driver writes is compared with the recorded transmissions.
+// Under a deterministic clock the driver sees exactly the recorded bytes at the recorded
+// times; accelerated replays keep the order but not the driver's own timeouts.
+class UartTransportReplay : public UartTransport {
+public:
+    // The capture is read in place and must outlive the transport.
+    UartTransportReplay(const uint8_t *capture, size_t size);
+
+    // Recorded gaps divided by `speed`: 1 replays at the original pace, 0 releases each chunk
+    // as soon as what preceded it was written.
+    void setSpeed(uint8_t speed) { speed_ = speed; }
+
+    // Called when the driver polls and nothing is ready yet, with the time until the next
+    // chunk is due (UINT32_MAX while it waits on the driver's writes, or at the end).
+    // A host harness advances its virtual clock from here.
+    using IdleHook = void (*)(uint32_t dueInUs, void *context);
+    void setIdleHook(IdleHook hook, void *context);
+
+    // kInvalidData when the capture is not in a known format. The replay clock starts at
+    // the first open(); a capture starting mid-session replays from its first record.
+    Result open(uint32_t baudrate, UartParity parity, uint8_t stopBits) override;
+    Result close() override;
+    size_t available() override;
+    Result read(uint8_t *buffer, size_t *size) override;
+    Result write(const uint8_t *buffer, size_t size) override;
+
+    // Every recorded chunk has been delivered.
+    bool finished();
+    // Recorded length of the session in µs
+    uint64_t durationUs() const;
+
+    // Written bytes that differ from the recording (or came after its end), and the
+    // recorded bytes compared so far
+    uint32_t txMismatches() const { return txMismatches_; }
+    uint32_t txCompared() const { return txCompared_; }
+    // open() calls whose settings differ from the recorded ones
+    uint32_t settingsMismatches() const { return settingsMismatches_; }
+
+private:
+    // Walks the records in order, keeping the recorded time and the bytes sent up to here.
+    struct Cursor {
+        size_t offset;
+        uint64_t timeUs;
+        uint32_t txBytes;
+    };
+
+    bool next(Cursor &cursor, CaptureRecordView &record) const;
+    void advanceClock();
+    // Makes the next due chunk current; false when none is ready
+    bool release();
+    void idle();
+
+    const uint8_t *capture_;
+    size_t size_;
+    bool valid_{false};
+    uint8_t speed_{1};
+    IdleHook idleHook_{nullptr};
+    void *idleContext_{nullptr};
+
+    bool started_{false};
+    uint64_t elapsedUs_{0};
+    uint32_t lastClockUs_{0};
+
+    Cursor rx_{};
+    const uint8_t *chunk_{nullptr};
+    uint32_t chunkLeft_{0};
+    uint32_t txWritten_{0};
+
+    Cursor tx_{};
+    const uint8_t *txChunk_{nullptr};
+    uint32_t txChunkLeft_{0};
+    Cursor open_{};
+
+    uint32_t txMismatches_{0};
+    uint32_t txCompared_{0};
+    uint32_t settingsMismatches_{0};
+};
+
+}  // namespace transport
+}  // namespace climate_uart
@@ -0,0 +1,76 @@
+#include "climate_uart/metrics.h"
+
+#include <string.h>
+
+namespace climate_uart {
+
+constexpr uint16_t LatencyHistogram::kUpperBoundMs[];
+
+uint8_t LatencyHistogram::bucket(uint32_t elapsedMs) {
+    uint8_t i = 0;
+    while (i < kBuckets - 1 && elapsedMs > kUpperBoundMs[i]) {
+        i++;
+    }
+    return i;
+}
+
+// Sequence lock: odd while an update is in flight. The GCC atomic builtins are available on
+// every toolchain the library targets (ESP-IDF, Arduino, host) and need no <atomic>.
+void Metrics::beginWrite() {
+    __atomic_store_n(&sequence_, sequence_ + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void Metrics::endWrite() {
+    __atomic_store_n(&sequence_, sequence_ + 1, __ATOMIC_RELEASE);
+}
+
+void Metrics::increment(MetricCounter counter, uint32_t amount) {
+    if (counter >= MetricCounter::Count) {
+        return;
+    }
+
+    beginWrite();
+    data_.counters[static_cast<uint8_t>(counter)] += amount;
+    endWrite();
+}
+
+void Metrics::record(MetricOperation operation, uint32_t elapsedMs) {
+    if (operation >= MetricOperation::Count) {
+        return;
+    }
+
+    beginWrite();
+    LatencyHistogram &histogram = data_.latency[static_cast<uint8_t>(operation)];
+    histogram.counts[LatencyHistogram::bucket(elapsedMs)]++;
+    histogram.samples++;
+    histogram.totalMs += elapsedMs;
+    if (elapsedMs > histogram.maxMs) {
+        histogram.maxMs = elapsedMs;
+    }
+    endWrite();
+}
+
+void Metrics::reset() {
+    beginWrite();
+    data_ = MetricsSnapshot{};
+    endWrite();
+}
+
+bool Metrics::snapshot(MetricsSnapshot &out) const {
+    for (uint8_t attempt = 0; attempt < kSnapshotAttempts; attempt++) {
+        uint32_t before = __atomic_load_n(&sequence_, __ATOMIC_ACQUIRE);
+        if (before & 1u) {
+            continue;
+        }
+
+        memcpy(&out, &data_, sizeof(out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&sequence_, __ATOMIC_RELAXED) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace climate_uart
@@ -19,6 +19,10 @@ uint32_t time_elapsed_ms(uint32_t start_ms) {
     return time_now_ms() - start_ms;
 }
 
+uint32_t time_now_us() {
+    return static_cast<uint32_t>(micros());
+}
+
 const char *level_prefix(LogLevel level) {
     switch (level) {
         case LogLevel::kDebug:
@@ -15,6 +15,10 @@ uint32_t time_elapsed_ms(uint32_t start_ms) {
     return time_now_ms() - start_ms;
 }
 
+uint32_t time_now_us() {
+    return static_cast<uint32_t>(esp_timer_get_time());
+}
+
 }  // namespace climate_uart
 
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "climate_uart/platform_host.h"
+
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace climate_uart {
+
+namespace {
+host::ClockFn clockFn = nullptr;
+void *clockContext = nullptr;
+LogLevel logLevel = LogLevel::kWarning;
+bool logEnabled = true;
+
+const char *level_prefix(LogLevel level) {
+    switch (level) {
+        case LogLevel::kDebug:
+            return "D";
+        case LogLevel::kInfo:
+            return "I";
+        case LogLevel::kWarning:
+            return "W";
+        case LogLevel::kError:
+            return "E";
+        default:
+            return "?";
+    }
+}
+}  // namespace
+
+namespace host {
+
+void set_clock(ClockFn clock, void *context) {
+    clockFn = clock;
+    clockContext = context;
+}
+
+uint64_t time_now_us() {
+    if (clockFn) {
+        return clockFn(clockContext);
+    }
+
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+void set_log_level(LogLevel minLevel) {
+    logLevel = minLevel;
+}
+
+void set_log_enabled(bool enabled) {
+    logEnabled = enabled;
+}
+
+}  // namespace host
+
+uint32_t time_now_ms() {
+    return static_cast<uint32_t>(host::time_now_us() / 1000ULL);
+}
+
+uint32_t time_elapsed_ms(uint32_t start_ms) {
+    return time_now_ms() - start_ms;
+}
+
+uint32_t time_now_us() {
+    return static_cast<uint32_t>(host::time_now_us());
+}
+
+void log_buffer(const uint8_t *buffer, size_t size) {
+    if (!buffer || size == 0 || !logEnabled || logLevel > LogLevel::kDebug) {
+        return;
+    }
+
+    fprintf(stderr, "[climate-uart][B]");
+    for (size_t i = 0; i < size; ++i) {
+        fprintf(stderr, " %02X", buffer[i]);
+    }
+    fprintf(stderr, "\n");
+}
+
+void log_write(LogLevel level, const char *format, ...) {
+    if (!logEnabled || level < logLevel) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[climate-uart][%s] ", level_prefix(level));
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+}  // namespace climate_uart
+
+#endif
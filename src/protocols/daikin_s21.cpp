@@ -17,15 +17,19 @@ constexpr uint8_t kS21Etx = 0x03;
 constexpr uint8_t kS21Ack = 0x06;
 constexpr uint8_t kS21Nak = 0x15;
 constexpr uint32_t kResponseTimeoutMs = 250;
+// Whole frame after STX: the longest reply is ~100 ms on the wire at 2400 baud
+constexpr uint32_t kFrameTimeoutMs = 2 * kResponseTimeoutMs;
 constexpr uint16_t kMaxFrameSize = 64;
 constexpr int kMinTemperature = 18;
 constexpr int kMaxTemperature = 32;
 constexpr int kSetpointOffset = 28;
 constexpr int kSetpointStep = 5;
 
-constexpr uint8_t kQueryF1[2] = {'F', '1'};
-constexpr uint8_t kQueryF5[2] = {'F', '5'};
-constexpr uint8_t kQueryRh[2] = {'R', 'H'};
+constexpr char kQueryF1[] = "F1";
+constexpr char kQueryF5[] = "F5";
+constexpr char kQueryRh[] = "RH";
+
+constexpr uint8_t kSnapshotTag = 'D';
 }  // namespace
 
 DaikinS21::DaikinS21(transport::UartTransport &uart) : uart_(uart) {}
@@ -124,6 +128,7 @@ Result DaikinS21::readByte(uint8_t *byte, uint32_t timeoutMs) {
 	}
 
 	CLIMATE_LOG_DEBUG("Daikin ReadByte Timeout (%u ms)", timeoutMs);
+	countMetric(MetricCounter::Timeouts);
 	return kTimeout;
 }
 
@@ -138,105 +143,241 @@ Result DaikinS21::waitForAck() {
 	if (byte == kS21Ack) {
 		return kSuccess;
 	}
+	if (byte == kS21Nak) {
+		countMetric(MetricCounter::Naks);
+	}
 
 	CLIMATE_LOG_WARNING("Daikin: Unexpected byte waiting for ACK: 0x%02X", byte);
 	return kInvalidReply;
 }
 
-Result DaikinS21::sendFrame(const uint8_t *frame, uint16_t frameLen) {
-	if (!frame || frameLen == 0) {
+Result DaikinS21::sendFrame(const uint8_t *frame, uint16_t frameLen, bool ackPrevious) {
+	if (!frame || frameLen == 0 || frameLen > kMaxFrameSize) {
 		return kInvalidParameters;
 	}
 
-	Result ret = uart_.write(&kS21Stx, 1);
-	if (ret != kSuccess) {
-		return ret;
-	}
-
-	ret = uart_.write(frame, frameLen);
-	if (ret != kSuccess) {
-		return ret;
+	// One write per frame (and the ack of the previous reply): no gap between them on the wire.
+	uint8_t buffer[kMaxFrameSize + 4];
+	uint16_t pos = 0;
+	if (ackPrevious) {
+		buffer[pos++] = kS21Ack;
 	}
+	buffer[pos++] = kS21Stx;
+	memcpy(&buffer[pos], frame, frameLen);
+	pos = static_cast<uint16_t>(pos + frameLen);
+	buffer[pos++] = checksum(frame, frameLen);
+	buffer[pos++] = kS21Etx;
 
-	uint8_t cs = checksum(frame, frameLen);
-	ret = uart_.write(&cs, 1);
-	if (ret != kSuccess) {
-		return ret;
+	Result ret = uart_.write(buffer, pos);
+	if (ret == kSuccess) {
+		countMetric(MetricCounter::FramesSent);
 	}
-
-	return uart_.write(&kS21Etx, 1);
+	return ret;
 }
 
-Result DaikinS21::readFrame(uint8_t *buffer, uint16_t *outSize) {
-	if (!buffer || !outSize || *outSize == 0) {
+Result DaikinS21::readFrame(uint8_t *payload, uint16_t *payloadLen) {
+	if (!payload || !payloadLen || *payloadLen == 0) {
 		return kInvalidParameters;
 	}
 
-	uint16_t idx = 0;
-	memset(buffer, 0x00, *outSize);
-
-	while (buffer[idx] != kS21Stx) {
-		if (readByte(&buffer[idx], kResponseTimeoutMs) == kTimeout) {
+	uint8_t byte = 0;
+	while (byte != kS21Stx) {
+		if (readByte(&byte, kResponseTimeoutMs) == kTimeout) {
 			return kTimeout;
 		}
 
-		if (buffer[idx] != kS21Stx) {
-			CLIMATE_LOG_WARNING("Daikin: Discarded byte: 0x%02X", buffer[idx]);
+		if (byte != kS21Stx) {
+			CLIMATE_LOG_WARNING("Daikin: Discarded byte: 0x%02X", byte);
+			countMetric(MetricCounter::ResyncBytes);
 		}
 	}
+	CLIMATE_TRACE_INSTANT("first byte", 0);
 
-	while ((buffer[++idx] != kS21Etx) && (idx < *outSize - 1)) {
-		if (readByte(&buffer[idx], kResponseTimeoutMs) != kSuccess) {
+	// Payload and checksum up to ETX, bounded as a whole so a unit dripping bytes just inside
+	// the byte timeout cannot hold the caller indefinitely
+	uint32_t frameStart = time_now_ms();
+	uint16_t idx = 0;
+	for (;;) {
+		uint32_t remaining = time_remaining_ms(frameStart, kFrameTimeoutMs);
+		if (remaining == 0 ||
+			readByte(&byte, remaining < kResponseTimeoutMs ? remaining : kResponseTimeoutMs) != kSuccess) {
 			CLIMATE_LOG_WARNING("Daikin: Timeout reading frame");
 			return kTimeout;
 		}
+		if (byte == kS21Etx) {
+			CLIMATE_TRACE_INSTANT("last byte", idx + 2);
+			break;
+		}
+		if (idx >= *payloadLen) {
+			CLIMATE_LOG_ERROR("Daikin: Frame too long");
+			return kInvalidData;
+		}
+		payload[idx++] = byte;
+	}
+
+	if (idx < 1) {
+		return kInvalidData;
 	}
 
-	uint8_t calculated = checksum(buffer, static_cast<uint16_t>(idx - 1));
-	if (buffer[idx - 1] != calculated) {
-		CLIMATE_LOG_ERROR("Daikin: Checksum mismatch %02X != %02X", buffer[idx - 1], calculated);
-		CLIMATE_LOG_BUFFER(buffer, idx);
+	uint16_t size = static_cast<uint16_t>(idx - 1);
+	uint8_t calculated = checksum(payload, size);
+	if (payload[size] != calculated) {
+		CLIMATE_LOG_ERROR("Daikin: Checksum mismatch %02X != %02X", payload[size], calculated);
+		CLIMATE_LOG_BUFFER(payload, idx);
+		countMetric(MetricCounter::CrcErrors);
+		countMetric(MetricCounter::CorruptBytes, idx + 2u);
 		return kInvalidCrc;
 	}
 
-	*outSize = static_cast<uint16_t>(idx + 1);
+	countMetric(MetricCounter::FramesReceived);
+	*payloadLen = size;
 	return kSuccess;
 }
 
-Result DaikinS21::query(const uint8_t *frame, uint16_t frameLen, uint8_t *payload, uint16_t *payloadLen) {
-	if (!frame || !payload || !payloadLen) {
+DaikinS21::CachedResponse *DaikinS21::findCached(const char *query) {
+	for (CachedResponse &entry : cache_) {
+		if (entry.size > 0 && entry.query[0] == query[0] && entry.query[1] == query[1]) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+const DaikinS21::CachedResponse *DaikinS21::findCached(const char *query) const {
+	return const_cast<DaikinS21 *>(this)->findCached(query);
+}
+
+void DaikinS21::storeResponse(const char *query, const uint8_t *payload, uint8_t size) {
+	CachedResponse *entry = findCached(query);
+	if (!entry) {
+		// Free slot, else the oldest reply
+		entry = &cache_[0];
+		for (CachedResponse &candidate : cache_) {
+			if (candidate.size == 0) {
+				entry = &candidate;
+				break;
+			}
+			if (candidate.timestampMs - entry->timestampMs > 0x80000000u) {
+				entry = &candidate;
+			}
+		}
+	}
+
+	entry->query[0] = query[0];
+	entry->query[1] = query[1];
+	memcpy(entry->payload, payload, size);
+	entry->size = size;
+	entry->timestampMs = time_now_ms();
+}
+
+Result DaikinS21::queryCycle(const char *const *queries, uint8_t count) {
+	if (!queries) {
 		return kInvalidParameters;
 	}
+	if (!connected_) {
+		return kInvalidNotConnected;
+	}
 
-	Result ret = sendFrame(frame, frameLen);
-	if (ret != kSuccess) {
-		return ret;
+	Result result = kSuccess;
+	bool ackPending = false;
+	uint8_t payload[kMaxFrameSize];
+	for (uint8_t i = 0; i < count; i++) {
+		const uint8_t *query = reinterpret_cast<const uint8_t *>(queries[i]);
+		CLIMATE_TRACE_SPAN("query", static_cast<uint16_t>((query[0] << 8) | query[1]));
+		Result ret = sendFrame(query, 2, ackPending);
+		ackPending = false;
+		if (ret != kSuccess) {
+			return ret;
+		}
+
+		ret = waitForAck();
+		uint16_t payloadLen = sizeof(payload);
+		if (ret == kSuccess) {
+			ret = readFrame(payload, &payloadLen);
+		}
+		if (ret != kSuccess) {
+			CLIMATE_LOG_WARNING("Daikin: Query %c%c failed (%d)", queries[i][0], queries[i][1], ret);
+			result = ret;
+			continue;
+		}
+
+		ackPending = true;
+		if (payloadLen <= kMaxPayloadSize) {
+			storeResponse(queries[i], payload, static_cast<uint8_t>(payloadLen));
+			applyResponse(payload, static_cast<uint8_t>(payloadLen));
+		}
 	}
 
-	ret = waitForAck();
-	if (ret != kSuccess) {
-		return ret;
+	if (ackPending) {
+		uint8_t ack = kS21Ack;
+		Result ret = uart_.write(&ack, 1);
+		if (ret != kSuccess) {
+			return ret;
+		}
 	}
 
-	ret = readFrame(payload, payloadLen);
-	if (ret != kSuccess) {
-		return ret;
+	return result;
+}
+
+Result DaikinS21::cachedResponse(const char *query, uint32_t maxAgeMs, uint8_t *payload, uint8_t *payloadLen) const {
+	if (!query || !payload || !payloadLen) {
+		return kInvalidParameters;
 	}
 
-	uint8_t ack = kS21Ack;
-	ret = uart_.write(&ack, 1);
-	if (ret != kSuccess) {
-		return ret;
+	const CachedResponse *entry = findCached(query);
+	if (!entry || time_elapsed_ms(entry->timestampMs) > maxAgeMs) {
+		return kTimeout;
+	}
+	if (*payloadLen < entry->size) {
+		return kInvalidParameters;
 	}
 
+	memcpy(payload, entry->payload, entry->size);
+	*payloadLen = entry->size;
 	return kSuccess;
 }
 
+void DaikinS21::setCacheMaxAge(uint32_t maxAgeMs) {
+	cacheMaxAgeMs_ = maxAgeMs;
+}
+
+void DaikinS21::applyResponse(const uint8_t *payload, uint8_t size) {
+	if (size < 3) {
+		return;
+	}
+
+	if (payload[0] == 'G' && payload[1] == '1' && size >= 6) {
+		constexpr ClimateFieldMask kF1Fields = fieldMask(ClimateField::Action) | fieldMask(ClimateField::Mode) |
+											   fieldMask(ClimateField::Temperature) | fieldMask(ClimateField::FanSpeed);
+		ClimateSettings settings;
+		settings.action = (payload[2] == '1') ? HeatpumpAction::On : HeatpumpAction::Off;
+		settings.mode = byteToMode(payload[3]);
+		settings.temperature = static_cast<int>(((payload[4] - kSetpointOffset) * kSetpointStep) / 10);
+		settings.fanSpeed = byteToFan(payload[5]);
+		if (settings.action != HeatpumpAction::On) {
+			settings.mode = HeatpumpMode::None;
+		}
+		notifyState(settings, kF1Fields);
+	} else if (payload[0] == 'G' && payload[1] == '5') {
+		ClimateSettings settings;
+		bool swingV = (payload[2] & 1) != 0;
+		bool swingH = (payload[2] & 2) != 0;
+		settings.vaneMode = (swingV || swingH) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+		notifyState(settings, fieldMask(ClimateField::VaneMode));
+	} else if (payload[0] == 'S' && payload[1] == 'H') {
+		char digits[kMaxPayloadSize + 1];
+		memcpy(digits, &payload[2], size - 2);
+		digits[size - 2] = '\0';
+		notifyRoomTemperature(static_cast<float>(atoi(digits)) / 10.0f);
+	}
+}
+
 Result DaikinS21::sendCmd(const uint8_t *frame, uint16_t frameLen) {
 	if (!frame) {
 		return kInvalidParameters;
 	}
 
+	CLIMATE_TRACE_SPAN("command", static_cast<uint16_t>((frame[0] << 8) | frame[1]));
 	Result ret = sendFrame(frame, frameLen);
 	if (ret != kSuccess) {
 		return ret;
@@ -261,6 +402,14 @@ Result DaikinS21::setSwingSettings(bool swingV, bool swingH) {
 	return sendCmd(command, sizeof(command));
 }
 
+void DaikinS21::writeSnapshot(SnapshotWriter &writer) const {
+	writer.putU8(kSnapshotTag);
+}
+
+Result DaikinS21::readSnapshot(SnapshotReader &reader) {
+	return (reader.getU8() == kSnapshotTag && reader.ok()) ? kSuccess : kInvalidData;
+}
+
 Result DaikinS21::init() {
 	Result ret = uart_.open(2400, transport::UartParity::Even, 2);
 	if (ret != kSuccess) {
@@ -268,10 +417,14 @@ Result DaikinS21::init() {
 	}
 
 	connected_ = true;
+	f5Supported_ = true;
+
+	setReady(true);
 	return kSuccess;
 }
 
 Result DaikinS21::setState(const ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::SetState);
 	if (!connected_) {
 		return kInvalidNotConnected;
 	}
@@ -292,6 +445,11 @@ Result DaikinS21::setState(const ClimateSettings &settings) {
 	command[4] = static_cast<uint8_t>((c10 + 3) / kSetpointStep + kSetpointOffset);
 	command[5] = fanToByte(settings.fanSpeed);
 
+	// Cached F1/F5 replies no longer describe the unit
+	for (CachedResponse &entry : cache_) {
+		entry.size = 0;
+	}
+
 	Result ret = sendCmd(command, sizeof(command));
 	if (ret != kSuccess) {
 		return ret;
@@ -306,76 +464,103 @@ Result DaikinS21::setState(const ClimateSettings &settings) {
 	return kSuccess;
 }
 
-Result DaikinS21::getState(ClimateSettings &settings) {
+void DaikinS21::reportFixedVane() {
+	ClimateSettings settings;
+	settings.vaneMode = HeatpumpVaneMode::Auto;
+	notifyState(settings, fieldMask(ClimateField::VaneMode));
+}
+
+Result DaikinS21::refresh(ClimateFieldMask fields) {
+	TimedOperation timed(*this, MetricOperation::Refresh);
 	if (!connected_) {
 		return kInvalidNotConnected;
 	}
 
-	settings = ClimateSettings{};
-	settings.action = HeatpumpAction::Off;
-	settings.mode = HeatpumpMode::None;
-	settings.fanSpeed = HeatpumpFanSpeed::Auto;
-	settings.vaneMode = HeatpumpVaneMode::Auto;
-	settings.temperature = kMinTemperature;
-
-	uint8_t payload[kMaxFrameSize];
-	uint16_t payloadLen = kMaxFrameSize;
+	constexpr ClimateFieldMask kF1Fields = fieldMask(ClimateField::Action) | fieldMask(ClimateField::Mode) |
+										   fieldMask(ClimateField::Temperature) | fieldMask(ClimateField::FanSpeed);
 
-	Result ret = query(kQueryF1, sizeof(kQueryF1), payload, &payloadLen);
-	if (ret != kSuccess) {
-		CLIMATE_LOG_ERROR("Daikin: Failed to query basic state (%d)", ret);
-		return ret;
+	// F1 carries power, mode, setpoint and fan in one reply: refresh all of them whenever one is due.
+	const char *queries[3];
+	uint8_t count = 0;
+	if (fields & kF1Fields) {
+		queries[count++] = kQueryF1;
 	}
-
-	if (payload[0] != 'G' || payload[1] != '1') {
-		return kInvalidData;
+	if (fields & fieldMask(ClimateField::VaneMode)) {
+		if (f5Supported_) {
+			queries[count++] = kQueryF5;
+		} else {
+			reportFixedVane();
+		}
+	}
+	if (fields & fieldMask(ClimateField::RoomTemperature)) {
+		queries[count++] = kQueryRh;
 	}
 
-	settings.action = (payload[2] == '1') ? HeatpumpAction::On : HeatpumpAction::Off;
-	settings.mode = byteToMode(payload[3]);
-	settings.temperature = static_cast<int>(((payload[4] - kSetpointOffset) * kSetpointStep) / 10);
-	settings.fanSpeed = byteToFan(payload[5]);
-	if (settings.action != HeatpumpAction::On) {
-		settings.mode = HeatpumpMode::None;
+	// Replies from a recent cycle are already in the field cache
+	uint8_t pending = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		const CachedResponse *entry = findCached(queries[i]);
+		if (!entry || time_elapsed_ms(entry->timestampMs) > cacheMaxAgeMs_) {
+			queries[pending++] = queries[i];
+		}
 	}
 
-	payloadLen = kMaxFrameSize;
-	ret = query(kQueryF5, sizeof(kQueryF5), payload, &payloadLen);
-	if (ret == kSuccess && payload[0] == 'G' && payload[1] == '5') {
-		bool swingV = (payload[2] & 1) != 0;
-		bool swingH = (payload[2] & 2) != 0;
-		settings.vaneMode = (swingV || swingH) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+	if (pending == 0) {
+		return kSuccess;
 	}
 
-	connected_ = true;
-	return kSuccess;
-}
+	uint32_t cycleStart = time_now_ms();
+	queryCycle(queries, pending);
 
-Result DaikinS21::getRoomTemperature(float &temperature) {
-	if (!connected_) {
-		return kInvalidNotConnected;
+	Result ret = kSuccess;
+	for (uint8_t i = 0; i < pending; i++) {
+		const CachedResponse *entry = findCached(queries[i]);
+		bool answered = entry && (entry->timestampMs - cycleStart) < 0x80000000u;
+		if (answered) {
+			continue;
+		}
+
+		if (queries[i] == kQueryF5) {
+			// Swing state is optional on some units: stop asking, and report the vanes as
+			// fixed so the state still gets published.
+			CLIMATE_LOG_WARNING("Daikin: No swing state, assuming fixed vanes");
+			f5Supported_ = false;
+			reportFixedVane();
+		} else {
+			CLIMATE_LOG_ERROR("Daikin: Failed to query %s", queries[i]);
+			ret = kTimeout;
+		}
 	}
 
-	uint8_t payload[kMaxFrameSize];
-	uint16_t payloadLen = kMaxFrameSize;
+	return ret;
+}
 
-	Result ret = query(kQueryRh, sizeof(kQueryRh), payload, &payloadLen);
+Result DaikinS21::getState(ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::GetState);
+	settings = ClimateSettings{};
+	settings.action = HeatpumpAction::Off;
+	settings.mode = HeatpumpMode::None;
+	settings.fanSpeed = HeatpumpFanSpeed::Auto;
+	settings.vaneMode = HeatpumpVaneMode::Auto;
+	settings.temperature = kMinTemperature;
+
+	Result ret = refresh(kSettingsFields);
 	if (ret != kSuccess) {
-		CLIMATE_LOG_WARNING("Daikin: Failed to query room temp (%d)", ret);
 		return ret;
 	}
 
-	if (payloadLen < 3 || payload[0] != 'S' || payload[1] != 'H') {
-		return kInvalidData;
-	}
+	cachedState(settings);
+	return kSuccess;
+}
 
-	if (payloadLen < kMaxFrameSize) {
-		payload[payloadLen] = 0;
-	} else {
-		payload[kMaxFrameSize - 1] = 0;
+Result DaikinS21::getRoomTemperature(float &temperature) {
+	TimedOperation timed(*this, MetricOperation::GetRoomTemperature);
+	Result ret = refresh(fieldMask(ClimateField::RoomTemperature));
+	if (ret != kSuccess) {
+		return ret;
 	}
 
-	temperature = static_cast<float>(atoi(reinterpret_cast<char *>(&payload[2]))) / 10.0f;
+	cachedRoomTemperature(temperature);
 	return kSuccess;
 }
 
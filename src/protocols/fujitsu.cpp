@@ -14,8 +14,13 @@ namespace protocols {
 namespace {
 constexpr uint32_t kBaudRate = 500;
 constexpr uint32_t kFrameSize = 8;
-constexpr uint32_t kReadTimeoutMs = 1000;
 constexpr uint32_t kFrameGapMs = 50;
+constexpr uint32_t kCharTimeMs = (transport::bitsPerChar(transport::UartParity::Even, 1) * 1000 + kBaudRate - 1) / kBaudRate;
+// Bytes of one frame follow each other back to back; a silence of two character times can
+// only be a frame boundary.
+constexpr uint32_t kInterFrameSilenceMs = 2 * kCharTimeMs;
+constexpr uint32_t kEchoTimeoutMs = kFrameSize * kCharTimeMs + kFrameGapMs;
+constexpr uint32_t kLoginTimeoutMs = 10000;
 
 // Byte 3: mode/fan/enabled/error
 constexpr uint8_t kModeIndex     = 3;
@@ -78,6 +83,8 @@ constexpr uint8_t kFujiFanQuiet  = 1;
 constexpr uint8_t kFujiFanLow    = 2;
 constexpr uint8_t kFujiFanMedium = 3;
 constexpr uint8_t kFujiFanHigh   = 4;
+
+constexpr uint8_t kSnapshotTag = 'F';
 }  // namespace
 
 Fujitsu::Fujitsu(transport::UartTransport &uart, bool secondary)
@@ -129,6 +136,16 @@ HeatpumpFanSpeed Fujitsu::byteToFan(uint8_t val) {
     }
 }
 
+ClimateSettings Fujitsu::frameToSettings(const Frame &frame) {
+    ClimateSettings settings;
+    settings.action = (frame.onOff == 1) ? HeatpumpAction::On : HeatpumpAction::Off;
+    settings.temperature = static_cast<int>(frame.temperature);
+    settings.mode = byteToMode(frame.mode);
+    settings.fanSpeed = byteToFan(frame.fanMode);
+    settings.vaneMode = (frame.swingMode != 0) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+    return settings;
+}
+
 // --- Frame encode / decode ---
 
 Fujitsu::Frame Fujitsu::decodeFrame(const uint8_t *buf) {
@@ -182,70 +199,57 @@ void Fujitsu::encodeFrame(const Frame &f, uint8_t *buf) {
 
 // --- UART read / write ---
 
-Result Fujitsu::readFrame(Frame &frame) {
-    uint8_t buf[kFrameSize];
-    size_t totalRead = 0;
-
-    uint32_t start = time_now_ms();
-    while (totalRead < kFrameSize) {
-        if (time_elapsed_ms(start) > kReadTimeoutMs) {
-            CLIMATE_LOG_DEBUG("Fujitsu: readFrame timeout");
-            return kTimeout;
-        }
+void Fujitsu::queueFrame(const Frame &frame) {
+    encodeFrame(frame, txBuf_);
 
-        size_t chunkSize = 1;
-        Result ret = uart_.read(&buf[totalRead], &chunkSize);
-        if (ret == kSuccess && chunkSize == 1) {
-            totalRead++;
-        }
-    }
+    CLIMATE_LOG_DEBUG("Fujitsu TX:");
+    CLIMATE_LOG_BUFFER(txBuf_, kFrameSize);
 
-    // XOR decode (Fujitsu protocol inverts all bytes on the wire)
+    // XOR encode
     for (size_t i = 0; i < kFrameSize; i++) {
-        buf[i] ^= 0xFF;
+        txBuf_[i] ^= 0xFF;
     }
 
-    CLIMATE_LOG_DEBUG("Fujitsu RX:");
-    CLIMATE_LOG_BUFFER(buf, kFrameSize);
-
-    frame = decodeFrame(buf);
-    return kSuccess;
+    txPending_ = true;
 }
 
-Result Fujitsu::writeFrame(const Frame &frame) {
-    uint8_t buf[kFrameSize];
-    encodeFrame(frame, buf);
-
-    CLIMATE_LOG_DEBUG("Fujitsu TX:");
-    CLIMATE_LOG_BUFFER(buf, kFrameSize);
-
-    // XOR encode
-    for (size_t i = 0; i < kFrameSize; i++) {
-        buf[i] ^= 0xFF;
+Result Fujitsu::sendPendingFrame() {
+    // Reply only once the bus has been quiet for a frame gap after the unit's frame
+    if (!txPending_ || time_elapsed_ms(lastFrameMs_) < kFrameGapMs) {
+        return kSuccess;
     }
 
-    Result ret = uart_.write(buf, kFrameSize);
+    txPending_ = false;
+    Result ret = uart_.write(txBuf_, kFrameSize);
     if (ret != kSuccess) {
         CLIMATE_LOG_ERROR("Fujitsu: writeFrame failed: %d", ret);
         return ret;
     }
+    countMetric(MetricCounter::FramesSent);
 
-    // Read back our own frame (half-duplex bus)
-    uint8_t echo[kFrameSize];
-    size_t echoRead = 0;
-    uint32_t start = time_now_ms();
-    while (echoRead < kFrameSize) {
-        if (time_elapsed_ms(start) > kReadTimeoutMs) {
-            break;
-        }
-        size_t chunkSize = 1;
-        uart_.read(&echo[echoRead], &chunkSize);
-        if (chunkSize == 1) {
-            echoRead++;
-        }
+    // Half-duplex bus: our own frame comes back and is checked by the receive path,
+    // the turn itself is over.
+    echoCount_ = kFrameSize;
+    txSentMs_ = time_now_ms();
+    return kSuccess;
+}
+
+void Fujitsu::receiveEcho(uint8_t byte) {
+    uint8_t expected = txBuf_[kFrameSize - echoCount_];
+    if (byte == expected) {
+        echoCount_--;
+        return;
     }
 
-    return kSuccess;
+    // Another controller (or noise) talked over our frame: the unit did not get it.
+    CLIMATE_LOG_WARNING("Fujitsu: Bus collision, echo 0x%02X != sent 0x%02X", byte, expected);
+    echoCount_ = 0;
+    rxCount_ = 0;
+    if (txHadUpdate_) {
+        // Settings are resent on our next turn unless a newer setState() replaced them
+        hasPendingUpdate_ = true;
+        countMetric(MetricCounter::Retries);
+    }
 }
 
 // --- Protocol state machine ---
@@ -260,6 +264,7 @@ Result Fujitsu::processStatusFrame(Frame &rx, Frame &tx) {
     if (rx.controllerPresent == 1) {
         // We are logged in - normal operation
         loggedIn_ = true;
+        setReady(true);
 
         if (seenSecondary_) {
             tx.dest = static_cast<uint8_t>(Address::Secondary);
@@ -273,6 +278,7 @@ Result Fujitsu::processStatusFrame(Frame &rx, Frame &tx) {
         tx.updateMagic = 0;
 
         // Apply pending settings if any
+        txHadUpdate_ = hasPendingUpdate_;
         if (hasPendingUpdate_) {
             tx.writeBit = true;
             tx.onOff = (pendingUpdate_.action == HeatpumpAction::On) ? 1 : 0;
@@ -336,28 +342,43 @@ Result Fujitsu::processLoginFrame(Frame &rx, Frame &tx) {
     return kSuccess;
 }
 
-Result Fujitsu::poll() {
-    Frame rx;
-    Result ret = readFrame(rx);
-    if (ret != kSuccess) {
-        return ret;
+Result Fujitsu::processFrame(const uint8_t *buf) {
+    uint8_t decoded[kFrameSize];
+    // XOR decode (Fujitsu protocol inverts all bytes on the wire)
+    for (size_t i = 0; i < kFrameSize; i++) {
+        decoded[i] = buf[i] ^ 0xFF;
     }
 
+    CLIMATE_LOG_DEBUG("Fujitsu RX:");
+    CLIMATE_LOG_BUFFER(decoded, kFrameSize);
+
+    Frame rx = decodeFrame(decoded);
+
     // Only process frames addressed to us
     if (rx.dest != controllerAddress_) {
         // If the frame is going to the secondary, note it exists and grab its temp
         if (rx.dest == static_cast<uint8_t>(Address::Secondary)) {
             seenSecondary_ = true;
             currentState_.controllerTemp = rx.controllerTemp;
+            if (loggedIn_) {
+                notifyRoomTemperature(static_cast<float>(currentState_.controllerTemp));
+            }
         }
         return kSuccess;
     }
 
     lastFrameMs_ = time_now_ms();
+    // Our turn on the bus; the reply shows up as a write one frame gap later. Not a span:
+    // it ends in a later service() call, outside whatever call it started in.
+    CLIMATE_TRACE_INSTANT("our turn", rx.type);
 
     Frame tx{};
     if (rx.type == static_cast<uint8_t>(MessageType::Status)) {
         processStatusFrame(rx, tx);
+        if (loggedIn_) {
+            notifyState(frameToSettings(currentState_));
+            notifyRoomTemperature(static_cast<float>(currentState_.controllerTemp));
+        }
     } else if (rx.type == static_cast<uint8_t>(MessageType::Login)) {
         processLoginFrame(rx, tx);
     } else if (rx.type == static_cast<uint8_t>(MessageType::Error)) {
@@ -368,12 +389,57 @@ Result Fujitsu::poll() {
         return kInvalidData;
     }
 
-    // Wait for frame gap before replying
-    while (time_elapsed_ms(lastFrameMs_) < kFrameGapMs) {
-        // busy wait
+    queueFrame(tx);
+    return kSuccess;
+}
+
+Result Fujitsu::waitForLogin() {
+    uint32_t start = time_now_ms();
+    while (!loggedIn_ && time_elapsed_ms(start) < kLoginTimeoutMs) {
+        Result ret = service();
+        if (ret != kSuccess && ret != kInvalidData) {
+            return ret;
+        }
+    }
+
+    if (!loggedIn_) {
+        countMetric(MetricCounter::Timeouts);
+        return kInvalidNotConnected;
+    }
+    return kSuccess;
+}
+
+// --- Warm start snapshot ---
+
+void Fujitsu::writeSnapshot(SnapshotWriter &writer) const {
+    uint8_t buf[kFrameSize];
+    encodeFrame(currentState_, buf);
+
+    writer.putU8(kSnapshotTag);
+    writer.putU8(static_cast<uint8_t>((loggedIn_ ? 0x01 : 0x00) | (seenSecondary_ ? 0x02 : 0x00) |
+                                      (secondary_ ? 0x04 : 0x00)));
+    writer.putBytes(buf, kFrameSize);
+}
+
+Result Fujitsu::readSnapshot(SnapshotReader &reader) {
+    uint8_t buf[kFrameSize];
+    uint8_t tag = reader.getU8();
+    uint8_t flags = reader.getU8();
+    reader.getBytes(buf, kFrameSize);
+    if (!reader.ok() || tag != kSnapshotTag) {
+        return kInvalidData;
+    }
+
+    // A snapshot taken as primary does not describe a secondary controller (and vice versa).
+    if (((flags & 0x04) != 0) != secondary_) {
+        return kInvalidData;
     }
 
-    return writeFrame(tx);
+    currentState_ = decodeFrame(buf);
+    loggedIn_ = (flags & 0x01) != 0;
+    seenSecondary_ = (flags & 0x02) != 0;
+    warmStart_ = loggedIn_;
+    return kSuccess;
 }
 
 // --- ClimateInterface implementation ---
@@ -392,64 +458,111 @@ Result Fujitsu::init() {
     CLIMATE_LOG_INFO("Fujitsu: init as %s controller (addr=%u)",
                      secondary_ ? "secondary" : "primary", controllerAddress_);
 
-    // Poll a few times to establish connection with the indoor unit
-    for (int i = 0; i < 10; i++) {
-        poll();
+    rxCount_ = 0;
+    echoCount_ = 0;
+    txPending_ = false;
+    txHadUpdate_ = false;
+    opened_ = true;
+    if (warmStart_) {
+        // Session state restored from a snapshot: the next bus turn answers with it directly.
+        warmStart_ = false;
+        setReady(loggedIn_);
+        CLIMATE_LOG_INFO("Fujitsu: warm start");
     }
 
+    // Login with the indoor unit happens on the next bus turns, driven by service()
+    // or by the first public call.
     return kSuccess;
 }
 
-Result Fujitsu::setState(const ClimateSettings &settings) {
-    pendingUpdate_ = settings;
-    hasPendingUpdate_ = true;
+Result Fujitsu::service() {
+    if (!opened_) {
+        return kSuccess;
+    }
 
-    // Poll until the update is applied
-    for (int attempt = 0; attempt < 20 && hasPendingUpdate_; attempt++) {
-        Result ret = poll();
-        if (ret != kSuccess && ret != kTimeout) {
-            return ret;
+    // Bus engine: consume what arrived, answer frames addressed to us once the frame gap
+    // has elapsed. Must be called more often than the gap (50 ms) to never miss a turn.
+    Result ret = kSuccess;
+    if (uart_.available() == 0) {
+        // Frame alignment comes from the silence between frames: a partial frame followed
+        // by an observed gap lost bytes and must not shift every later frame.
+        uint32_t silenceMs = time_elapsed_ms(rxLastByteMs_);
+        if (rxCount_ > 0 && silenceMs >= kInterFrameSilenceMs) {
+            CLIMATE_LOG_WARNING("Fujitsu: Dropped partial frame (%u bytes)", rxCount_);
+            countMetric(MetricCounter::ResyncBytes, rxCount_);
+            rxCount_ = 0;
+        }
+        if (echoCount_ > 0 && time_elapsed_ms(txSentMs_) >= kEchoTimeoutMs) {
+            CLIMATE_LOG_WARNING("Fujitsu: Echo missing (%u bytes)", echoCount_);
+            countMetric(MetricCounter::Timeouts);
+            echoCount_ = 0;
         }
     }
 
-    return hasPendingUpdate_ ? kTimeout : kSuccess;
-}
+    while (uart_.available() > 0) {
+        uint8_t byte = 0;
+        size_t size = 1;
+        if (uart_.read(&byte, &size) != kSuccess || size != 1) {
+            break;
+        }
+        rxLastByteMs_ = time_now_ms();
 
-Result Fujitsu::getState(ClimateSettings &settings) {
-    // Poll to get fresh state
-    for (int attempt = 0; attempt < 10; attempt++) {
-        Result ret = poll();
-        if (ret != kSuccess && ret != kTimeout) {
-            return ret;
+        if (echoCount_ > 0) {
+            receiveEcho(byte);
+            continue;
+        }
+
+        if (rxCount_ == 0) {
+            CLIMATE_TRACE_INSTANT("first byte", 0);
+        }
+        rxBuf_[rxCount_++] = byte;
+        if (rxCount_ == kFrameSize) {
+            CLIMATE_TRACE_INSTANT("last byte", kFrameSize);
+            rxCount_ = 0;
+            countMetric(MetricCounter::FramesReceived);
+            ret = processFrame(rxBuf_);
         }
     }
 
+    Result txRet = sendPendingFrame();
+    return (txRet != kSuccess) ? txRet : ret;
+}
+
+Result Fujitsu::setState(const ClimateSettings &settings) {
+    TimedOperation timed(*this, MetricOperation::SetState);
+    // Queued: the bus engine writes it in our next status reply
+    pendingUpdate_ = settings;
+    hasPendingUpdate_ = true;
+
+    service();
+    return loggedIn_ ? kSuccess : waitForLogin();
+}
+
+Result Fujitsu::getState(ClimateSettings &settings) {
+    TimedOperation timed(*this, MetricOperation::GetState);
+    service();
     if (!loggedIn_) {
-        return kInvalidNotConnected;
+        Result ret = waitForLogin();
+        if (ret != kSuccess) {
+            return ret;
+        }
     }
 
-    settings.action = (currentState_.onOff == 1) ? HeatpumpAction::On : HeatpumpAction::Off;
-    settings.temperature = static_cast<int>(currentState_.temperature);
-    settings.mode = byteToMode(currentState_.mode);
-    settings.fanSpeed = byteToFan(currentState_.fanMode);
-    settings.vaneMode = (currentState_.swingMode != 0) ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+    settings = frameToSettings(currentState_);
 
     return kSuccess;
 }
 
 Result Fujitsu::getRoomTemperature(float &temperature) {
-    // Poll to get fresh state
-    for (int attempt = 0; attempt < 10; attempt++) {
-        Result ret = poll();
-        if (ret != kSuccess && ret != kTimeout) {
+    TimedOperation timed(*this, MetricOperation::GetRoomTemperature);
+    service();
+    if (!loggedIn_) {
+        Result ret = waitForLogin();
+        if (ret != kSuccess) {
             return ret;
         }
     }
 
-    if (!loggedIn_) {
-        return kInvalidNotConnected;
-    }
-
     temperature = static_cast<float>(currentState_.controllerTemp);
     return kSuccess;
 }
@@ -3,8 +3,6 @@
 #include "climate_uart/result.h"
 
 #include <string.h>
-#include <stdio.h>
-#include <stdlib.h>
 
 // H-Link protocol based on:
 // https://github.com/lumixen/esphome-hlink-ac/blob/main/components/hlink_ac/hlink_ac.cpp
@@ -18,7 +16,6 @@ namespace {
 constexpr uint32_t kHlinkBaudrate = 9600;
 constexpr uint32_t kReadTimeoutMs = 300;
 constexpr uint16_t kMsgBufferSize = 64;
-constexpr uint8_t kDataMaxLen = 8;
 
 constexpr uint16_t kFeaturePowerState = 0x0000;
 constexpr uint16_t kFeatureMode = 0x0001;
@@ -49,20 +46,12 @@ constexpr uint8_t kSwingBoth = 0x03;
 
 constexpr uint8_t kPowerOn = 0x01;
 constexpr uint8_t kPowerOff = 0x00;
+
+constexpr uint8_t kSnapshotTag = 'H';
 }  // namespace
 
 HitachiHLink::HitachiHLink(transport::UartTransport &uart) : uart_(uart) {}
 
-uint16_t HitachiHLink::crc(uint16_t address, const uint8_t *data, uint8_t dataLen) {
-	uint16_t sum = 0xFFFF;
-	sum -= (address >> 8) & 0xFF;
-	sum -= address & 0xFF;
-	for (uint8_t i = 0; i < dataLen; i++)
-		sum -= data[i];
-		
-	return sum;
-}
-
 uint16_t HitachiHLink::modeToWord(HeatpumpMode mode) {
 	switch (mode) {
 		case HeatpumpMode::Cold:
@@ -187,7 +176,11 @@ Result HitachiHLink::readLine(char *buffer, uint16_t bufferSize, uint32_t timeou
 		uint8_t byte = 0;
 		Result ret = readByte(&byte, timeoutMs);
 		if (ret == kSuccess) {
+			if (index == 0) {
+				CLIMATE_TRACE_INSTANT("first byte", 0);
+			}
 			if (byte == '\r') {
+				CLIMATE_TRACE_INSTANT("last byte", index + 1);
 				if (index < bufferSize) {
 					buffer[index] = '\0';
 					return kSuccess;
@@ -205,140 +198,169 @@ Result HitachiHLink::readLine(char *buffer, uint16_t bufferSize, uint32_t timeou
 	return kTimeout;
 }
 
-Result HitachiHLink::parseResponse(const char *line, Response &response) {
-	if (!line) {
-		return kInvalidParameters;
-	}
-
-	response.dataLen = 0;
-	if (strcmp(line, "OK") == 0) {
-		response.status = ResponseStatus::Ok;
-		return kSuccess;
-	}
-	if (strcmp(line, "NG") == 0) {
-		response.status = ResponseStatus::Ng;
-		return kSuccess;
-	}
-
-	char temp[kMsgBufferSize];
-	strncpy(temp, line, sizeof(temp));
-	temp[sizeof(temp) - 1] = '\0';
-
-	char *token1 = strtok(temp, " ");
-	char *token2 = strtok(nullptr, " ");
-	char *token3 = strtok(nullptr, " ");
-	if (!token1 || !token2 || !token3) {
-		return kInvalidData;
+Result HitachiHLink::readResponse(Response &response) {
+	char line[kMsgBufferSize];
+	Result ret = readLine(line, sizeof(line), kReadTimeoutMs);
+	if (ret != kSuccess) {
+		if (ret == kTimeout) {
+			countMetric(MetricCounter::Timeouts);
+		}
+		return ret;
 	}
 
-		//Do not strcmp, as there may be garbage before the "OK"/"NG" due to serial noise. Just check if "OK"/"NG" is contained in the first token.
-	if (strstr(token1, "OK")) {
-		response.status = ResponseStatus::Ok;
-	} else if (strstr(token1, "NG")) {
-		response.status = ResponseStatus::Ng;
+	CLIMATE_LOG_DEBUG("Hitachi H-Link Read: %s", line);
+	ret = hlink::parseResponse(line, response);
+	if (ret == kInvalidCrc) {
+		CLIMATE_LOG_WARNING("Hitachi H-Link: Invalid checksum");
+		countMetric(MetricCounter::CrcErrors);
+		countMetric(MetricCounter::CorruptBytes, static_cast<uint32_t>(strlen(line)) + 1);
+	} else if (ret != kSuccess) {
+		CLIMATE_LOG_ERROR("Hitachi H-Link: Invalid response");
+		CLIMATE_LOG_BUFFER(reinterpret_cast<const uint8_t *>(line), strlen(line));
 	} else {
-		CLIMATE_LOG_ERROR("Hitachi H-Link: Invalid response prefix: %s", token1);
-		CLIMATE_LOG_BUFFER(line, strlen(line));
-		response.status = ResponseStatus::Invalid;
-		return kInvalidData;
-	}
-
-	if (strncmp(token2, "P=", 2) != 0 || strncmp(token3, "C=", 2) != 0) {
-		return kInvalidData;
-	}
-
-	const char *pStr = token2 + 2;
-	const char *cStr = token3 + 2;
-	int pLen = static_cast<int>(strlen(pStr));
-	if ((pLen % 2) != 0) {
-		return kInvalidData;
-	}
-
-	response.dataLen = static_cast<uint8_t>(pLen / 2);
-	if (response.dataLen > sizeof(response.data)) {
-		return kInvalidData;
-	}
-
-	for (uint8_t i = 0; i < response.dataLen; i++) {
-		char byteStr[3] = {pStr[i * 2], pStr[i * 2 + 1], '\0'};
-		response.data[i] = static_cast<uint8_t>(strtoul(byteStr, nullptr, 16));
-	}
-
-	uint16_t receivedChecksum = static_cast<uint16_t>(strtoul(cStr, nullptr, 16));
-	uint16_t calculatedChecksum = crc(0, response.data, response.dataLen);
-	if (calculatedChecksum != receivedChecksum) {
-		CLIMATE_LOG_WARNING("Hitachi H-Link: Invalid checksum recv=0x%04X, calc=0x%04X", receivedChecksum,
-					 calculatedChecksum);
-		return kInvalidCrc;
+		countMetric(MetricCounter::FramesReceived);
+		if (response.status == hlink::Status::Ng) {
+			countMetric(MetricCounter::Naks);
+		}
 	}
-
-	return kSuccess;
+	return ret;
 }
 
 Result HitachiHLink::sendFrame(const char *type, uint16_t address, const uint8_t *data, uint8_t dataLen) {
-	if (!type) {
+	char message[hlink::kMaxFrameSize];
+	size_t size = hlink::encodeFrame(type, address, data, dataLen, message, sizeof(message));
+	if (size == 0) {
 		return kInvalidParameters;
 	}
 
-	char dataStr[kDataMaxLen * 2 + 1] = {0};
-	for (uint8_t i = 0; i < dataLen && i < kDataMaxLen; i++) {
-		snprintf(&dataStr[i * 2], 3, "%02X", data[i]);
-	}
-
-	uint16_t cs = crc(address, data, dataLen);
-	char message[kMsgBufferSize] = {0};
-	if (dataLen > 0) {
-		snprintf(message, sizeof(message), "%s P=%04X,%s C=%04X\r", type, address, dataStr, cs);
-	} else {
-		snprintf(message, sizeof(message), "%s P=%04X C=%04X\r", type, address, cs);
-	}
-
 	CLIMATE_LOG_DEBUG("Hitachi H-Link Send: %s", message);
-	return uart_.write(reinterpret_cast<const uint8_t *>(message), strlen(message));
+	Result ret = uart_.write(reinterpret_cast<const uint8_t *>(message), size);
+	if (ret == kSuccess) {
+		countMetric(MetricCounter::FramesSent);
+	}
+	return ret;
 }
 
 Result HitachiHLink::query(uint16_t address, Response &response) {
+	CLIMATE_TRACE_SPAN("query", address);
 	Result ret = sendFrame("MT", address, nullptr, 0);
 	if (ret != kSuccess) {
 		return ret;
 	}
 
-	char line[kMsgBufferSize] = {0};
-	ret = readLine(line, sizeof(line), kReadTimeoutMs);
+	ret = readResponse(response);
 	if (ret != kSuccess) {
-		CLIMATE_LOG_ERROR("Hitachi H-Link: Failed to read response line for address 0x%04X", address);
+		CLIMATE_LOG_ERROR("Hitachi H-Link: Failed to read response for address 0x%04X", address);
 		return ret;
 	}
 
-	CLIMATE_LOG_DEBUG("Hitachi H-Link Read: %s", line);
-	ret = parseResponse(line, response);
-	if (ret != kSuccess) {
-		return ret;
-	}
-
-	return (response.status == ResponseStatus::Ok) ? kSuccess : kInvalidReply;
+	return (response.status == hlink::Status::Ok) ? kSuccess : kInvalidReply;
 }
 
 Result HitachiHLink::command(uint16_t address, const uint8_t *data, uint8_t dataLen) {
+	CLIMATE_TRACE_SPAN("command", address);
 	Response response;
 	Result ret = sendFrame("ST", address, data, dataLen);
 	if (ret != kSuccess) {
 		return ret;
 	}
 
-	char line[kMsgBufferSize] = {0};
-	ret = readLine(line, sizeof(line), kReadTimeoutMs);
+	ret = readResponse(response);
 	if (ret != kSuccess) {
 		return ret;
 	}
 
-	CLIMATE_LOG_DEBUG("Hitachi H-Link Read: %s", line);
-	ret = parseResponse(line, response);
-	if (ret != kSuccess) {
-		return ret;
+	return (response.status == hlink::Status::Ok) ? kSuccess : kInvalidReply;
+}
+
+void HitachiHLink::drainLines() {
+	char line[kMsgBufferSize];
+	while (readLine(line, sizeof(line), kReadTimeoutMs) != kTimeout) {
+		CLIMATE_LOG_DEBUG("Hitachi H-Link: Dropped late reply: %s", line);
+	}
+}
+
+void HitachiHLink::setPipelineDepth(uint8_t depth) {
+	if (depth < 1) {
+		depth = 1;
+	} else if (depth > kMaxPipelineDepth) {
+		depth = kMaxPipelineDepth;
+	}
+	pipelineDepth_ = depth;
+}
+
+Result HitachiHLink::queryBatch(const uint16_t *addresses, uint8_t count, Response *responses, Result *results) {
+	if (!addresses || !responses || !results || count > kMaxBatchSize) {
+		return kInvalidParameters;
+	}
+	if (!connected_) {
+		return kInvalidNotConnected;
+	}
+	CLIMATE_TRACE_SPAN("batch", count);
+
+	// Replies carry no address: they are matched to requests by order only. Requests go out
+	// in windows, the next one once every reply of the current one is in: an adapter that
+	// drops a request then shows up as a timeout inside the window rather than as later
+	// replies shifted onto the wrong addresses.
+	uint8_t sent = 0;
+	uint8_t received = 0;
+	uint8_t windowStart = 0;
+	uint8_t windowSize = 0;
+	while (received < count) {
+		if (sent == received) {
+			windowStart = sent;
+			windowSize = 0;
+			while (sent < count && windowSize < pipelineDepth_) {
+				Result sendRet = sendFrame("MT", addresses[sent], nullptr, 0);
+				if (sendRet != kSuccess) {
+					for (uint8_t i = received; i < count; i++) {
+						results[i] = sendRet;
+					}
+					return sendRet;
+				}
+				sent++;
+				windowSize++;
+			}
+		}
+
+		Result result = readResponse(responses[received]);
+		if (result == kTimeout && windowSize > 1) {
+			// The adapter dropped a pipelined request: order can no longer be trusted, not even
+			// for the replies of this window already taken. Ask for the whole window again.
+			CLIMATE_LOG_WARNING("Hitachi H-Link: Pipelining not supported by the adapter, falling back to depth 1");
+			pipelineDepth_ = 1;
+			drainLines();
+			countMetric(MetricCounter::Retries, static_cast<uint32_t>(sent - windowStart));
+			sent = windowStart;
+			received = windowStart;
+			continue;
+		}
+
+		if (result == kSuccess && responses[received].status != hlink::Status::Ok) {
+			result = kInvalidReply;
+		}
+		if (result != kSuccess) {
+			CLIMATE_LOG_ERROR("Hitachi H-Link: Failed to read response for address 0x%04X", addresses[received]);
+		}
+		results[received++] = result;
 	}
 
-	return (response.status == ResponseStatus::Ok) ? kSuccess : kInvalidReply;
+	// Decided once every reply is final: a window asked again overwrites its earlier results
+	Result ret = kSuccess;
+	for (uint8_t i = 0; i < count; i++) {
+		if (results[i] != kSuccess) {
+			ret = results[i];
+		}
+	}
+	return ret;
+}
+
+void HitachiHLink::writeSnapshot(SnapshotWriter &writer) const {
+	writer.putU8(kSnapshotTag);
+}
+
+Result HitachiHLink::readSnapshot(SnapshotReader &reader) {
+	return (reader.getU8() == kSnapshotTag && reader.ok()) ? kSuccess : kInvalidData;
 }
 
 Result HitachiHLink::init() {
@@ -348,10 +370,13 @@ Result HitachiHLink::init() {
 	}
 
 	connected_ = true;
+
+	setReady(true);
 	return kSuccess;
 }
 
 Result HitachiHLink::setState(const ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::SetState);
 	if (!connected_) {
 		return kInvalidNotConnected;
 	}
@@ -393,50 +418,111 @@ Result HitachiHLink::setState(const ClimateSettings &settings) {
 	return kSuccess;
 }
 
-Result HitachiHLink::getState(ClimateSettings &settings) {
+Result HitachiHLink::refresh(ClimateFieldMask fields) {
+	TimedOperation timed(*this, MetricOperation::Refresh);
 	if (!connected_) {
 		return kInvalidNotConnected;
 	}
 
-	settings = ClimateSettings{};
+	struct FeatureQuery {
+		ClimateField field;
+		uint16_t address;
+	};
 
 	//Order is important
-
-	Response response;
-	Result ret = query(kFeaturePowerState, response);
-	if (ret != kSuccess || response.dataLen < 1) {
-		return kInvalidData;
+	constexpr FeatureQuery kFeatureQueries[] = {
+		{ClimateField::Action, kFeaturePowerState},
+		{ClimateField::Mode, kFeatureMode},
+		{ClimateField::Temperature, kFeatureTargetTemp},
+		{ClimateField::VaneMode, kFeatureSwingMode},
+		{ClimateField::FanSpeed, kFeatureFanMode},
+		{ClimateField::RoomTemperature, kFeatureCurrentIndoorTemp},
+	};
+
+	uint16_t addresses[kMaxBatchSize];
+	ClimateField batchFields[kMaxBatchSize];
+	uint8_t count = 0;
+	for (const FeatureQuery &feature : kFeatureQueries) {
+		if (fields & fieldMask(feature.field)) {
+			batchFields[count] = feature.field;
+			addresses[count++] = feature.address;
+		}
 	}
-	settings.action = (response.data[0] == kPowerOn) ? HeatpumpAction::On : HeatpumpAction::Off;
 
-	ret = query(kFeatureMode, response);
-	if (ret != kSuccess || response.dataLen < 2) {
-		return kInvalidData;
+	Response responses[kMaxBatchSize];
+	Result results[kMaxBatchSize];
+	Result batchRet = queryBatch(addresses, count, responses, results);
+	if (batchRet == kInvalidParameters || batchRet == kInvalidNotConnected) {
+		return batchRet;
 	}
-	uint16_t modeVal = static_cast<uint16_t>((response.data[0] << 8) | response.data[1]);
-	settings.mode = wordToMode(modeVal);
 
-	ret = query(kFeatureTargetTemp, response);
-	if (ret != kSuccess || response.dataLen < 1) {
-		return kInvalidData;
-	}
-	if (response.dataLen == 1) {
-		settings.temperature = response.data[0];
-	} else {
-		settings.temperature = static_cast<int>((response.data[0] << 8) | response.data[1]);
+	ClimateSettings settings;
+	ClimateFieldMask refreshed = 0;
+	Result ret = kSuccess;
+	for (uint8_t i = 0; i < count; i++) {
+		const Response &response = responses[i];
+		if (results[i] != kSuccess || response.dataLen < 1 ||
+			(batchFields[i] == ClimateField::Mode && response.dataLen < 2)) {
+			ret = kInvalidData;
+			continue;
+		}
+
+		switch (batchFields[i]) {
+			case ClimateField::Action:
+				settings.action = (response.data[0] == kPowerOn) ? HeatpumpAction::On : HeatpumpAction::Off;
+				break;
+			case ClimateField::Mode:
+				settings.mode = wordToMode(static_cast<uint16_t>((response.data[0] << 8) | response.data[1]));
+				break;
+			case ClimateField::Temperature:
+				if (response.dataLen == 1) {
+					settings.temperature = response.data[0];
+				} else {
+					settings.temperature = static_cast<int>((response.data[0] << 8) | response.data[1]);
+				}
+				break;
+			case ClimateField::VaneMode:
+				settings.vaneMode = byteToVane(response.data[0]);
+				break;
+			case ClimateField::FanSpeed:
+				settings.fanSpeed = byteToFan(response.data[0]);
+				break;
+			case ClimateField::RoomTemperature: {
+				float temperature;
+				if (response.dataLen == 1) {
+					temperature = static_cast<float>(response.data[0]);
+				} else {
+					int16_t temp = static_cast<int16_t>((response.data[0] << 8) | response.data[1]);
+					temperature = static_cast<float>(temp);
+				}
+				CLIMATE_LOG_DEBUG("Hitachi H-Link room temperature: %.1f°C", temperature);
+				notifyRoomTemperature(temperature);
+				break;
+			}
+			default:
+				break;
+		}
+		if (batchFields[i] != ClimateField::RoomTemperature) {
+			refreshed |= fieldMask(batchFields[i]);
+		}
 	}
 
-	ret = query(kFeatureSwingMode, response);
-	if (ret != kSuccess || response.dataLen < 1) {
-		return kInvalidData;
+	if (refreshed) {
+		notifyState(settings, refreshed);
 	}
-	settings.vaneMode = byteToVane(response.data[0]);
 
-	ret = query(kFeatureFanMode, response);
-	if (ret != kSuccess || response.dataLen < 1) {
-		return kInvalidData;
+	return ret;
+}
+
+Result HitachiHLink::getState(ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::GetState);
+	settings = ClimateSettings{};
+
+	Result ret = refresh(kSettingsFields);
+	if (ret != kSuccess) {
+		return ret;
 	}
-	settings.fanSpeed = byteToFan(response.data[0]);
+	cachedState(settings);
 
 	CLIMATE_LOG_DEBUG("Hitachi H-Link state: mode=%u, temp=%d, fan=%u, action=%u, vane=%u",
 					 static_cast<uint8_t>(settings.mode), settings.temperature,
@@ -447,23 +533,13 @@ Result HitachiHLink::getState(ClimateSettings &settings) {
 }
 
 Result HitachiHLink::getRoomTemperature(float &temperature) {
-	if (!connected_) {
-		return kInvalidNotConnected;
-	}
-
-	Response response;
-	Result ret = query(kFeatureCurrentIndoorTemp, response);
-	if (ret != kSuccess || response.dataLen < 1) {
-		return kInvalidData;
-	}
-	if (response.dataLen == 1) {
-		temperature = static_cast<float>(response.data[0]);
-	} else {
-		int16_t temp = static_cast<int16_t>((response.data[0] << 8) | response.data[1]);
-		temperature = static_cast<float>(temp);
+	TimedOperation timed(*this, MetricOperation::GetRoomTemperature);
+	Result ret = refresh(fieldMask(ClimateField::RoomTemperature));
+	if (ret != kSuccess) {
+		return ret;
 	}
 
-	CLIMATE_LOG_DEBUG("Hitachi H-Link room temperature: %.1f°C", temperature);
+	cachedRoomTemperature(temperature);
 	return kSuccess;
 }
 
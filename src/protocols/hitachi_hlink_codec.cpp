@@ -0,0 +1,168 @@
+#include "climate_uart/protocols/hitachi_hlink_codec.h"
+
+namespace climate_uart {
+namespace protocols {
+namespace hlink {
+
+namespace {
+constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+// Value of a hex digit, or -1
+inline int hexValue(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+inline char *putHex16(char *out, uint16_t value) {
+	out[0] = kHexDigits[(value >> 12) & 0x0F];
+	out[1] = kHexDigits[(value >> 8) & 0x0F];
+	out[2] = kHexDigits[(value >> 4) & 0x0F];
+	out[3] = kHexDigits[value & 0x0F];
+	return out + 4;
+}
+
+inline const char *skipSpaces(const char *p) {
+	while (*p == ' ') {
+		p++;
+	}
+	return p;
+}
+}  // namespace
+
+uint16_t checksum(uint16_t address, const uint8_t *data, uint8_t dataLen) {
+	uint16_t sum = 0xFFFF;
+	sum -= (address >> 8) & 0xFF;
+	sum -= address & 0xFF;
+	for (uint8_t i = 0; i < dataLen; i++) {
+		sum -= data[i];
+	}
+	return sum;
+}
+
+size_t encodeFrame(const char *type, uint16_t address, const uint8_t *data, uint8_t dataLen, char *buffer,
+				   size_t bufferSize) {
+	if (!type || !type[0] || !type[1] || !buffer || (dataLen > 0 && !data) || dataLen > kMaxRequestData) {
+		return 0;
+	}
+
+	size_t frameLen = 9 + (dataLen > 0 ? 1 + dataLen * 2u : 0) + 8;
+	if (bufferSize < frameLen + 1) {
+		return 0;
+	}
+
+	char *out = buffer;
+	*out++ = type[0];
+	*out++ = type[1];
+	*out++ = ' ';
+	*out++ = 'P';
+	*out++ = '=';
+	out = putHex16(out, address);
+	if (dataLen > 0) {
+		*out++ = ',';
+		for (uint8_t i = 0; i < dataLen; i++) {
+			*out++ = kHexDigits[data[i] >> 4];
+			*out++ = kHexDigits[data[i] & 0x0F];
+		}
+	}
+	*out++ = ' ';
+	*out++ = 'C';
+	*out++ = '=';
+	out = putHex16(out, checksum(address, data, dataLen));
+	*out++ = '\r';
+	*out = '\0';
+
+	return frameLen;
+}
+
+Result parseResponse(const char *line, Response &response) {
+	if (!line) {
+		return kInvalidParameters;
+	}
+
+	response.dataLen = 0;
+	response.status = Status::Invalid;
+
+	// First token: status, possibly preceded by serial noise
+	const char *p = skipSpaces(line);
+	const char *tokenStart = p;
+	Status status = Status::Invalid;
+	while (*p && *p != ' ') {
+		if (status == Status::Invalid && p != tokenStart) {
+			if (p[-1] == 'O' && p[0] == 'K') {
+				status = Status::Ok;
+			} else if (p[-1] == 'N' && p[0] == 'G') {
+				status = Status::Ng;
+			}
+		}
+		p++;
+	}
+
+	if (*skipSpaces(p) == '\0') {
+		// Bare "OK"/"NG" acknowledges a command; anything else without P=/C= is not a reply.
+		size_t tokenLen = static_cast<size_t>(p - tokenStart);
+		if (tokenLen == 2 && tokenStart == line && status != Status::Invalid) {
+			response.status = status;
+			return kSuccess;
+		}
+		return kInvalidData;
+	}
+
+	if (status == Status::Invalid) {
+		return kInvalidData;
+	}
+	response.status = status;
+
+	p = skipSpaces(p);
+	if (p[0] != 'P' || p[1] != '=') {
+		return kInvalidData;
+	}
+	p += 2;
+
+	// P= payload, decoded and summed as it is read
+	uint16_t sum = 0xFFFF;
+	while (*p && *p != ' ') {
+		int hi = hexValue(p[0]);
+		int lo = (hi >= 0) ? hexValue(p[1]) : -1;
+		if (lo < 0 || response.dataLen >= kMaxResponseData) {
+			return kInvalidData;
+		}
+		uint8_t byte = static_cast<uint8_t>((hi << 4) | lo);
+		response.data[response.dataLen++] = byte;
+		sum = static_cast<uint16_t>(sum - byte);
+		p += 2;
+	}
+
+	p = skipSpaces(p);
+	if (p[0] != 'C' || p[1] != '=') {
+		return kInvalidData;
+	}
+	p += 2;
+
+	uint16_t received = 0;
+	int digit = hexValue(*p);
+	if (digit < 0) {
+		return kInvalidData;
+	}
+	while (digit >= 0) {
+		received = static_cast<uint16_t>((received << 4) | digit);
+		digit = hexValue(*++p);
+	}
+
+	if (received != sum) {
+		return kInvalidCrc;
+	}
+
+	return kSuccess;
+}
+
+}  // namespace hlink
+}  // namespace protocols
+}  // namespace climate_uart
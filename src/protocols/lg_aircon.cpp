@@ -14,6 +14,10 @@ namespace protocols {
 namespace {
 constexpr uint8_t kMsgLen = 13;
 constexpr uint32_t kTimeoutMs = 500;
+// A frame takes 1.25 s at 104 baud: our own echo, then the unit's reply, then some slack
+constexpr uint32_t kStatusTimeoutMs = 3000;
+// The unit broadcasts every few seconds: a status this old means the bus went quiet
+constexpr uint32_t kStatusMaxAgeMs = 30000;
 
 constexpr uint8_t kMsgTypeStatusMaster = 0xA8;
 constexpr uint8_t kMsgTypeStatusUnit = 0xC8;
@@ -55,6 +59,11 @@ constexpr uint8_t kFanSpeedLg[] = {
 	kFanLow,
 	kFanQuiet
 };
+
+constexpr uint8_t kSnapshotTag = 'L';
+constexpr uint8_t kSnapshotConnected = 0x01;
+// lastRecvStatus_ holds a unit frame; before the first one it is all zeros
+constexpr uint8_t kSnapshotHasStatus = 0x02;
 }  // namespace
 
 LgAircon::LgAircon(transport::UartTransport &uart) : uart_(uart) {
@@ -69,6 +78,61 @@ uint8_t LgAircon::crc(const uint8_t *buffer, size_t size) {
 	return static_cast<uint8_t>((result & 0xFF) ^ 0x55);
 }
 
+void LgAircon::decodeStatus(const uint8_t *status, ClimateSettings &settings) {
+	settings.action = ((status[1] & kPowerOn) == 0) ? HeatpumpAction::Off : HeatpumpAction::On;
+
+	uint8_t modeVal = static_cast<uint8_t>((status[1] >> 2) & 0x07);
+	switch (modeVal) {
+		case kModeCool:
+			settings.mode = HeatpumpMode::Cold;
+			break;
+		case kModeDry:
+			settings.mode = HeatpumpMode::Dry;
+			break;
+		case kModeFan:
+			settings.mode = HeatpumpMode::Fan;
+			break;
+		case kModeAuto:
+			settings.mode = HeatpumpMode::Auto;
+			break;
+		case kModeHeat:
+			settings.mode = HeatpumpMode::Heat;
+			break;
+		default:
+			settings.mode = HeatpumpMode::Auto;
+			break;
+	}
+
+	uint8_t fanVal = static_cast<uint8_t>((status[1] >> 5) & 0x07);
+	switch (fanVal) {
+		case kFanLow:
+			settings.fanSpeed = HeatpumpFanSpeed::Low;
+			break;
+		case kFanMed:
+			settings.fanSpeed = HeatpumpFanSpeed::Med;
+			break;
+		case kFanHigh:
+			settings.fanSpeed = HeatpumpFanSpeed::High;
+			break;
+		case kFanQuiet:
+			settings.fanSpeed = HeatpumpFanSpeed::Quiet;
+			break;
+		case kFanAuto:
+		default:
+			settings.fanSpeed = HeatpumpFanSpeed::Auto;
+			break;
+	}
+
+	float target = static_cast<float>((status[6] & 0x0F) + 15);
+	if (status[5] & 0x01) {
+		target += 0.5f;
+	}
+	settings.temperature = static_cast<int>(target + 0.5f);
+
+	bool vertSwing = (status[2] & kSwingVertical) != 0;
+	settings.vaneMode = vertSwing ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
+}
+
 Result LgAircon::readByte(uint8_t *byte, uint32_t timeoutMs) {
 	if (!byte) {
 		return kInvalidParameters;
@@ -87,26 +151,64 @@ Result LgAircon::readByte(uint8_t *byte, uint32_t timeoutMs) {
 	return kTimeout;
 }
 
-Result LgAircon::readMsg(uint8_t *buffer, size_t bufferSize) {
+bool LgAircon::isFrame(const uint8_t *window) {
+	uint8_t type = static_cast<uint8_t>(window[0] & 0xF8);
+	if (type != kMsgTypeStatusMaster && type != kMsgTypeStatusUnit) {
+		return false;
+	}
+	return window[kMsgLen - 1] == crc(window, kMsgLen - 1);
+}
+
+bool LgAircon::pushByte(uint8_t byte, uint8_t *buffer) {
+	// A silence longer than a byte timeout ends whatever was in flight.
+	uint32_t now = time_now_ms();
+	if (rxCount_ > 0 && now - rxLastByteMs_ >= kTimeoutMs) {
+		rxCount_ = 0;
+	}
+	rxLastByteMs_ = now;
+	if (rxCount_ == 0) {
+		CLIMATE_TRACE_INSTANT("first byte", 0);
+	}
+
+	if (rxCount_ == kMsgLen) {
+		// Misaligned: slide the window by one byte rather than dropping a whole frame,
+		// which costs ~1.25 s on the wire at 104 baud.
+		CLIMATE_LOG_WARNING("LG: Resync, discarded byte: 0x%02X", rxWindow_[0]);
+		countMetric(MetricCounter::ResyncBytes);
+		memmove(rxWindow_, rxWindow_ + 1, kMsgLen - 1);
+		rxCount_--;
+	}
+	rxWindow_[rxCount_++] = byte;
+
+	if (rxCount_ < kMsgLen || !isFrame(rxWindow_)) {
+		return false;
+	}
+
+	memcpy(buffer, rxWindow_, kMsgLen);
+	rxCount_ = 0;
+	CLIMATE_TRACE_INSTANT("last byte", kMsgLen);
+	countMetric(MetricCounter::FramesReceived);
+	return true;
+}
+
+Result LgAircon::readMsg(uint8_t *buffer, size_t bufferSize, uint32_t timeoutMs) {
 	if (!buffer || bufferSize < kMsgLen) {
 		return kInvalidParameters;
 	}
 
-	for (size_t i = 0; i < bufferSize; i++) {
-		if (readByte(&buffer[i], kTimeoutMs) != kSuccess) {
+	// timeoutMs bounds the whole hunt: a line full of bytes that never line up into a
+	// frame ends the read as surely as a silent one.
+	uint32_t start = time_now_ms();
+	uint8_t byte = 0;
+	do {
+		uint32_t remaining = time_remaining_ms(start, timeoutMs);
+		if (remaining == 0 || readByte(&byte, remaining < kTimeoutMs ? remaining : kTimeoutMs) != kSuccess) {
 			return kTimeout;
 		}
-	}
+	} while (!pushByte(byte, buffer));
 
 	CLIMATE_LOG_DEBUG("LG Read:");
-	CLIMATE_LOG_BUFFER(buffer, bufferSize);
-
-	uint8_t expected = crc(buffer, bufferSize - 1);
-	if (buffer[12] != expected) {
-		CLIMATE_LOG_ERROR("LG: Invalid checksum rcv=0x%02X, calc=0x%02X", buffer[12], expected);
-		return kInvalidCrc;
-	}
-
+	CLIMATE_LOG_BUFFER(buffer, kMsgLen);
 	return kSuccess;
 }
 
@@ -118,73 +220,209 @@ Result LgAircon::writeMsg(uint8_t *buffer, size_t bufferSize) {
 	CLIMATE_LOG_DEBUG("LG Write:");
 	CLIMATE_LOG_BUFFER(buffer, bufferSize);
 
-	return uart_.write(buffer, bufferSize);
+	Result ret = uart_.write(buffer, bufferSize);
+	if (ret == kSuccess) {
+		countMetric(MetricCounter::FramesSent);
+	}
+	return ret;
 }
 
-Result LgAircon::readStatus(uint8_t *buffer, size_t bufferSize) {
-	uint32_t start = time_now_ms();
-	while (time_elapsed_ms(start) < 2000) {
-		Result ret = readMsg(buffer, bufferSize);
-		if (ret == kSuccess) {
-			uint8_t msgType = buffer[0];
-			if ((msgType & 0xF8) == kMsgTypeStatusUnit) {
-				switch (msgType & 0x07) {
-					case 0:
-						roomTemperature_ = static_cast<float>(buffer[7] & 0x3F) / 2.0f + 10.0f;
-						return kSuccess;
-					default:
-						break;
-				}
-			}
+bool LgAircon::processMsg(const uint8_t *msg) {
+	uint8_t msgType = msg[0];
+	if ((msgType & 0xF8) != kMsgTypeStatusUnit || (msgType & 0x07) != 0) {
+		// Our own echo on the bus, or a unit message we do not decode
+		return false;
+	}
+
+	memcpy(lastRecvStatus_, msg, kMsgLen);
+	roomTemperature_ = static_cast<float>(msg[7] & 0x3F) / 2.0f + 10.0f;
+	hasStatus_ = true;
+	lastStatusMs_ = time_now_ms();
+
+	ClimateSettings settings;
+	decodeStatus(msg, settings);
+	notifyState(settings);
+	notifyRoomTemperature(roomTemperature_);
+	return true;
+}
+
+bool LgAircon::pollBus() {
+	bool gotStatus = false;
+	uint8_t msg[kMsgLen];
+	while (uart_.available() > 0) {
+		uint8_t byte = 0;
+		size_t size = 1;
+		if (uart_.read(&byte, &size) != kSuccess || size != 1) {
+			break;
+		}
+		if (pushByte(byte, msg)) {
+			gotStatus |= processMsg(msg);
 		}
 	}
-	return kTimeout;
+	return gotStatus;
 }
 
-Result LgAircon::connect() {
-	uint8_t buffer[kMsgLen];
+Result LgAircon::readStatus() {
+	CLIMATE_TRACE_SPAN("status wait", 0);
+	uint8_t msg[kMsgLen];
+	uint32_t start = time_now_ms();
+	while (time_elapsed_ms(start) < kStatusTimeoutMs) {
+		if (readMsg(msg, kMsgLen, time_remaining_ms(start, kStatusTimeoutMs)) == kSuccess && processMsg(msg)) {
+			return kSuccess;
+		}
+	}
+	CLIMATE_LOG_ERROR("LG: No status from the unit, marking as disconnected...");
 	connected_ = false;
+	setReady(false);
+	countMetric(MetricCounter::Timeouts);
+	return kTimeout;
+}
 
-	memset(buffer, 0x00, sizeof(buffer));
-	buffer[0] = kMsgTypeStatusMaster;
-	buffer[1] = 0x00;
-	buffer[8] |= 0x40;
-	buffer[10] = 0x80;
-	buffer[12] = crc(buffer, kMsgLen);
+Result LgAircon::awaitFreshStatus() {
+	// Statuses buffered since the last call are newer than what we hold. Only block for
+	// the next broadcast when none was ever received or the last one has gone stale.
+	pollBus();
+	if (hasStatus_ && time_elapsed_ms(lastStatusMs_) < kStatusMaxAgeMs) {
+		return kSuccess;
+	}
+	return readStatus();
+}
 
-	Result ret = writeMsg(buffer, kMsgLen);
-	if (ret != kSuccess) {
-		return ret;
+Result LgAircon::connectStep() {
+	if (handshakeStep_ == 0) {
+		connected_ = false;
+		setReady(false);
+		beginHandshake();
+
+		uint8_t buffer[kMsgLen];
+		memset(buffer, 0x00, sizeof(buffer));
+		buffer[0] = kMsgTypeStatusMaster;
+		buffer[1] = 0x00;
+		buffer[8] |= 0x40;
+		buffer[10] = 0x80;
+		buffer[12] = crc(buffer, kMsgLen);
+
+		uint32_t stepStart = time_now_ms();
+		Result ret = writeMsg(buffer, kMsgLen);
+		recordHandshakeStep(stepStart);
+		if (ret != kSuccess) {
+			endHandshake(ret);
+			return ret;
+		}
+		handshakeStep_ = 1;
+		stepStartMs_ = time_now_ms();
+		return kInProgress;
 	}
 
-	ret = readStatus(lastRecvStatus_, kMsgLen);
-	if (ret == kSuccess) {
+	// Our frame takes 1.25 s on the wire, the unit's answer as long again: wait for it
+	// across service() calls rather than inside one.
+	if (pollBus()) {
+		recordHandshakeStep(stepStartMs_);
+		handshakeStep_ = 0;
 		connected_ = true;
+		setReady(true);
+		endHandshake(kSuccess);
+		return kSuccess;
 	}
 
-	return ret;
+	if (time_elapsed_ms(stepStartMs_) >= kStatusTimeoutMs) {
+		CLIMATE_LOG_ERROR("LG: No status from the unit");
+		recordHandshakeStep(stepStartMs_);
+		handshakeStep_ = 0;
+		countMetric(MetricCounter::Timeouts);
+		endHandshake(kTimeout);
+		return kTimeout;
+	}
+	return kInProgress;
+}
+
+void LgAircon::writeSnapshot(SnapshotWriter &writer) const {
+	bool hasStatus = isFrame(lastRecvStatus_);
+	writer.putU8(kSnapshotTag);
+	writer.putU8(static_cast<uint8_t>((connected_ ? kSnapshotConnected : 0) | (hasStatus ? kSnapshotHasStatus : 0)));
+	writer.putBytes(lastRecvStatus_, sizeof(lastRecvStatus_));
+	writer.putU8(static_cast<uint8_t>(roomTemperature_ * 2.0f));
+}
+
+Result LgAircon::readSnapshot(SnapshotReader &reader) {
+	uint8_t tag = reader.getU8();
+	uint8_t flags = reader.getU8();
+	uint8_t status[kMsgLen];
+	reader.getBytes(status, sizeof(status));
+	uint8_t roomTemperature = reader.getU8();
+	if (!reader.ok() || tag != kSnapshotTag) {
+		return kInvalidData;
+	}
+
+	// Saved before the first status: nothing to restore, the next init() starts cold
+	if (!(flags & kSnapshotHasStatus)) {
+		warmStart_ = false;
+		return kSuccess;
+	}
+
+	if (crc(status, kMsgLen - 1) != status[kMsgLen - 1]) {
+		return kInvalidCrc;
+	}
+
+	// With the last status bytes known, setState can merge into them right away
+	// instead of waiting up to a full status cycle at 104 baud.
+	memcpy(lastRecvStatus_, status, sizeof(lastRecvStatus_));
+	roomTemperature_ = static_cast<float>(roomTemperature) / 2.0f;
+	warmStart_ = (flags & kSnapshotConnected) != 0;
+	return kSuccess;
 }
 
 Result LgAircon::init() {
-	memset(lastRecvStatus_, 0x00, sizeof(lastRecvStatus_));
-	roomTemperature_ = 20.0f;
+	if (!warmStart_) {
+		memset(lastRecvStatus_, 0x00, sizeof(lastRecvStatus_));
+		roomTemperature_ = 20.0f;
+	}
+	hasStatus_ = false;
+	rxCount_ = 0;
+	handshakeStep_ = 0;
 
 	Result ret = uart_.open(104, transport::UartParity::None, 1);
 	if (ret != kSuccess) {
 		return ret;
 	}
 
-	return connect();
+	opened_ = true;
+	if (warmStart_) {
+		warmStart_ = false;
+		connected_ = true;
+		setReady(true);
+		CLIMATE_LOG_INFO("LG: warm start, skipping initial status cycle");
+	}
+
+	return kSuccess;
 }
 
-Result LgAircon::setState(const ClimateSettings &settings) {
+Result LgAircon::service() {
+	if (!opened_) {
+		return kSuccess;
+	}
+
 	if (!connected_) {
-		Result ret = connect();
-		if (ret != kSuccess) {
-			return ret;
-		}
+		return connectStep();
 	}
 
+	// The unit broadcasts its status periodically: ingest whatever arrived since the last
+	// call without blocking, so reads are answered from the freshest frame.
+	pollBus();
+	return kSuccess;
+}
+
+Result LgAircon::setState(const ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::SetState);
+	// The handshake spans several service() calls; a call made before it is done only
+	// advances it, so no call waits for two status cycles.
+	if (!connected_ && connectStep() != kSuccess) {
+		return kInvalidNotConnected;
+	}
+
+	// Merge into the freshest status bytes
+	pollBus();
+
 	uint8_t buffer[kMsgLen];
 	memset(buffer, 0x00, sizeof(buffer));
 	buffer[0] = kMsgTypeStatusMaster;
@@ -214,7 +452,7 @@ Result LgAircon::setState(const ClimateSettings &settings) {
 		return ret;
 	}
 
-	ret = readStatus(lastRecvStatus_, kMsgLen);
+	ret = readStatus();
 	if (ret != kSuccess) {
 		CLIMATE_LOG_WARNING("LG: No response after set_state");
 	}
@@ -223,88 +461,31 @@ Result LgAircon::setState(const ClimateSettings &settings) {
 }
 
 Result LgAircon::getState(ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::GetState);
 	settings = ClimateSettings{};
 
-	if (!connected_) {
-		Result ret = connect();
-		if (ret != kSuccess) {
-			return ret;
-		}
+	if (!connected_ && connectStep() != kSuccess) {
+		return kInvalidNotConnected;
 	}
 
-	Result ret = readStatus(lastRecvStatus_, kMsgLen);
+	Result ret = awaitFreshStatus();
 	if (ret != kSuccess) {
 		return ret;
 	}
 
-	uint8_t *status = lastRecvStatus_;
-
-	settings.action = ((status[1] & kPowerOn) == 0) ? HeatpumpAction::Off : HeatpumpAction::On;
-
-	uint8_t modeVal = static_cast<uint8_t>((status[1] >> 2) & 0x07);
-	switch (modeVal) {
-		case kModeCool:
-			settings.mode = HeatpumpMode::Cold;
-			break;
-		case kModeDry:
-			settings.mode = HeatpumpMode::Dry;
-			break;
-		case kModeFan:
-			settings.mode = HeatpumpMode::Fan;
-			break;
-		case kModeAuto:
-			settings.mode = HeatpumpMode::Auto;
-			break;
-		case kModeHeat:
-			settings.mode = HeatpumpMode::Heat;
-			break;
-		default:
-			settings.mode = HeatpumpMode::Auto;
-			break;
-	}
-
-	uint8_t fanVal = static_cast<uint8_t>((status[1] >> 5) & 0x07);
-	switch (fanVal) {
-		case kFanLow:
-			settings.fanSpeed = HeatpumpFanSpeed::Low;
-			break;
-		case kFanMed:
-			settings.fanSpeed = HeatpumpFanSpeed::Med;
-			break;
-		case kFanHigh:
-			settings.fanSpeed = HeatpumpFanSpeed::High;
-			break;
-		case kFanQuiet:
-			settings.fanSpeed = HeatpumpFanSpeed::Quiet;
-			break;
-		case kFanAuto:
-		default:
-			settings.fanSpeed = HeatpumpFanSpeed::Auto;
-			break;
-	}
-
-	float target = static_cast<float>((status[6] & 0x0F) + 15);
-	if (status[5] & 0x01) {
-		target += 0.5f;
-	}
-	settings.temperature = static_cast<int>(target + 0.5f);
-
-	bool vertSwing = (status[2] & kSwingVertical) != 0;
-	settings.vaneMode = vertSwing ? HeatpumpVaneMode::Swing : HeatpumpVaneMode::Auto;
-
-	while (readStatus(lastRecvStatus_, kMsgLen) == kSuccess) {
-		// flush pending status
-	}
-
+	decodeStatus(lastRecvStatus_, settings);
 	return kSuccess;
 }
 
 Result LgAircon::getRoomTemperature(float &temperature) {
-	if (!connected_) {
-		Result ret = connect();
-		if (ret != kSuccess) {
-			return ret;
-		}
+	TimedOperation timed(*this, MetricOperation::GetRoomTemperature);
+	if (!connected_ && connectStep() != kSuccess) {
+		return kInvalidNotConnected;
+	}
+
+	Result ret = awaitFreshStatus();
+	if (ret != kSuccess) {
+		return ret;
 	}
 
 	temperature = roomTemperature_;
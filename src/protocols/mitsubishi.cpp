@@ -14,6 +14,7 @@ namespace protocols {
 namespace {
 constexpr uint8_t kStx = 0xFC;
 constexpr uint32_t kTimeoutMs = 1000;
+constexpr uint32_t kHandshakeTimeoutMs = 2 * kTimeoutMs;
 constexpr uint8_t kProtoReply = 0x20;
 
 constexpr uint8_t kHeatpumpModeMitsubishi[] = {
@@ -43,6 +44,8 @@ constexpr uint8_t kVaneModeMitsubishi[] = {
 	0x05,  // 5
 	0x07   // Swing
 };
+
+constexpr uint8_t kSnapshotTag = 'M';
 }  // namespace
 
 Mitsubishi::Mitsubishi(transport::UartTransport &uart) : uart_(uart) {}
@@ -70,40 +73,58 @@ Result Mitsubishi::readByte(uint8_t *byte, uint32_t timeoutMs) {
 	}
 
 	CLIMATE_LOG_DEBUG("Mitsu: ReadByte Timeout (%u ms)", timeoutMs);
+	countMetric(MetricCounter::Timeouts);
 	return kTimeout;
 }
 
 Result Mitsubishi::readPacket(Packet &packet) {
+	// The whole packet must arrive within kTimeoutMs: a babbling or dripping line cannot
+	// hold the caller any longer than a silent one.
+	uint32_t start = time_now_ms();
+
 	packet.stx = 0x00;
 	while (packet.stx != kStx) {
-		if (readByte(&packet.stx, kTimeoutMs) == kTimeout) 
+		if (readByte(&packet.stx, time_remaining_ms(start, kTimeoutMs)) == kTimeout) 
 			return kTimeout;
-		if (packet.stx != kStx)
+		if (packet.stx != kStx) {
 			CLIMATE_LOG_WARNING("Mitsu: Discarded byte: 0x%02X", packet.stx);
+			countMetric(MetricCounter::ResyncBytes);
+		}
 	}
+	CLIMATE_TRACE_INSTANT("first byte", 0);
 
-	if (readByte(&packet.cmd, kTimeoutMs) != kSuccess)
+	if (readByte(&packet.cmd, time_remaining_ms(start, kTimeoutMs)) != kSuccess)
 		return kTimeout;
-	if (readByte(&packet.header[0], kTimeoutMs) != kSuccess)
+	if (readByte(&packet.header[0], time_remaining_ms(start, kTimeoutMs)) != kSuccess)
 		return kTimeout;
-	if (readByte(&packet.header[1], kTimeoutMs) != kSuccess)
+	if (readByte(&packet.header[1], time_remaining_ms(start, kTimeoutMs)) != kSuccess)
 		return kTimeout;
-	if (readByte(&packet.size, kTimeoutMs) != kSuccess) 
+	if (readByte(&packet.size, time_remaining_ms(start, kTimeoutMs)) != kSuccess) 
 		return kTimeout;
 
+	if (packet.size > sizeof(packet.data)) {
+		CLIMATE_LOG_ERROR("Mitsu: Invalid packet size %u", packet.size);
+		return kInvalidData;
+	}
+
 	for (int i = 0; i < packet.size; i++) {
-		if (readByte(&packet.data[i], kTimeoutMs) != kSuccess) {
+		if (readByte(&packet.data[i], time_remaining_ms(start, kTimeoutMs)) != kSuccess) {
 			return kTimeout;
 		}
 	}
 
-	if (readByte(&packet.checksum, kTimeoutMs) != kSuccess) {
+	if (readByte(&packet.checksum, time_remaining_ms(start, kTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
+	CLIMATE_TRACE_INSTANT("last byte", packet.size + 6);
 
 	uint8_t calculated = crc(reinterpret_cast<uint8_t *>(&packet), static_cast<uint8_t>(packet.size + 5));
 	if (calculated != packet.checksum) {
 		CLIMATE_LOG_ERROR("Mitsu: Invalid crc rcv=0x%02X, calc=0x%02X continue...", packet.checksum, calculated);
+		countMetric(MetricCounter::CrcErrors);
+		countMetric(MetricCounter::CorruptBytes, packet.size + 6u);
+	} else {
+		countMetric(MetricCounter::FramesReceived);
 	}
 
 	CLIMATE_LOG_DEBUG("Mitsu Read Packet: cmd=0x%02X, size=%u", packet.cmd, packet.size);
@@ -122,34 +143,106 @@ Result Mitsubishi::writePacket(const Packet &packet) {
 	Result ret = uart_.write(buffer, packet.size + 6);
 	if (ret != kSuccess) {
 		CLIMATE_LOG_ERROR("Mitsu: WritePacket failed: %d", ret);
+	} else {
+		countMetric(MetricCounter::FramesSent);
 	}
 	return ret;
 }
 
-Result Mitsubishi::connect() {
+Result Mitsubishi::connectStep() {
+	if (handshakeStep_ == 0) {
+		Packet packet{};
+		packet.cmd = 0x5A;
+		packet.size = 0x02;
+		packet.data[0] = 0xCA;
+		packet.data[1] = 0x01;
+
+		CLIMATE_LOG_DEBUG("Mitsubishi connecting ...");
+
+		connected_ = false;
+
+		setReady(false);
+		beginHandshake();
+		uint32_t stepStart = time_now_ms();
+		Result ret = writePacket(packet);
+		recordHandshakeStep(stepStart);
+		if (ret != kSuccess) {
+			endHandshake(ret);
+			return ret;
+		}
+		handshakeStep_ = 1;
+		stepStartMs_ = time_now_ms();
+		return kInProgress;
+	}
+
+	// Only read once the reply has started to arrive, so a silent unit costs each
+	// service() call nothing until the read timeout has passed.
+	Result ret = kInProgress;
 	Packet packet{};
-	packet.cmd = 0x5A;
-	packet.size = 0x02;
-	packet.data[0] = 0xCA;
-	packet.data[1] = 0x01;
-
-	CLIMATE_LOG_DEBUG("Mitsubishi connecting ...");
-
-	connected_ = false;
-	Result ret = writePacket(packet);
-	while (ret == kSuccess) {
-		ret = readPacket(packet);
-		if (ret == kSuccess) {
-			if (packet.cmd == static_cast<uint8_t>(0x5A | kProtoReply) || packet.cmd == 0x5A) {
-				CLIMATE_LOG_INFO("Mitsubishi connected !");
-				connected_ = true;
-				return kSuccess;
-			}
+	while (uart_.available() > 0 && handshakeElapsedMs() < kHandshakeTimeoutMs) {
+		// Stop on the first connect reply and skip unrelated packets. Garbage ends this call:
+		// the next one resumes the hunt.
+		Result readRet = readPacket(packet);
+		if (readRet == kTimeout) {
+			ret = kInvalidNotConnected;
+			break;
+		}
+		if (readRet != kSuccess) {
+			break;
+		}
+		if (packet.cmd == static_cast<uint8_t>(0x5A | kProtoReply) || packet.cmd == 0x5A) {
+			ret = kSuccess;
+			break;
 		}
 	}
 
-	CLIMATE_LOG_ERROR("Mitsubishi not connected");
-	return kInvalidNotConnected;
+	if (ret == kInProgress && (handshakeElapsedMs() >= kHandshakeTimeoutMs ||
+							   (uart_.available() == 0 && time_elapsed_ms(stepStartMs_) >= kTimeoutMs))) {
+		ret = kInvalidNotConnected;
+	}
+	if (ret == kInProgress) {
+		return kInProgress;
+	}
+
+	handshakeStep_ = 0;
+	recordHandshakeStep(stepStartMs_);
+	if (ret == kSuccess) {
+		CLIMATE_LOG_INFO("Mitsubishi connected !");
+		connected_ = true;
+		setReady(true);
+	} else {
+		CLIMATE_LOG_ERROR("Mitsubishi not connected");
+	}
+	endHandshake(ret);
+	return ret;
+}
+
+Result Mitsubishi::connect() {
+	handshakeStep_ = 0;
+
+	Result ret = kInProgress;
+	while (ret == kInProgress) {
+		ret = connectStep();
+	}
+	return ret;
+}
+
+void Mitsubishi::writeSnapshot(SnapshotWriter &writer) const {
+	writer.putU8(kSnapshotTag);
+	writer.putU8(connected_ ? 1 : 0);
+}
+
+Result Mitsubishi::readSnapshot(SnapshotReader &reader) {
+	uint8_t tag = reader.getU8();
+	uint8_t connected = reader.getU8();
+	if (!reader.ok() || tag != kSnapshotTag) {
+		return kInvalidData;
+	}
+
+	// The unit keeps its session across our reboot: skip the handshake in init() and
+	// let the first failed exchange trigger a reconnect as usual.
+	warmStart_ = (connected != 0);
+	return kSuccess;
 }
 
 Result Mitsubishi::init() {
@@ -158,10 +251,28 @@ Result Mitsubishi::init() {
 		return ret;
 	}
 
-	return connect();
+	opened_ = true;
+	handshakeStep_ = 0;
+	if (warmStart_) {
+		warmStart_ = false;
+		connected_ = true;
+		setReady(true);
+		CLIMATE_LOG_INFO("Mitsubishi: warm start, skipping handshake");
+	}
+
+	return kSuccess;
+}
+
+Result Mitsubishi::service() {
+	if (!opened_ || connected_) {
+		return kSuccess;
+	}
+
+	return connectStep();
 }
 
 Result Mitsubishi::setState(const ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::SetState);
 	Packet pkt{};
 
 	if (!connected_) {
@@ -197,6 +308,7 @@ Result Mitsubishi::setState(const ClimateSettings &settings) {
 }
 
 Result Mitsubishi::getState(ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::GetState);
 	Packet pkt{};
 
 	if (!connected_) {
@@ -222,6 +334,7 @@ Result Mitsubishi::getState(ClimateSettings &settings) {
 	if (ret != kSuccess) {
 		CLIMATE_LOG_ERROR("Mitsu: Failed to get state, marking as disconnected...");
 		connected_ = false;
+		setReady(false);
 		return ret;
 	}
 
@@ -264,10 +377,12 @@ Result Mitsubishi::getState(ClimateSettings &settings) {
 		}
 	}
 
+	notifyState(settings);
 	return kSuccess;
 }
 
 Result Mitsubishi::getRoomTemperature(float &temperature) {
+	TimedOperation timed(*this, MetricOperation::GetRoomTemperature);
 	Packet pkt{};
 
 	if (!connected_) {
@@ -302,6 +417,7 @@ Result Mitsubishi::getRoomTemperature(float &temperature) {
 		temperature = (reply.data[6] & 0x7F) / 2.0f;
 	}
 
+	notifyRoomTemperature(temperature);
 	return kSuccess;
 }
 
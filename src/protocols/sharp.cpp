@@ -10,8 +10,13 @@ namespace climate_uart {
 namespace protocols {
 
 namespace {
+constexpr uint32_t kBaudRate = 9600;
+constexpr transport::UartParity kParity = transport::UartParity::Even;
+constexpr uint8_t kStopBits = 1;
+
 constexpr uint16_t kPacketReadTimeoutMs = 500;
-constexpr uint8_t kCommandFrameSize = 14;
+constexpr uint16_t kQuietGapMs = static_cast<uint16_t>(quietGapMs(kBaudRate, kParity, kStopBits));
+constexpr uint32_t kHandshakeTimeoutMs = 4000;
 constexpr uint8_t kModeFrameSize = 14;
 constexpr uint8_t kStatusFrameSize = 18;
 constexpr uint8_t kAckByte = 0x06;
@@ -50,6 +55,24 @@ constexpr uint8_t kMsgSubscribe2[7] = {0x03, 0xFE, 0xA0, 0x01, 0x00, 0x00, 0x00}
 constexpr uint8_t kMsgGetState[4] = {0xDD, 0x02, 0xFC, 0x62};
 constexpr uint8_t kMsgGetStatus[4] = {0xDD, 0x02, 0xFD, 0x62};
 constexpr uint8_t kMsgConnected[7] = {0x03, 0x05, 0xB0, 0x00, 0x10, 0x00, 0x00};
+
+struct SyncPacket {
+    const uint8_t *data;
+    size_t size;
+};
+
+constexpr SyncPacket kSyncPackets[] = {
+    {kMsgInit1, sizeof(kMsgInit1)},
+    {kMsgInit2, sizeof(kMsgInit2)},
+    {kMsgSubscribe1, sizeof(kMsgSubscribe1)},
+    {kMsgSubscribe2, sizeof(kMsgSubscribe2)},
+    {kMsgGetState, sizeof(kMsgGetState)},
+    {kMsgGetStatus, sizeof(kMsgGetStatus)},
+    {kMsgConnected, sizeof(kMsgConnected)},
+};
+constexpr uint8_t kSyncPacketCount = sizeof(kSyncPackets) / sizeof(kSyncPackets[0]);
+
+constexpr uint8_t kSnapshotTag = 'S';
 }  // namespace
 
 Sharp::Sharp(transport::UartTransport &uart) : uart_(uart) {}
@@ -195,51 +218,109 @@ Result Sharp::readByte(uint8_t *byte, uint16_t timeoutMs) {
 }
 
 Result Sharp::readFrame(Frame &frame) {
+    return readFrame(frame, kPacketReadTimeoutMs, kPacketReadTimeoutMs);
+}
+
+Result Sharp::readFrame(Frame &frame, uint16_t firstByteTimeoutMs, uint16_t idleTimeoutMs) {
+    // The hunt for a start byte gives up after firstByteTimeoutMs overall, and the rest of
+    // the frame gets kPacketReadTimeoutMs: a babbling line cannot keep us here.
+    uint32_t start = time_now_ms();
+    uint16_t timeoutMs = firstByteTimeoutMs;
     frame.size = 0;
     frame.data[0] = 0x00;
 
     while (frame.data[0] != kFrameStartRx) {
-        if (readByte(&frame.data[0], kPacketReadTimeoutMs) == kTimeout) {
+        uint32_t remainingMs = time_remaining_ms(start, firstByteTimeoutMs);
+        if (readByte(&frame.data[0], static_cast<uint16_t>((remainingMs < timeoutMs) ? remainingMs : timeoutMs)) ==
+            kTimeout) {
             return kTimeout;
         }
 
         if (frame.data[0] != kFrameStartRx) {
             CLIMATE_LOG_WARNING("Sharp: Discarded byte: 0x%02X", frame.data[0]);
+            countMetric(MetricCounter::ResyncBytes);
+            timeoutMs = idleTimeoutMs;
         }
     }
 
+    CLIMATE_TRACE_INSTANT("first byte", 0);
+    uint32_t bodyStart = time_now_ms();
     if (readByte(&frame.data[1], kPacketReadTimeoutMs) != kSuccess) {
         return kTimeout;
     }
 
+    if (frame.data[1] + 3u > sizeof(frame.data)) {
+        CLIMATE_LOG_ERROR("Sharp: Invalid frame length %u", frame.data[1]);
+        return kInvalidData;
+    }
     frame.size = static_cast<uint8_t>(frame.data[1] + 3);
 
     for (uint8_t i = 2; i < frame.size; i++) {
-        if (readByte(&frame.data[i], kPacketReadTimeoutMs) != kSuccess) {
+        if (readByte(&frame.data[i], static_cast<uint16_t>(time_remaining_ms(bodyStart, kPacketReadTimeoutMs))) !=
+            kSuccess) {
             return kTimeout;
         }
     }
+    CLIMATE_TRACE_INSTANT("last byte", frame.size);
 
     uint8_t calculated = crc(frame.data, frame.size - 1);
     if (frame.data[frame.size - 1] != calculated) {
         CLIMATE_LOG_ERROR("Sharp: Invalid CRC");
         CLIMATE_LOG_BUFFER(frame.data, frame.size);
+        countMetric(MetricCounter::CrcErrors);
+        countMetric(MetricCounter::CorruptBytes, frame.size);
         return kInvalidCrc;
     }
 
+    countMetric(MetricCounter::FramesReceived);
+
     CLIMATE_LOG_DEBUG("Received frame: size=%u, type=0x%02X", frame.size, frame.data[2]);
     CLIMATE_LOG_BUFFER(frame.data, frame.size);
 
+    processFrame(frame);
     return kSuccess;
 }
 
+bool Sharp::decodeModeFrame(const Frame &frame, ClimateSettings &settings) {
+    if (frame.size != kModeFrameSize || frame.data[2] != kFrameTypeResponse) {
+        return false;
+    }
+
+    settings.temperature = static_cast<int>((frame.data[4] & 0x0F) + 16);
+    settings.action = (frame.data[8] & 0x80) ? HeatpumpAction::On : HeatpumpAction::Off;
+    settings.mode = byteToMode(frame.data[5] & 0x0F);
+    settings.fanSpeed = byteToFan((frame.data[5] & 0xF0) >> 4);
+    settings.vaneMode = byteToVane(frame.data[6] & 0x0F);
+    return true;
+}
+
+bool Sharp::decodeStatusFrame(const Frame &frame, float &temperature) {
+    if (frame.size != kStatusFrameSize) {
+        return false;
+    }
+
+    temperature = static_cast<float>(frame.data[7]);
+    return true;
+}
+
+void Sharp::processFrame(const Frame &frame) {
+    // The unit broadcasts mode and status frames on its own, so every frame read
+    // (including the ones drained by flushRx) is a fresh observation.
+    ClimateSettings settings;
+    float temperature = 0.0f;
+    if (decodeModeFrame(frame, settings)) {
+        notifyState(settings);
+    } else if (decodeStatusFrame(frame, temperature)) {
+        notifyRoomTemperature(temperature);
+    }
+}
+
 Result Sharp::sendAck() {
     uint8_t ack = kAckByte;
     return uart_.write(&ack, 1);
 }
 
-Result Sharp::sendCommand(const ClimateSettings &settings) {
-    uint8_t buffer[kCommandFrameSize];
+void Sharp::encodeCommand(const ClimateSettings &settings, uint8_t *buffer) {
     int pos = 0;
 
     buffer[pos++] = kFrameStartTx;
@@ -275,72 +356,135 @@ Result Sharp::sendCommand(const ClimateSettings &settings) {
     buffer[pos++] = 0x10;
 
     buffer[pos++] = cmdCrc(buffer);
-    buffer[pos++] = crc(buffer, kCommandFrameSize);
+    buffer[pos++] = crc(buffer, kCommandFrameSize - 1);
+}
+
+Result Sharp::sendCommand(const ClimateSettings &settings) {
+    uint8_t buffer[kCommandFrameSize];
+    encodeCommand(settings, buffer);
 
     CLIMATE_LOG_DEBUG("Sending command:");
     CLIMATE_LOG_BUFFER(buffer, kCommandFrameSize);
 
-    return uart_.write(buffer, kCommandFrameSize);
+    Result ret = uart_.write(buffer, kCommandFrameSize);
+    if (ret == kSuccess) {
+        countMetric(MetricCounter::FramesSent);
+    }
+    return ret;
 }
 
-void Sharp::flushRx() {
+void Sharp::awaitReplies(uint16_t replyTimeoutMs) {
+    // Wait for the first reply, then only for a quiet gap after each frame instead of a full
+    // read timeout: the step ends as soon as the unit stops talking, or after one more read
+    // timeout if it never does.
     Frame frame;
-    while (readFrame(frame) == kSuccess) {
+    uint16_t timeoutMs = replyTimeoutMs;
+    uint32_t budget = static_cast<uint32_t>(replyTimeoutMs) + kPacketReadTimeoutMs;
+    uint32_t start = time_now_ms();
+    while (time_elapsed_ms(start) < budget &&
+           readFrame(frame, timeoutMs, kQuietGapMs) != kTimeout) {
+        timeoutMs = kQuietGapMs;
     }
 }
 
-Result Sharp::connect() {
-    connected_ = false;
-
-    const struct SyncPacket {
-        const uint8_t *data;
-        size_t size;
-    } packets[] = {
-        {kMsgInit1, sizeof(kMsgInit1)},
-        {kMsgInit2, sizeof(kMsgInit2)},
-        {kMsgSubscribe1, sizeof(kMsgSubscribe1)},
-        {kMsgSubscribe2, sizeof(kMsgSubscribe2)},
-        {kMsgGetState, sizeof(kMsgGetState)},
-        {kMsgGetStatus, sizeof(kMsgGetStatus)},
-        {kMsgConnected, sizeof(kMsgConnected)},
-    };
-
-    CLIMATE_LOG_DEBUG("Sharp: Starting handshake sequence ...");
-
-    for (size_t i = 0; i < sizeof(packets) / sizeof(packets[0]); i++) {
-        CLIMATE_LOG_DEBUG("Sending handshake SYN%u packet ...", static_cast<unsigned>(i + 1));
-        CLIMATE_LOG_BUFFER(packets[i].data, packets[i].size);
-
-        Result ret = uart_.write(packets[i].data, packets[i].size);
-        if (ret != kSuccess) {
-            CLIMATE_LOG_ERROR("Sharp: Handshake SYN%u write failed: %d", static_cast<unsigned>(i + 1), ret);
-            return ret;
-        }
+void Sharp::flushRx() {
+    awaitReplies(kQuietGapMs);
+}
 
-        flushRx();
+Result Sharp::connectStep() {
+    if (handshakeStep_ == 0) {
+        connected_ = false;
+        setReady(false);
+        beginHandshake();
+        CLIMATE_LOG_DEBUG("Sharp: Starting handshake sequence ...");
     }
 
+    if (handshakeElapsedMs() > kHandshakeTimeoutMs) {
+        CLIMATE_LOG_ERROR("Sharp: Handshake timeout at step %u", static_cast<unsigned>(handshakeStep_ + 1));
+        handshakeStep_ = 0;
+        endHandshake(kTimeout);
+        return kTimeout;
+    }
+
+    uint32_t stepStart = time_now_ms();
+    const SyncPacket &syn = kSyncPackets[handshakeStep_];
+    CLIMATE_LOG_DEBUG("Sending handshake SYN%u packet ...", static_cast<unsigned>(handshakeStep_ + 1));
+    CLIMATE_LOG_BUFFER(syn.data, syn.size);
+
+    Result ret = uart_.write(syn.data, syn.size);
+    if (ret != kSuccess) {
+        CLIMATE_LOG_ERROR("Sharp: Handshake SYN%u write failed: %d", static_cast<unsigned>(handshakeStep_ + 1), ret);
+        handshakeStep_ = 0;
+        endHandshake(ret);
+        return ret;
+    }
+
+    countMetric(MetricCounter::FramesSent);
+    awaitReplies(kPacketReadTimeoutMs);
+    recordHandshakeStep(stepStart);
+
+    handshakeStep_++;
+    if (handshakeStep_ < kSyncPacketCount) {
+        return kInProgress;
+    }
+
+    handshakeStep_ = 0;
     CLIMATE_LOG_INFO("Sharp: Heatpump connected successfully!");
     connected_ = true;
+    setReady(true);
+    endHandshake(kSuccess);
     return kSuccess;
 }
 
+Result Sharp::connect() {
+    handshakeStep_ = 0;
+
+    Result ret = kInProgress;
+    while (ret == kInProgress) {
+        ret = connectStep();
+    }
+    return ret;
+}
+
+void Sharp::writeSnapshot(SnapshotWriter &writer) const {
+    writer.putU8(kSnapshotTag);
+}
+
+Result Sharp::readSnapshot(SnapshotReader &reader) {
+    return (reader.getU8() == kSnapshotTag && reader.ok()) ? kSuccess : kInvalidData;
+}
+
 Result Sharp::init() {
-    Result ret = uart_.open(9600, transport::UartParity::Even, 1);
+    Result ret = uart_.open(kBaudRate, kParity, kStopBits);
     if (ret != kSuccess) {
         CLIMATE_LOG_DEBUG("Failed to open UART: %d", ret);
         return ret;
     }
 
-    ret = connect();
-    if (ret != kSuccess) {
-        CLIMATE_LOG_DEBUG("Initial connection failed: %d", ret);
+    opened_ = true;
+    handshakeStep_ = 0;
+    return kSuccess;
+}
+
+Result Sharp::service() {
+    if (!opened_) {
+        return kSuccess;
+    }
+
+    if (!connected_) {
+        return connectStep();
     }
 
+    // Consume what the unit broadcast since the last call so the cache stays current
+    // without polling.
+    if (uart_.available() > 0) {
+        flushRx();
+    }
     return kSuccess;
 }
 
 Result Sharp::setState(const ClimateSettings &settings) {
+    TimedOperation timed(*this, MetricOperation::SetState);
     Frame response;
 
     if (!connected_) {
@@ -364,11 +508,60 @@ Result Sharp::setState(const ClimateSettings &settings) {
         return kSuccess;
     }
 
+    if (ret == kTimeout) {
+        countMetric(MetricCounter::Timeouts);
+    }
     flushRx();
     return ret;
 }
 
+Result Sharp::request(const uint8_t *msg, size_t size, FrameMatcher matches, Frame &frame) {
+    CLIMATE_TRACE_SPAN("request", static_cast<uint16_t>(size));
+    Result ret = uart_.write(msg, size);
+    if (ret != kSuccess) {
+        return ret;
+    }
+    countMetric(MetricCounter::FramesSent);
+
+    // Broadcasts may arrive before the reply: they are still decoded by readFrame(),
+    // but only a frame of the requested type ends the exchange.
+    uint32_t start = time_now_ms();
+    uint32_t remainingMs;
+    while ((remainingMs = time_remaining_ms(start, kPacketReadTimeoutMs)) > 0) {
+        // Bounded by kPacketReadTimeoutMs, so it fits the 16-bit read timeouts
+        uint16_t timeoutMs = static_cast<uint16_t>(remainingMs);
+        ret = readFrame(frame, timeoutMs, timeoutMs);
+        if (ret == kTimeout) {
+            break;
+        }
+        if (ret != kSuccess) {
+            continue;
+        }
+
+        if (frame.size > 1) {
+            sendAck();
+        }
+        if (matches(frame)) {
+            return kSuccess;
+        }
+    }
+
+    countMetric(MetricCounter::Timeouts);
+    return kTimeout;
+}
+
+bool Sharp::isModeFrame(const Frame &frame) {
+    ClimateSettings settings;
+    return decodeModeFrame(frame, settings);
+}
+
+bool Sharp::isStatusFrame(const Frame &frame) {
+    float temperature = 0.0f;
+    return decodeStatusFrame(frame, temperature);
+}
+
 Result Sharp::getState(ClimateSettings &settings) {
+    TimedOperation timed(*this, MetricOperation::GetState);
     Frame frame;
 
     if (!connected_) {
@@ -380,48 +573,24 @@ Result Sharp::getState(ClimateSettings &settings) {
 
     settings = ClimateSettings{};
 
-    Result ret = readFrame(frame);
+    Result ret = request(kMsgGetState, sizeof(kMsgGetState), isModeFrame, frame);
     if (ret != kSuccess) {
         CLIMATE_LOG_ERROR("Sharp: Failed to read state frame");
         return ret;
     }
 
-    if (frame.size > 1) {
-        sendAck();
-    }
-
-    if (frame.size == kModeFrameSize && frame.data[2] == kFrameTypeResponse) {
-        settings.temperature = static_cast<int>((frame.data[4] & 0x0F) + 16);
-        settings.action = (frame.data[8] & 0x80) ? HeatpumpAction::On : HeatpumpAction::Off;
-
-        uint8_t mode = frame.data[5] & 0x0F;
-        settings.mode = byteToMode(mode);
-
-        uint8_t fan = (frame.data[5] & 0xF0) >> 4;
-        settings.fanSpeed = byteToFan(fan);
-
-        uint8_t swingV = frame.data[6] & 0x0F;
-        settings.vaneMode = byteToVane(swingV);
-
-        CLIMATE_LOG_DEBUG("Sharp state: mode=%u, temp=%d, fan=%u, action=%u, vane=%u",
-                     static_cast<unsigned>(settings.mode),
-                     settings.temperature,
-                     static_cast<unsigned>(settings.fanSpeed),
-                     static_cast<unsigned>(settings.action),
-                     static_cast<unsigned>(settings.vaneMode));
-    } else if (frame.size == kStatusFrameSize) {
-        settings.temperature = static_cast<int>(frame.data[7]);
-        CLIMATE_LOG_DEBUG("Sharp status frame: temp=%d", settings.temperature);
-    } else {
-        CLIMATE_LOG_WARNING("Sharp: Unexpected frame type");
-        return kInvalidData;
-    }
-
-    flushRx();
+    decodeModeFrame(frame, settings);
+    CLIMATE_LOG_DEBUG("Sharp state: mode=%u, temp=%d, fan=%u, action=%u, vane=%u",
+                 static_cast<unsigned>(settings.mode),
+                 settings.temperature,
+                 static_cast<unsigned>(settings.fanSpeed),
+                 static_cast<unsigned>(settings.action),
+                 static_cast<unsigned>(settings.vaneMode));
     return kSuccess;
 }
 
 Result Sharp::getRoomTemperature(float &temperature) {
+    TimedOperation timed(*this, MetricOperation::GetRoomTemperature);
     Frame frame;
 
     if (!connected_) {
@@ -431,22 +600,14 @@ Result Sharp::getRoomTemperature(float &temperature) {
         }
     }
 
-    Result ret = readFrame(frame);
+    Result ret = request(kMsgGetStatus, sizeof(kMsgGetStatus), isStatusFrame, frame);
     if (ret != kSuccess) {
         return ret;
     }
 
-    if (frame.size > 1) {
-        sendAck();
-    }
-
-    if (frame.size == kStatusFrameSize) {
-        temperature = static_cast<float>(frame.data[7]);
-        CLIMATE_LOG_DEBUG("Room temperature: %.1f°C", static_cast<double>(temperature));
-        return kSuccess;
-    }
-
-    return kInvalidData;
+    decodeStatusFrame(frame, temperature);
+    CLIMATE_LOG_DEBUG("Room temperature: %.1f°C", static_cast<double>(temperature));
+    return kSuccess;
 }
 
 }  // namespace protocols
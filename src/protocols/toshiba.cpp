@@ -12,8 +12,18 @@ namespace climate_uart {
 namespace protocols {
 
 namespace {
+constexpr uint32_t kBaudRate = 9600;
+constexpr transport::UartParity kParity = transport::UartParity::Even;
+constexpr uint8_t kStopBits = 1;
+
 constexpr uint16_t kMaxPacketSize = 0xFF;
 constexpr uint32_t kPacketReadTimeoutMs = 250;
+// Whole packet once its start byte is in: a full 263-byte packet takes ~300 ms at 9600 baud.
+constexpr uint32_t kPacketBodyTimeoutMs = 2 * kPacketReadTimeoutMs;
+// Unsolicited packets may come before the reply to a request, but not for longer than this.
+constexpr uint32_t kExchangeTimeoutMs = 4 * kPacketReadTimeoutMs;
+constexpr uint32_t kQuietGapMs = quietGapMs(kBaudRate, kParity, kStopBits);
+constexpr uint32_t kHandshakeTimeoutMs = 4000;
 constexpr uint8_t kPacketStx = 0x02;
 
 constexpr uint8_t kPacketTypeReplyMask = 0x80;
@@ -55,6 +65,34 @@ constexpr uint8_t kSwingPos2 = 0x51;
 constexpr uint8_t kSwingPos3 = 0x52;
 constexpr uint8_t kSwingPos4 = 0x53;
 constexpr uint8_t kSwingPos5 = 0x54;
+
+constexpr uint8_t kSyn1[] = {0x02, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x02};
+constexpr uint8_t kSyn2[] = {0x02, 0xFF, 0xFF, 0x01, 0x00, 0x00, 0x01, 0x02, 0xFE};
+constexpr uint8_t kSyn3[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x02, 0xFA};
+constexpr uint8_t kSyn4[] = {0x02, 0x00, 0x01, 0x81, 0x01, 0x00, 0x02, 0x00, 0x00, 0x7B};
+constexpr uint8_t kSyn5[] = {0x02, 0x00, 0x01, 0x02, 0x00, 0x00, 0x02, 0x00, 0x00, 0xFB};
+constexpr uint8_t kSyn6[] = {0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0xFE};
+constexpr uint8_t kSyn7[] = {0x02, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02, 0x00, 0x00, 0xFB};
+constexpr uint8_t kSyn8[] = {0x02, 0x00, 0x02, 0x02, 0x00, 0x00, 0x02, 0x00, 0x00, 0xFA};
+
+struct SyncPacket {
+	const uint8_t *data;
+	size_t size;
+};
+
+constexpr SyncPacket kSyncPackets[] = {
+	{kSyn1, sizeof(kSyn1)},
+	{kSyn2, sizeof(kSyn2)},
+	{kSyn3, sizeof(kSyn3)},
+	{kSyn4, sizeof(kSyn4)},
+	{kSyn5, sizeof(kSyn5)},
+	{kSyn6, sizeof(kSyn6)},
+	{kSyn7, sizeof(kSyn7)},
+	{kSyn8, sizeof(kSyn8)}
+};
+constexpr uint8_t kSyncPacketCount = sizeof(kSyncPackets) / sizeof(kSyncPackets[0]);
+
+constexpr uint8_t kSnapshotTag = 'T';
 }  // namespace
 
 Toshiba::Toshiba(transport::UartTransport &uart) : uart_(uart) {}
@@ -200,32 +238,45 @@ Result Toshiba::readByte(uint8_t *byte, uint32_t timeoutMs) {
 }
 
 Result Toshiba::readPacket(Packet &packet) {
+	return readPacket(packet, kPacketReadTimeoutMs, kPacketReadTimeoutMs);
+}
+
+Result Toshiba::readPacket(Packet &packet, uint32_t firstByteTimeoutMs, uint32_t idleTimeoutMs) {
+	// The hunt for a start byte gives up after firstByteTimeoutMs overall and the body has
+	// kPacketBodyTimeoutMs, whatever the line carries.
+	uint32_t start = time_now_ms();
+	uint32_t timeoutMs = firstByteTimeoutMs;
 	packet.stx = 0x00;
 	while (packet.stx != kPacketStx) {
-		if (readByte(&packet.stx, kPacketReadTimeoutMs) == kTimeout) {
+		uint32_t remainingMs = time_remaining_ms(start, firstByteTimeoutMs);
+		if (readByte(&packet.stx, (remainingMs < timeoutMs) ? remainingMs : timeoutMs) == kTimeout) {
 			return kTimeout;
 		}
 		if (packet.stx != kPacketStx) {
 			CLIMATE_LOG_WARNING("Toshiba: Discarded byte: 0x%02X", packet.stx);
+			countMetric(MetricCounter::ResyncBytes);
+			timeoutMs = idleTimeoutMs;
 		}
 	}
+	CLIMATE_TRACE_INSTANT("first byte", 0);
 
-	if (readByte(&packet.header[0], kPacketReadTimeoutMs) != kSuccess) {
+	start = time_now_ms();
+	if (readByte(&packet.header[0], time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
-	if (readByte(&packet.header[1], kPacketReadTimeoutMs) != kSuccess) {
+	if (readByte(&packet.header[1], time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
-	if (readByte(&packet.type, kPacketReadTimeoutMs) != kSuccess) {
+	if (readByte(&packet.type, time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
-	if (readByte(&packet.unknown1, kPacketReadTimeoutMs) != kSuccess) {
+	if (readByte(&packet.unknown1, time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
-	if (readByte(&packet.unknown2, kPacketReadTimeoutMs) != kSuccess) {
+	if (readByte(&packet.unknown2, time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
-	if (readByte(&packet.size, kPacketReadTimeoutMs) != kSuccess) {
+	if (readByte(&packet.size, time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
 
@@ -234,18 +285,23 @@ Result Toshiba::readPacket(Packet &packet) {
 	}
 
 	for (uint16_t i = 0; i < packet.size; i++) {
-		if (readByte(&packet.data[i], kPacketReadTimeoutMs) != kSuccess) {
+		if (readByte(&packet.data[i], time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 			return kTimeout;
 		}
 	}
 
-	if (readByte(&packet.checksum, kPacketReadTimeoutMs) != kSuccess) {
+	if (readByte(&packet.checksum, time_remaining_ms(start, kPacketBodyTimeoutMs)) != kSuccess) {
 		return kTimeout;
 	}
+	CLIMATE_TRACE_INSTANT("last byte", packet.size + 8);
 
 	uint8_t calculated = crc(reinterpret_cast<uint8_t *>(&packet), static_cast<uint8_t>(packet.size + 7));
 	if (calculated != packet.checksum) {
 		CLIMATE_LOG_ERROR("Toshiba: Invalid crc recv=0x%02X, calc=0x%02X", packet.checksum, calculated);
+		countMetric(MetricCounter::CrcErrors);
+		countMetric(MetricCounter::CorruptBytes, packet.size + 8u);
+	} else {
+		countMetric(MetricCounter::FramesReceived);
 	}
 
 	CLIMATE_LOG_DEBUG("Received packet: type=0x%02X, size=%u", packet.type, packet.size);
@@ -282,82 +338,202 @@ Result Toshiba::sendCommand(uint8_t *data, uint16_t dataSize) {
 	CLIMATE_LOG_DEBUG("Sending command size=%u", pos);
 	CLIMATE_LOG_BUFFER(buffer, pos);
 
-	return uart_.write(buffer, pos);
+	Result ret = uart_.write(buffer, pos);
+	if (ret == kSuccess) {
+		countMetric(MetricCounter::FramesSent);
+	}
+	return ret;
 }
 
 Result Toshiba::query(uint8_t function, Packet &result) {
+	CLIMATE_TRACE_SPAN("query", function);
 	uint8_t buffer[] = {function};
 	Result ret = sendCommand(buffer, sizeof(buffer));
 	if (ret != kSuccess) {
 		return ret;
 	}
 
-	while (readPacket(result) == kSuccess) {
-		if (result.type == static_cast<uint8_t>(kPacketTypeCommand | kPacketTypeReplyMask)) {
+	// Late replies to an earlier query and frames the unit sends on its own carry another
+	// function code: fold them into the cached state instead of dropping them.
+	uint32_t start = time_now_ms();
+	while (time_elapsed_ms(start) < kExchangeTimeoutMs && readPacket(result) == kSuccess) {
+		if (result.type == static_cast<uint8_t>(kPacketTypeCommand | kPacketTypeReplyMask) &&
+			result.size > 7 && result.data[7] == function) {
 			return kSuccess;
 		}
+		applyReply(result);
 	}
 
+	countMetric(MetricCounter::Timeouts);
 	return kTimeout;
 }
 
-void Toshiba::flushRx() {
+ClimateFieldMask Toshiba::decodeReply(const Packet &packet, ClimateSettings &settings, float &roomTemperature) {
+	if (packet.size < 9) {
+		return 0;
+	}
+
+	if (packet.data[7] == kFunctionGroup1) {
+		if (packet.size < 12) {
+			return 0;
+		}
+		settings.mode = byteToMode(packet.data[8]);
+		settings.temperature = packet.data[9];
+		settings.fanSpeed = byteToFan(packet.data[10]);
+		return fieldMask(ClimateField::Mode) | fieldMask(ClimateField::Temperature) | fieldMask(ClimateField::FanSpeed);
+	}
+
+	// Single function replies and the status reply are a list of (function, value) pairs.
+	ClimateFieldMask fields = 0;
+	for (uint8_t i = 7; i + 1 < packet.size; i += 2) {
+		uint8_t value = packet.data[i + 1];
+		switch (packet.data[i]) {
+		case kFunctionPowerState:
+			settings.action = (value == kPowerStateOn) ? HeatpumpAction::On : HeatpumpAction::Off;
+			fields |= fieldMask(ClimateField::Action);
+			break;
+		case kFunctionUnitMode:
+			settings.mode = byteToMode(value);
+			fields |= fieldMask(ClimateField::Mode);
+			break;
+		case kFunctionSetpoint:
+			settings.temperature = value;
+			fields |= fieldMask(ClimateField::Temperature);
+			break;
+		case kFunctionFanMode:
+			settings.fanSpeed = byteToFan(value);
+			fields |= fieldMask(ClimateField::FanSpeed);
+			break;
+		case kFunctionSwing:
+			settings.vaneMode = byteToVane(value);
+			fields |= fieldMask(ClimateField::VaneMode);
+			break;
+		case kFunctionRoomTemp:
+			roomTemperature = static_cast<float>(static_cast<int8_t>(value));
+			fields |= fieldMask(ClimateField::RoomTemperature);
+			break;
+		default:
+			break;
+		}
+	}
+	return fields;
+}
+
+bool Toshiba::isStatusReply(const Packet &packet) {
+	return packet.type == static_cast<uint8_t>(kPacketTypeCommand | kPacketTypeReplyMask) && packet.size > 7 &&
+		   packet.data[7] == kFunctionStatus &&
+		   crc(reinterpret_cast<const uint8_t *>(&packet), static_cast<uint8_t>(packet.size + 7)) == packet.checksum;
+}
+
+ClimateFieldMask Toshiba::applyReply(const Packet &packet) {
+	// readPacket() hands over packets with a bad checksum; never let them into the cache.
+	if (crc(reinterpret_cast<const uint8_t *>(&packet), static_cast<uint8_t>(packet.size + 7)) != packet.checksum) {
+		return 0;
+	}
+
+	ClimateSettings settings;
+	float roomTemperature = 0.0f;
+	ClimateFieldMask fields = decodeReply(packet, settings, roomTemperature);
+	if (fields & kSettingsFields) {
+		notifyState(settings, fields & kSettingsFields);
+	}
+	if (fields & fieldMask(ClimateField::RoomTemperature)) {
+		notifyRoomTemperature(roomTemperature);
+	}
+	return fields;
+}
+
+void Toshiba::awaitReplies(uint32_t replyTimeoutMs) {
+	// Wait for the first packet, then only for a quiet gap after each one instead of a full
+	// read timeout: the step ends as soon as the unit stops talking, or kExchangeTimeoutMs
+	// later if it never does.
 	Packet packet{};
-	while (readPacket(packet) == kSuccess) {
+	uint32_t timeoutMs = replyTimeoutMs;
+	uint32_t start = time_now_ms();
+	while (time_elapsed_ms(start) < replyTimeoutMs + kExchangeTimeoutMs &&
+		   readPacket(packet, timeoutMs, kQuietGapMs) != kTimeout) {
+		// Handshake replies are not state frames.
+		if (connected_) {
+			applyReply(packet);
+		}
+		timeoutMs = kQuietGapMs;
 	}
 }
 
-Result Toshiba::connect() {
-	static const uint8_t kSyn1[] = {0x02, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x02};
-	static const uint8_t kSyn2[] = {0x02, 0xFF, 0xFF, 0x01, 0x00, 0x00, 0x01, 0x02, 0xFE};
-	static const uint8_t kSyn3[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x02, 0xFA};
-	static const uint8_t kSyn4[] = {0x02, 0x00, 0x01, 0x81, 0x01, 0x00, 0x02, 0x00, 0x00, 0x7B};
-	static const uint8_t kSyn5[] = {0x02, 0x00, 0x01, 0x02, 0x00, 0x00, 0x02, 0x00, 0x00, 0xFB};
-	static const uint8_t kSyn6[] = {0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0xFE};
-	static const uint8_t kSyn7[] = {0x02, 0x00, 0x02, 0x01, 0x00, 0x00, 0x02, 0x00, 0x00, 0xFB};
-	static const uint8_t kSyn8[] = {0x02, 0x00, 0x02, 0x02, 0x00, 0x00, 0x02, 0x00, 0x00, 0xFA};
-
-	struct SyncPkt {
-		const uint8_t *data;
-		size_t size;
-	};
-	const SyncPkt syncPkts[] = {
-		{kSyn1, sizeof(kSyn1)},
-		{kSyn2, sizeof(kSyn2)},
-		{kSyn3, sizeof(kSyn3)},
-		{kSyn4, sizeof(kSyn4)},
-		{kSyn5, sizeof(kSyn5)},
-		{kSyn6, sizeof(kSyn6)},
-		{kSyn7, sizeof(kSyn7)},
-		{kSyn8, sizeof(kSyn8)}
-	};
+void Toshiba::flushRx() {
+	awaitReplies(kQuietGapMs);
+}
 
-	connected_ = false;
-	CLIMATE_LOG_DEBUG("Toshiba: Starting handshake sequence ...");
-	for (size_t i = 0; i < sizeof(syncPkts) / sizeof(syncPkts[0]); i++) {
-		CLIMATE_LOG_DEBUG("Sending handshake SYN%u packet ...", static_cast<unsigned>(i + 1));
-		CLIMATE_LOG_BUFFER(syncPkts[i].data, syncPkts[i].size);
+Result Toshiba::connectStep() {
+	if (handshakeStep_ == 0) {
+		connected_ = false;
+		setReady(false);
+		beginHandshake();
+		CLIMATE_LOG_DEBUG("Toshiba: Starting handshake sequence ...");
+	}
+
+	if (handshakeElapsedMs() > kHandshakeTimeoutMs) {
+		CLIMATE_LOG_ERROR("Toshiba: Handshake timeout at step %u", static_cast<unsigned>(handshakeStep_ + 1));
+		handshakeStep_ = 0;
+		endHandshake(kTimeout);
+		return kTimeout;
+	}
+
+	uint32_t stepStart = time_now_ms();
+	if (handshakeStep_ < kSyncPacketCount) {
+		const SyncPacket &syn = kSyncPackets[handshakeStep_];
+		CLIMATE_LOG_DEBUG("Sending handshake SYN%u packet ...", static_cast<unsigned>(handshakeStep_ + 1));
+		CLIMATE_LOG_BUFFER(syn.data, syn.size);
 
-		Result ret = uart_.write(syncPkts[i].data, syncPkts[i].size);
+		Result ret = uart_.write(syn.data, syn.size);
 		if (ret != kSuccess) {
-			CLIMATE_LOG_ERROR("Toshiba: Handshake SYN%u write failed: %d", static_cast<unsigned>(i + 1), ret);
+			CLIMATE_LOG_ERROR("Toshiba: Handshake SYN%u write failed: %d", static_cast<unsigned>(handshakeStep_ + 1), ret);
+			handshakeStep_ = 0;
+			endHandshake(ret);
 			return ret;
 		}
-		flushRx();
+		countMetric(MetricCounter::FramesSent);
+		awaitReplies(kPacketReadTimeoutMs);
+		recordHandshakeStep(stepStart);
+		handshakeStep_++;
+		return kInProgress;
 	}
 
+	handshakeStep_ = 0;
+
 	Packet packet{};
-	if (query(kFunctionStatus, packet) != kSuccess) {
+	Result ret = query(kFunctionStatus, packet);
+	recordHandshakeStep(stepStart);
+	if (ret != kSuccess) {
 		CLIMATE_LOG_ERROR("Toshiba: Handshake failed - no response to status query");
+		endHandshake(kTimeout);
 		return kTimeout;
 	}
 
+	ClimateFieldMask fields = applyReply(packet);
+	if (isStatusReply(packet)) {
+		statusFields_ = fields;
+	}
+
 	CLIMATE_LOG_INFO("Toshiba Heatpump connected successfully");
 	connected_ = true;
+	setReady(true);
+	endHandshake(kSuccess);
 	return kSuccess;
 }
 
+Result Toshiba::connect() {
+	handshakeStep_ = 0;
+
+	Result ret = kInProgress;
+	while (ret == kInProgress) {
+		ret = connectStep();
+	}
+	return ret;
+}
+
 Result Toshiba::command(uint8_t function, uint8_t value) {
+	CLIMATE_TRACE_SPAN("command", function);
 	Packet result{};
 	uint8_t buffer[] = {function, value};
 	Result ret = sendCommand(buffer, sizeof(buffer));
@@ -365,34 +541,77 @@ Result Toshiba::command(uint8_t function, uint8_t value) {
 		return ret;
 	}
 
-	while (readPacket(result) == kSuccess) {
+	uint32_t start = time_now_ms();
+	while (time_elapsed_ms(start) < kExchangeTimeoutMs && readPacket(result) == kSuccess) {
 		if (result.type == static_cast<uint8_t>(kPacketTypeCommand | kPacketTypeReplyMask)) {
 			CLIMATE_LOG_DEBUG("Command response received for function: '0x%X' (Size=%u)", function, result.size);
 			return kSuccess;
 		}
+		applyReply(result);
 	}
 
+	countMetric(MetricCounter::Timeouts);
 	return kTimeout;
 }
 
+void Toshiba::writeSnapshot(SnapshotWriter &writer) const {
+	writer.putU8(kSnapshotTag);
+	writer.putU8(connected_ ? 1 : 0);
+}
+
+Result Toshiba::readSnapshot(SnapshotReader &reader) {
+	uint8_t tag = reader.getU8();
+	uint8_t connected = reader.getU8();
+	if (!reader.ok() || tag != kSnapshotTag) {
+		return kInvalidData;
+	}
+
+	// The unit keeps its session across our reboot: skip the handshake in init() and
+	// let the first failed exchange trigger a reconnect as usual.
+	warmStart_ = (connected != 0);
+	return kSuccess;
+}
+
 Result Toshiba::init() {
 	connected_ = false;
+	setReady(false);
 	CLIMATE_LOG_DEBUG("Opening UART for Toshiba Heatpump ...");
-	Result ret = uart_.open(9600, transport::UartParity::Even, 1);
+	Result ret = uart_.open(kBaudRate, kParity, kStopBits);
 	if (ret != kSuccess) {
 		CLIMATE_LOG_DEBUG("Failed to open UART: %d", ret);
 		return ret;
 	}
 
-	ret = connect();
-	if (ret != kSuccess) {
-		CLIMATE_LOG_DEBUG("Initial connection failed: %d", ret);
+	opened_ = true;
+	handshakeStep_ = 0;
+	if (warmStart_) {
+		warmStart_ = false;
+		connected_ = true;
+		setReady(true);
+		CLIMATE_LOG_INFO("Toshiba: warm start, skipping handshake");
+	}
+
+	return kSuccess;
+}
+
+Result Toshiba::service() {
+	if (!opened_) {
+		return kSuccess;
 	}
 
+	if (!connected_) {
+		return connectStep();
+	}
+
+	// Consume what the unit sent on its own since the last call.
+	if (uart_.available() > 0) {
+		flushRx();
+	}
 	return kSuccess;
 }
 
 Result Toshiba::setState(const ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::SetState);
 	if (!connected_) {
 		Result ret = connect();
 		if (ret != kSuccess) {
@@ -433,8 +652,8 @@ Result Toshiba::setState(const ClimateSettings &settings) {
 	return kSuccess;
 }
 
-Result Toshiba::getState(ClimateSettings &settings) {
-	Packet response{};
+Result Toshiba::refresh(ClimateFieldMask fields) {
+	TimedOperation timed(*this, MetricOperation::Refresh);
 	if (!connected_) {
 		Result ret = connect();
 		if (ret != kSuccess) {
@@ -442,35 +661,79 @@ Result Toshiba::getState(ClimateSettings &settings) {
 		}
 	}
 
-	settings = ClimateSettings{};
+	constexpr ClimateFieldMask kGroup1Fields = fieldMask(ClimateField::Mode) | fieldMask(ClimateField::Temperature) |
+											   fieldMask(ClimateField::FanSpeed);
 
-	Result ret = query(kFunctionGroup1, response);
-	if (ret != kSuccess || response.size < 12 || response.data[7] != kFunctionGroup1) {
-		CLIMATE_LOG_ERROR("Toshiba: Failed to get state Group1, marking as disconnected...");
-		connected_ = false;
-		return kTimeout;
+	struct FieldQuery {
+		ClimateFieldMask fields;
+		uint8_t function;
+	};
+	constexpr FieldQuery kFallbackQueries[] = {
+		{kGroup1Fields, kFunctionGroup1},
+		{fieldMask(ClimateField::Action), kFunctionPowerState},
+		{fieldMask(ClimateField::VaneMode), kFunctionSwing},
+		{fieldMask(ClimateField::RoomTemperature), kFunctionRoomTemp},
+	};
+
+	Packet response{};
+	ClimateSettings settings;
+	float roomTemperature = 0.0f;
+	ClimateFieldMask refreshed = 0;
+	Result ret = kSuccess;
+
+	// The status reply carries every field the unit reports in one exchange. Units whose
+	// status reply lacks some of them fall back to the individual function queries below,
+	// and units that report nothing useful there stop being asked.
+	if (fields & statusFields_) {
+		// Only a reply that passes its checksum may narrow the mask; after a corrupt one the
+		// fallbacks cover this call and the next call asks for the status again.
+		if (query(kFunctionStatus, response) == kSuccess && isStatusReply(response)) {
+			refreshed = decodeReply(response, settings, roomTemperature);
+			statusFields_ = refreshed;
+		}
 	}
 
-	settings.mode = byteToMode(response.data[8]);
-	settings.temperature = response.data[9];
-	settings.fanSpeed = byteToFan(response.data[10]);
+	for (const FieldQuery &fallback : kFallbackQueries) {
+		if (!(fields & fallback.fields & ~refreshed)) {
+			continue;
+		}
 
-	ret = query(kFunctionPowerState, response);
-	if (ret != kSuccess || response.size < 9 || response.data[7] != kFunctionPowerState) {
-		CLIMATE_LOG_ERROR("Toshiba: Failed to get state power");
-		return kInvalidData;
+		ret = query(fallback.function, response);
+		ClimateFieldMask decoded = (ret == kSuccess) ? decodeReply(response, settings, roomTemperature) : 0;
+		if ((decoded & fallback.fields) != fallback.fields) {
+			if (fallback.function == kFunctionGroup1) {
+				CLIMATE_LOG_ERROR("Toshiba: Failed to get state Group1, marking as disconnected...");
+				connected_ = false;
+				setReady(false);
+				return kTimeout;
+			}
+			CLIMATE_LOG_ERROR("Toshiba: Failed to query function 0x%02X", fallback.function);
+			ret = kInvalidData;
+			break;
+		}
+		refreshed |= decoded;
 	}
 
-	settings.action = (response.data[8] == kPowerStateOn) ? HeatpumpAction::On : HeatpumpAction::Off;
-
-	ret = query(kFunctionSwing, response);
-	if (ret != kSuccess || response.size < 9 || response.data[7] != kFunctionSwing) {
-		CLIMATE_LOG_ERROR("Toshiba: Failed to get state swing");
-		return kInvalidData;
+	if (refreshed & kSettingsFields) {
+		notifyState(settings, refreshed & kSettingsFields);
+	}
+	if (refreshed & fieldMask(ClimateField::RoomTemperature)) {
+		CLIMATE_LOG_DEBUG("Room temperature: %.1f°C", roomTemperature);
+		notifyRoomTemperature(roomTemperature);
 	}
 
-	settings.vaneMode = byteToVane(response.data[8]);
-	flushRx();
+	return ret;
+}
+
+Result Toshiba::getState(ClimateSettings &settings) {
+	TimedOperation timed(*this, MetricOperation::GetState);
+	settings = ClimateSettings{};
+
+	Result ret = refresh(kSettingsFields);
+	if (ret != kSuccess) {
+		return ret;
+	}
+	cachedState(settings);
 
 	CLIMATE_LOG_DEBUG("Toshiba state: mode=%u, temp=%d, fan=%u, action=%u, vane=%u",
 					 static_cast<uint8_t>(settings.mode), settings.temperature,
@@ -481,20 +744,16 @@ Result Toshiba::getState(ClimateSettings &settings) {
 }
 
 Result Toshiba::getRoomTemperature(float &temperature) {
-	Packet response{};
-	if (!connected_) {
-		Result ret = connect();
-		if (ret != kSuccess) {
-			return kInvalidNotConnected;
-		}
+	TimedOperation timed(*this, MetricOperation::GetRoomTemperature);
+	Result ret = refresh(fieldMask(ClimateField::RoomTemperature));
+	if (ret == kInvalidNotConnected) {
+		return ret;
 	}
 
-	Result ret = query(kFunctionRoomTemp, response);
-	if (ret == kSuccess && response.size >= 9 && response.data[7] == kFunctionRoomTemp) {
-		temperature = static_cast<float>(static_cast<int8_t>(response.data[1]));
-		CLIMATE_LOG_DEBUG("Room temperature: %.1f°C", temperature);
+	// A missing room temperature reply is not an error: keep the caller's value.
+	if (ret == kSuccess) {
+		cachedRoomTemperature(temperature);
 	}
-
 	return kSuccess;
 }
 
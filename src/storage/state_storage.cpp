@@ -0,0 +1,36 @@
+#include "climate_uart/storage/state_storage.h"
+
+namespace climate_uart {
+namespace storage {
+
+Result saveState(const ClimateInterface &climate, StateStorage &storage) {
+    uint8_t buffer[ClimateInterface::kSnapshotMaxSize];
+    size_t size = sizeof(buffer);
+
+    Result ret = climate.saveSnapshot(buffer, &size);
+    if (ret != kSuccess) {
+        CLIMATE_LOG_ERROR("Storage: Failed to serialise snapshot: %d", ret);
+        return ret;
+    }
+
+    return storage.save(buffer, size);
+}
+
+Result restoreState(ClimateInterface &climate, StateStorage &storage) {
+    uint8_t buffer[ClimateInterface::kSnapshotMaxSize];
+    size_t size = sizeof(buffer);
+
+    Result ret = storage.load(buffer, &size);
+    if (ret != kSuccess) {
+        return ret;
+    }
+
+    ret = climate.restoreSnapshot(buffer, size);
+    if (ret != kSuccess) {
+        CLIMATE_LOG_WARNING("Storage: Ignoring invalid snapshot: %d", ret);
+    }
+    return ret;
+}
+
+}  // namespace storage
+}  // namespace climate_uart
@@ -0,0 +1,73 @@
+#include "climate_uart/storage/state_storage_file.h"
+
+#if !defined(ARDUINO) || defined(ARDUINO_ARCH_ESP32)
+
+#include <stdio.h>
+#include <unistd.h>
+
+namespace climate_uart {
+namespace storage {
+
+StateStorageFile::StateStorageFile(const char *path) : path_(path) {}
+
+Result StateStorageFile::load(uint8_t *buffer, size_t *size) {
+    if (!path_ || !buffer || !size || *size == 0) {
+        return kInvalidParameters;
+    }
+
+    FILE *file = fopen(path_, "rb");
+    if (!file) {
+        return kDeviceNotFound;
+    }
+
+    size_t readBytes = fread(buffer, 1, *size, file);
+    bool failed = ferror(file) != 0;
+    fclose(file);
+
+    if (failed) {
+        return kReadError;
+    }
+
+    *size = readBytes;
+    return kSuccess;
+}
+
+Result StateStorageFile::save(const uint8_t *buffer, size_t size) {
+    if (!path_ || !buffer || size == 0) {
+        return kInvalidParameters;
+    }
+
+    char tmpPath[256];
+    int written = snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path_);
+    if (written <= 0 || static_cast<size_t>(written) >= sizeof(tmpPath)) {
+        return kInvalidParameters;
+    }
+
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file) {
+        CLIMATE_LOG_ERROR("Storage: Unable to open %s", tmpPath);
+        return kWriteError;
+    }
+
+    // The data must be on the medium before the rename makes it the snapshot, or a power
+    // cut right after could leave the new name on an empty file.
+    bool failed = fwrite(buffer, 1, size, file) != size;
+    failed = failed || fflush(file) != 0 || fsync(fileno(file)) != 0;
+    failed = (fclose(file) != 0) || failed;
+    if (failed) {
+        remove(tmpPath);
+        return kWriteError;
+    }
+
+    if (rename(tmpPath, path_) != 0) {
+        remove(tmpPath);
+        return kWriteError;
+    }
+
+    return kSuccess;
+}
+
+}  // namespace storage
+}  // namespace climate_uart
+
+#endif
@@ -0,0 +1,59 @@
+#ifdef ESP_PLATFORM
+
+#include "climate_uart/storage/state_storage_nvs.h"
+
+#include "nvs.h"
+
+namespace climate_uart {
+namespace storage {
+
+StateStorageNvs::StateStorageNvs(const char *nameSpace, const char *key) : nameSpace_(nameSpace), key_(key) {}
+
+Result StateStorageNvs::load(uint8_t *buffer, size_t *size) {
+    if (!buffer || !size || *size == 0) {
+        return kInvalidParameters;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(nameSpace_, NVS_READONLY, &handle) != ESP_OK) {
+        return kDeviceNotFound;
+    }
+
+    size_t length = *size;
+    esp_err_t err = nvs_get_blob(handle, key_, buffer, &length);
+    nvs_close(handle);
+
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return kDeviceNotFound;
+    }
+    if (err != ESP_OK) {
+        return kReadError;
+    }
+
+    *size = length;
+    return kSuccess;
+}
+
+Result StateStorageNvs::save(const uint8_t *buffer, size_t size) {
+    if (!buffer || size == 0) {
+        return kInvalidParameters;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(nameSpace_, NVS_READWRITE, &handle) != ESP_OK) {
+        return kDeviceInitFailed;
+    }
+
+    esp_err_t err = nvs_set_blob(handle, key_, buffer, size);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return (err == ESP_OK) ? kSuccess : kWriteError;
+}
+
+}  // namespace storage
+}  // namespace climate_uart
+
+#endif
@@ -0,0 +1,151 @@
+#include "climate_uart/trace.h"
+
+#include "climate_uart/platform.h"
+
+#include <stdio.h>
+
+namespace climate_uart {
+
+namespace {
+TraceBuffer *activeBuffer = nullptr;
+
+struct SourceName {
+    const void *source;
+    const char *name;
+};
+SourceName sourceNames[kTraceMaxSources] = {};
+
+const char *nameOf(const void *source) {
+    for (const SourceName &entry : sourceNames) {
+        if (entry.source == source) {
+            return entry.name;
+        }
+    }
+    return nullptr;
+}
+
+char phaseCode(TracePhase phase) {
+    switch (phase) {
+        case TracePhase::Begin:
+            return 'B';
+        case TracePhase::End:
+            return 'E';
+        default:
+            return 'i';
+    }
+}
+
+// snprintf() reports what it would have written: never pass more than the line holds
+void emit(TraceWriteFn write, void *context, const char *line, int size, size_t capacity) {
+    if (size > 0) {
+        write(line, (static_cast<size_t>(size) < capacity) ? static_cast<size_t>(size) : capacity - 1, context);
+    }
+}
+}  // namespace
+
+void TraceBuffer::record(TracePhase phase, const char *name, const void *source, uint16_t arg) {
+    if (capacity_ == 0) {
+        return;
+    }
+
+    TraceEvent &event = events_[head_];
+    event.timeUs = time_now_us();
+    event.name = name;
+    event.source = source;
+    event.arg = arg;
+    event.phase = phase;
+
+    head_ = (head_ + 1) % capacity_;
+    if (count_ < capacity_) {
+        count_++;
+    } else {
+        overwritten_++;
+    }
+}
+
+void TraceBuffer::clear() {
+    head_ = 0;
+    count_ = 0;
+    overwritten_ = 0;
+}
+
+const TraceEvent &TraceBuffer::at(size_t index) const {
+    return events_[(head_ + capacity_ - count_ + index) % capacity_];
+}
+
+void trace_set_buffer(TraceBuffer *buffer) {
+    activeBuffer = buffer;
+}
+
+void trace_set_source_name(const void *source, const char *name) {
+    for (SourceName &entry : sourceNames) {
+        if (entry.source == source || entry.source == nullptr) {
+            entry.source = source;
+            entry.name = name;
+            return;
+        }
+    }
+}
+
+void trace_record(TracePhase phase, const char *name, const void *source, uint16_t arg) {
+    if (activeBuffer) {
+        activeBuffer->record(phase, name, source, arg);
+    }
+}
+
+void trace_export_chrome(const TraceBuffer &buffer, TraceWriteFn write, void *context) {
+    if (!write) {
+        return;
+    }
+
+    // One timeline (tid) per driver, numbered in order of first appearance
+    const void *sources[kTraceMaxSources] = {};
+    uint8_t sourceCount = 0;
+
+    char line[160];
+    int size = snprintf(line, sizeof(line), "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    emit(write, context, line, size, sizeof(line));
+
+    bool first = true;
+    uint32_t originUs = (buffer.size() > 0) ? buffer.at(0).timeUs : 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        const TraceEvent &event = buffer.at(i);
+
+        uint8_t tid = 0;
+        while (tid < sourceCount && sources[tid] != event.source) {
+            tid++;
+        }
+        if (tid == sourceCount && sourceCount < kTraceMaxSources) {
+            sources[sourceCount++] = event.source;
+            const char *name = nameOf(event.source);
+            size = snprintf(line, sizeof(line),
+                            "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+                            "\"args\": {\"name\": \"%s\"}}",
+                            first ? "" : ",\n", static_cast<unsigned>(tid + 1), name ? name : "driver");
+            emit(write, context, line, size, sizeof(line));
+            first = false;
+        }
+
+        uint32_t ts = event.timeUs - originUs;
+        char phase = phaseCode(event.phase);
+        size = snprintf(line, sizeof(line),
+                        "%s  {\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %lu, \"pid\": 1, \"tid\": %u%s",
+                        first ? "" : ",\n", event.name, phase, static_cast<unsigned long>(ts),
+                        static_cast<unsigned>(tid + 1), (phase == 'i') ? ", \"s\": \"t\"" : "");
+        emit(write, context, line, size, sizeof(line));
+        first = false;
+
+        if (event.phase == TracePhase::End) {
+            write("}", 1, context);
+        } else {
+            size = snprintf(line, sizeof(line), ", \"args\": {\"arg\": %u}}", static_cast<unsigned>(event.arg));
+            emit(write, context, line, size, sizeof(line));
+        }
+    }
+
+    size = snprintf(line, sizeof(line), "\n], \"otherData\": {\"overwritten\": %lu}}\n",
+                    static_cast<unsigned long>(buffer.overwritten()));
+    emit(write, context, line, size, sizeof(line));
+}
+
+}  // namespace climate_uart
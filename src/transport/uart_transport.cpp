@@ -0,0 +1,66 @@
+#include "climate_uart/transport/uart_transport.h"
+
+#include "climate_uart/platform.h"
+
+namespace climate_uart {
+namespace transport {
+
+uint64_t WireStats::wireTimeUs(uint32_t bytes) const {
+    return (baudrate == 0) ? 0 : static_cast<uint64_t>(bytes) * bitsPerChar * 1000000ull / baudrate;
+}
+
+float WireStats::txUtilisation() const {
+    return (windowUs == 0) ? 0.0f : static_cast<float>(txBusyUs) / static_cast<float>(windowUs);
+}
+
+float WireStats::rxUtilisation() const {
+    return (windowUs == 0) ? 0.0f : static_cast<float>(rxBusyUs) / static_cast<float>(windowUs);
+}
+
+WireStats UartTransport::wireStats() const {
+    WireStats stats = wire_;
+    if (stats.baudrate != 0) {
+        stats.windowUs += static_cast<uint32_t>(time_now_us() - wireUpdatedUs_);
+    }
+    return stats;
+}
+
+void UartTransport::resetWireStats() {
+    uint32_t baudrate = wire_.baudrate;
+    uint8_t bitsPerChar = wire_.bitsPerChar;
+    wire_ = WireStats{};
+    wire_.baudrate = baudrate;
+    wire_.bitsPerChar = bitsPerChar;
+    wireUpdatedUs_ = time_now_us();
+}
+
+void UartTransport::wireOpened(uint32_t baudrate, UartParity parity, uint8_t stopBits) {
+    wire_ = WireStats{};
+    wire_.baudrate = baudrate;
+    wire_.bitsPerChar = static_cast<uint8_t>(bitsPerChar(parity, stopBits));
+    wireUpdatedUs_ = time_now_us();
+}
+
+void UartTransport::wireSent(size_t size) {
+    advanceWindow();
+    wire_.bytesSent += static_cast<uint32_t>(size);
+    wire_.txBusyUs += wire_.wireTimeUs(static_cast<uint32_t>(size));
+}
+
+void UartTransport::wireReceived(size_t size) {
+    advanceWindow();
+    wire_.bytesReceived += static_cast<uint32_t>(size);
+    wire_.rxBusyUs += wire_.wireTimeUs(static_cast<uint32_t>(size));
+}
+
+void UartTransport::advanceWindow() {
+    if (wire_.baudrate == 0) {
+        return;
+    }
+    uint32_t now = time_now_us();
+    wire_.windowUs += static_cast<uint32_t>(now - wireUpdatedUs_);
+    wireUpdatedUs_ = now;
+}
+
+}  // namespace transport
+}  // namespace climate_uart
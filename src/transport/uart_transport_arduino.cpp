@@ -35,12 +35,14 @@ Result UartTransportArduino::open(uint32_t baudrate, UartParity parity, uint8_t
     {
         serial_.begin(baudrate, config, rxPin_, txPin_);
         opened_ = true;
+        wireOpened(baudrate, parity, stopBits);
         return kSuccess;
     }
 #endif
 
     serial_.begin(baudrate, config);
     opened_ = true;
+    wireOpened(baudrate, parity, stopBits);
     return kSuccess;
 }
 
@@ -74,6 +76,7 @@ Result UartTransportArduino::read(uint8_t *buffer, size_t *size) {
     }
 
     *size = readCount;
+    wireReceived(readCount);
     return kSuccess;
 }
 
@@ -86,6 +89,7 @@ Result UartTransportArduino::write(const uint8_t *buffer, size_t size) {
     if (written != size) {
         return kWriteError;
     }
+    wireSent(size);
     return kSuccess;
 }
 
@@ -0,0 +1,182 @@
+#include "climate_uart/transport/uart_transport_capture.h"
+
+#include "climate_uart/platform.h"
+
+namespace climate_uart {
+namespace transport {
+
+namespace {
+// tag + delta + length, the longest header a record can have
+constexpr size_t kMaxHeaderSize = 1 + 5 + 5;
+
+size_t putVarint(uint8_t *out, uint32_t value) {
+    size_t size = 0;
+    while (value >= 0x80) {
+        out[size++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = static_cast<uint8_t>(value);
+    return size;
+}
+bool getVarint(const uint8_t *data, size_t size, size_t &offset, uint32_t &value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (offset >= size) {
+            return false;
+        }
+        uint8_t byte = data[offset++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace
+
+bool isCapture(const uint8_t *capture, size_t size) {
+    return capture && size >= kCaptureHeaderSize && capture[0] == kCaptureMagic[0] &&
+           capture[1] == kCaptureMagic[1] && capture[2] == kCaptureMagic[2] && capture[3] == kCaptureVersion;
+}
+
+bool readCaptureRecord(const uint8_t *capture, size_t size, size_t &offset, CaptureRecordView &record) {
+    if (offset >= size) {
+        return false;
+    }
+
+    size_t pos = offset;
+    uint8_t tag = capture[pos++];
+    record.kind = static_cast<CaptureRecord>(tag >> 6);
+    record.data = nullptr;
+    record.size = 0;
+    if (!getVarint(capture, size, pos, record.deltaUs)) {
+        return false;
+    }
+
+    switch (record.kind) {
+        case CaptureRecord::Rx:
+        case CaptureRecord::Tx:
+            record.size = tag & 0x3F;
+            if (record.size > kCaptureInlineLengthMax && !getVarint(capture, size, pos, record.size)) {
+                return false;
+            }
+            if (record.size > size - pos) {
+                return false;
+            }
+            record.data = &capture[pos];
+            pos += record.size;
+            break;
+        case CaptureRecord::Open:
+            if (!getVarint(capture, size, pos, record.baudrate) || size - pos < 2) {
+                return false;
+            }
+            record.parity = capture[pos++];
+            record.stopBits = capture[pos++];
+            break;
+        default:
+            break;
+    }
+
+    offset = pos;
+    return true;
+}
+
+UartTransportCapture::UartTransportCapture(UartTransport &inner, CaptureWriteFn write, void *context)
+    : inner_(inner), write_(write), context_(context) {}
+
+void UartTransportCapture::setSink(CaptureWriteFn write, void *context) {
+    write_ = write;
+    context_ = context;
+    started_ = false;
+    bytesCaptured_ = 0;
+}
+
+Result UartTransportCapture::open(uint32_t baudrate, UartParity parity, uint8_t stopBits) {
+    Result ret = inner_.open(baudrate, parity, stopBits);
+    if (ret == kSuccess) {
+        wireOpened(baudrate, parity, stopBits);
+        recordOpen(baudrate, parity, stopBits);
+    }
+    return ret;
+}
+
+Result UartTransportCapture::close() {
+    record(CaptureRecord::Close, nullptr, 0);
+    return inner_.close();
+}
+
+size_t UartTransportCapture::available() {
+    return inner_.available();
+}
+
+Result UartTransportCapture::read(uint8_t *buffer, size_t *size) {
+    Result ret = inner_.read(buffer, size);
+    if (ret == kSuccess && *size > 0) {
+        wireReceived(*size);
+        record(CaptureRecord::Rx, buffer, *size);
+    }
+    return ret;
+}
+
+Result UartTransportCapture::write(const uint8_t *buffer, size_t size) {
+    Result ret = inner_.write(buffer, size);
+    if (ret == kSuccess && size > 0) {
+        wireSent(size);
+        record(CaptureRecord::Tx, buffer, size);
+    }
+    return ret;
+}
+
+void UartTransportCapture::emit(const uint8_t *data, size_t size) {
+    write_(data, size, context_);
+    bytesCaptured_ += static_cast<uint32_t>(size);
+}
+
+size_t UartTransportCapture::beginRecord(uint8_t *header, CaptureRecord kind, uint8_t lowBits) {
+    uint32_t now = time_now_us();
+    if (!started_) {
+        const uint8_t magic[] = {kCaptureMagic[0], kCaptureMagic[1], kCaptureMagic[2], kCaptureVersion};
+        emit(magic, sizeof(magic));
+        lastRecordUs_ = now;
+        started_ = true;
+    }
+
+    header[0] = static_cast<uint8_t>((static_cast<uint8_t>(kind) << 6) | lowBits);
+    size_t size = 1 + putVarint(&header[1], now - lastRecordUs_);
+    lastRecordUs_ = now;
+    return size;
+}
+
+void UartTransportCapture::record(CaptureRecord kind, const uint8_t *data, size_t size) {
+    if (!enabled_ || !write_) {
+        return;
+    }
+
+    uint8_t header[kMaxHeaderSize];
+    bool inlineLength = size <= kCaptureInlineLengthMax;
+    size_t headerSize = beginRecord(header, kind, inlineLength ? static_cast<uint8_t>(size) : 63);
+    if (!inlineLength) {
+        headerSize += putVarint(&header[headerSize], static_cast<uint32_t>(size));
+    }
+
+    emit(header, headerSize);
+    if (size > 0) {
+        emit(data, size);
+    }
+}
+
+void UartTransportCapture::recordOpen(uint32_t baudrate, UartParity parity, uint8_t stopBits) {
+    if (!enabled_ || !write_) {
+        return;
+    }
+
+    uint8_t header[kMaxHeaderSize + 2];
+    size_t headerSize = beginRecord(header, CaptureRecord::Open, 0);
+    headerSize += putVarint(&header[headerSize], baudrate);
+    header[headerSize++] = static_cast<uint8_t>(parity);
+    header[headerSize++] = stopBits;
+    emit(header, headerSize);
+}
+
+}  // namespace transport
+}  // namespace climate_uart
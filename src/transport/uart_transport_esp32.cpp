@@ -53,6 +53,7 @@ Result UartTransportESP32::open(uint32_t baudrate, UartParity parity, uint8_t st
     }
 
     installed_ = true;
+    wireOpened(baudrate, parity, stopBits);
     return kSuccess;
 }
 
@@ -89,6 +90,7 @@ Result UartTransportESP32::read(uint8_t *buffer, size_t *size) {
     }
 
     *size = static_cast<size_t>(readBytes);
+    wireReceived(*size);
     return kSuccess;
 }
 
@@ -102,6 +104,7 @@ Result UartTransportESP32::write(const uint8_t *buffer, size_t size) {
         return kWriteError;
     }
 
+    wireSent(size);
     return kSuccess;
 }
 
@@ -0,0 +1,207 @@
+#include "climate_uart/transport/uart_transport_replay.h"
+
+#include "climate_uart/platform.h"
+
+namespace climate_uart {
+namespace transport {
+
+UartTransportReplay::UartTransportReplay(const uint8_t *capture, size_t size) : capture_(capture), size_(size) {
+    valid_ = isCapture(capture, size);
+    rx_.offset = kCaptureHeaderSize;
+    tx_.offset = kCaptureHeaderSize;
+    open_.offset = kCaptureHeaderSize;
+}
+
+void UartTransportReplay::setIdleHook(IdleHook hook, void *context) {
+    idleHook_ = hook;
+    idleContext_ = context;
+}
+
+// A truncated last record (capture cut by a power loss) reads as the end of the session.
+bool UartTransportReplay::next(Cursor &cursor, CaptureRecordView &record) const {
+    if (!valid_ || !readCaptureRecord(capture_, size_, cursor.offset, record)) {
+        return false;
+    }
+
+    cursor.timeUs += record.deltaUs;
+    if (record.kind == CaptureRecord::Tx) {
+        cursor.txBytes += record.size;
+    }
+    return true;
+}
+
+Result UartTransportReplay::open(uint32_t baudrate, UartParity parity, uint8_t stopBits) {
+    if (!valid_) {
+        return kInvalidData;
+    }
+
+    if (!started_) {
+        started_ = true;
+        lastClockUs_ = time_now_us();
+    }
+    wireOpened(baudrate, parity, stopBits);
+
+    CaptureRecordView record;
+    while (next(open_, record)) {
+        if (record.kind == CaptureRecord::Open) {
+            if (record.baudrate != baudrate || record.parity != static_cast<uint8_t>(parity) ||
+                record.stopBits != stopBits) {
+                settingsMismatches_++;
+            }
+            break;
+        }
+    }
+    return kSuccess;
+}
+
+Result UartTransportReplay::close() {
+    return kSuccess;
+}
+
+void UartTransportReplay::advanceClock() {
+    if (!started_) {
+        return;
+    }
+    uint32_t now = time_now_us();
+    elapsedUs_ += static_cast<uint32_t>(now - lastClockUs_);
+    lastClockUs_ = now;
+}
+
+bool UartTransportReplay::release() {
+    if (chunkLeft_ > 0) {
+        return true;
+    }
+
+    Cursor cursor = rx_;
+    CaptureRecordView record;
+    while (next(cursor, record)) {
+        if (record.kind != CaptureRecord::Rx || record.size == 0) {
+            rx_ = cursor;
+            continue;
+        }
+
+        uint64_t dueUs = speed_ ? cursor.timeUs / speed_ : 0;
+        if (txWritten_ < cursor.txBytes || elapsedUs_ < dueUs) {
+            return false;
+        }
+        rx_ = cursor;
+        chunk_ = record.data;
+        chunkLeft_ = record.size;
+        return true;
+    }
+    return false;
+}
+
+void UartTransportReplay::idle() {
+    if (!idleHook_) {
+        return;
+    }
+
+    uint32_t dueInUs = UINT32_MAX;
+    Cursor cursor = rx_;
+    CaptureRecordView record;
+    while (next(cursor, record)) {
+        if (record.kind == CaptureRecord::Rx && record.size > 0) {
+            uint64_t dueUs = speed_ ? cursor.timeUs / speed_ : 0;
+            if (txWritten_ >= cursor.txBytes) {
+                uint64_t waitUs = (dueUs > elapsedUs_) ? dueUs - elapsedUs_ : 0;
+                dueInUs = (waitUs < UINT32_MAX) ? static_cast<uint32_t>(waitUs) : UINT32_MAX - 1;
+            }
+            break;
+        }
+    }
+    idleHook_(dueInUs, idleContext_);
+}
+
+size_t UartTransportReplay::available() {
+    advanceClock();
+    if (!release()) {
+        idle();
+        advanceClock();
+        release();
+    }
+    return chunkLeft_;
+}
+
+Result UartTransportReplay::read(uint8_t *buffer, size_t *size) {
+    if (!buffer || !size) {
+        return kInvalidParameters;
+    }
+
+    advanceClock();
+    if (!release()) {
+        idle();
+        advanceClock();
+    }
+
+    size_t count = 0;
+    while (count < *size && release()) {
+        while (count < *size && chunkLeft_ > 0) {
+            buffer[count++] = *chunk_++;
+            chunkLeft_--;
+        }
+    }
+
+    wireReceived(count);
+    *size = count;
+    return kSuccess;
+}
+
+Result UartTransportReplay::write(const uint8_t *buffer, size_t size) {
+    if (!buffer && size > 0) {
+        return kInvalidParameters;
+    }
+
+    advanceClock();
+    wireSent(size);
+    txWritten_ += static_cast<uint32_t>(size);
+
+    for (size_t i = 0; i < size; i++) {
+        CaptureRecordView record;
+        while (txChunkLeft_ == 0 && next(tx_, record)) {
+            if (record.kind == CaptureRecord::Tx) {
+                txChunk_ = record.data;
+                txChunkLeft_ = record.size;
+            }
+        }
+        if (txChunkLeft_ == 0) {
+            // Past the end of the recording
+            txMismatches_ += static_cast<uint32_t>(size - i);
+            break;
+        }
+
+        if (buffer[i] != *txChunk_) {
+            txMismatches_++;
+        }
+        txChunk_++;
+        txChunkLeft_--;
+        txCompared_++;
+    }
+    return kSuccess;
+}
+
+bool UartTransportReplay::finished() {
+    if (chunkLeft_ > 0) {
+        return false;
+    }
+
+    Cursor cursor = rx_;
+    CaptureRecordView record;
+    while (next(cursor, record)) {
+        if (record.kind == CaptureRecord::Rx && record.size > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t UartTransportReplay::durationUs() const {
+    Cursor cursor{kCaptureHeaderSize, 0, 0};
+    CaptureRecordView record;
+    while (next(cursor, record)) {
+    }
+    return cursor.timeUs;
+}
+
+}  // namespace transport
+}  // namespace climate_uart